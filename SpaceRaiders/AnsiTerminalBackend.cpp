@@ -0,0 +1,101 @@
+#include "stdafx.h"
+
+// POSIX terminal backend (Windows console is handled by WinConsoleBackend)
+#ifndef _WIN32
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "AnsiTerminalBackend.h"
+
+ConsoleBackend* CreateConsoleBackend()
+{
+	return new AnsiTerminalBackend(STDOUT_FILENO);
+}
+
+AnsiTerminalBackend::AnsiTerminalBackend(int fd) : m_fd(fd)
+{
+}
+
+bool AnsiTerminalBackend::GetTerminalSize(int fd, int& widthOut, int& heightOut)
+{
+	struct winsize size;
+	if (ioctl(fd, TIOCGWINSZ, &size) != 0)
+	{
+		return false;
+	}
+	widthOut = size.ws_col;
+	heightOut = size.ws_row;
+	return true;
+}
+
+bool AnsiTerminalBackend::Init(int width, int height)
+{
+	m_height = height;
+	// one line more than game screen, so that writing its last cell doesn't scroll the terminal
+	int terminalWidth = 0, terminalHeight = 0;
+	if (GetTerminalSize(m_fd, terminalWidth, terminalHeight) && (terminalWidth < width || terminalHeight < height + 1))
+	{
+		char resize[32];
+		std::snprintf(resize, sizeof(resize), "\x1b[8;%d;%dt", height + 1, width);
+		WriteString(resize);
+		// terminal emulator resizes its window asynchronously
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		GetTerminalSize(m_fd, terminalWidth, terminalHeight);
+		if (terminalWidth < width || terminalHeight < height + 1)
+		{
+			std::printf("Error terminal is %dx%d, it has to be at least %dx%d\n", terminalWidth, terminalHeight, width, height + 1);
+			return false;
+		}
+	}
+	// clear screen
+	WriteString("\x1b[2J");
+	return true;
+}
+
+void AnsiTerminalBackend::MoveCursorHome()
+{
+	WriteString("\x1b[H");
+}
+
+void AnsiTerminalBackend::WriteString(const char* str)
+{
+	Write(str, strlen(str));
+}
+
+void AnsiTerminalBackend::Write(const char* data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t written = write(m_fd, data, size);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return;
+		}
+		data += written;
+		size -= (size_t)written;
+	}
+}
+
+void AnsiTerminalBackend::SetCursorVisibility(bool isVisible)
+{
+	if (isVisible)
+	{
+		char sequence[32];
+		std::snprintf(sequence, sizeof(sequence), "\x1b[%d;1H\x1b[?25h", m_height + 1);
+		WriteString(sequence);
+	}
+	else
+	{
+		WriteString("\x1b[?25l");
+	}
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "ConsoleBackend.h"
+
+// VT100 / ANSI terminal on POSIX file descriptor (standard output by default). Each frame
+// is written with a single write() call (more only if terminal accepts it partially).
+// Terminal size is checked with ioctl(TIOCGWINSZ) (descriptors which are not terminals,
+// i.e. files or /dev/null, are accepted as they are), terminal which is too small is asked
+// to resize itself (xterm window manipulation sequence) before it is reported as an error.
+class AnsiTerminalBackend : public ConsoleBackend
+{
+private:
+	int m_fd;
+	int m_height = 0;
+	// appends sequence to terminal output with single write() call
+	void WriteString(const char* str);
+public:
+	AnsiTerminalBackend(int fd);
+	virtual bool Init(int width, int height);
+	virtual bool IsVirtualTerminal() { return true; }
+	virtual void MoveCursorHome();
+	virtual void Write(const char* data, size_t size);
+	// cursor is shown at the end of the game, so it is also moved below the game screen then
+	virtual void SetCursorVisibility(bool isVisible);
+	// false if fd isn't a terminal
+	static bool GetTerminalSize(int fd, int& widthOut, int& heightOut);
+};
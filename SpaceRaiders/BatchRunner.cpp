@@ -0,0 +1,110 @@
+#include "stdafx.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include "BatchRunner.h"
+
+typedef struct
+{
+	int iterations;
+	bool gameOver;
+	int score;
+	int aliensKilled;
+	double timeInMs;
+} BatchRunResult;
+
+static void WriteResults(std::ostream& out, const std::vector<GameConfig>& runs, const std::vector<BatchRunResult>& results)
+{
+	out << "seed,hardMode,specialFeature,aliensFriendFire,iterations,gameOver,score,aliensKilled,ticksPerSec\n";
+	out << std::fixed << std::setprecision(1);
+	for (size_t i = 0; i < runs.size(); i++)
+	{
+		const GameConfig& config = runs[i];
+		const BatchRunResult& result = results[i];
+		out << config.seed << ',' << config.hardMode << ',' << config.useSpecialFeature << ','
+			<< config.aliensFriendFire << ',' << result.iterations << ',' << result.gameOver << ','
+			<< result.score << ',' << result.aliensKilled << ','
+			<< (result.timeInMs > 0.0 ? result.iterations * 1000.0 / result.timeInMs : 0.0) << '\n';
+	}
+}
+
+int RunBatch(GameConfig& config, Vector2D size)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	std::vector<GameConfig> runs;
+	int variantsCount = config.batchAllVariants ? 8 : 1;
+	for (int variant = 0; variant < variantsCount; variant++)
+	{
+		for (int i = 0; i < config.batchSeedsCount; i++)
+		{
+			GameConfig runConfig = config;
+			runConfig.testRun = true;
+			runConfig.displayGameInfo = false;
+			// games are independent, so they are parallelized as a whole
+			runConfig.workerThreads = 1;
+			runConfig.seed = config.seed + i;
+			if (config.batchAllVariants)
+			{
+				runConfig.hardMode = (variant & 1) != 0;
+				runConfig.useSpecialFeature = (variant & 2) != 0;
+				runConfig.aliensFriendFire = (variant & 4) != 0;
+			}
+			runs.push_back(runConfig);
+		}
+	}
+
+	std::vector<BatchRunResult> results(runs.size());
+	ThreadPool threadPool(config.workerThreads);
+	auto start = Clock::now();
+	// pool hands out games one by one, so threads that got shorter games take more of them
+	threadPool.Run((int)runs.size(), [&](int run)
+	{
+		auto runStart = Clock::now();
+		PlayField world(size, runs[run]);
+		world.SetupGame();
+		while (world.IsStillRunning())
+		{
+			world.Update();
+		}
+		BatchRunResult& result = results[run];
+		result.iterations = (int)world.GetIteration();
+		result.gameOver = world.IsGameOver();
+		result.score = world.GetScore();
+		result.aliensKilled = world.GetAliensKilledCount();
+		result.timeInMs = std::chrono::duration<double, std::milli>(Clock::now() - runStart).count();
+	});
+	double totalTimeInMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	if (config.batchResultsPath != nullptr)
+	{
+		std::ofstream out(config.batchResultsPath);
+		if (!out)
+		{
+			std::cerr << "Can't open " << config.batchResultsPath << std::endl;
+			return -1;
+		}
+		WriteResults(out, runs, results);
+	}
+	else
+	{
+		WriteResults(std::cout, runs, results);
+	}
+
+	long long ticksCount = 0;
+	double scoresSum = 0.0;
+	int gameOversCount = 0;
+	for (auto& it : results)
+	{
+		ticksCount += it.iterations;
+		scoresSum += it.score;
+		gameOversCount += it.gameOver ? 1 : 0;
+	}
+	int runsCount = (int)runs.size();
+	double totalTimeInSec = std::max(totalTimeInMs / 1000.0, 1e-9);
+	std::fprintf(stderr, "Batch of %d games (%d threads): %.2f s, %.1f games/sec, %.1f ticks/sec, mean score %.2f, %d game overs\n",
+		runsCount, threadPool.GetThreadsCount(), totalTimeInMs / 1000.0, runsCount / totalTimeInSec,
+		ticksCount / totalTimeInSec, runsCount > 0 ? scoresSum / runsCount : 0.0, gameOversCount);
+	return 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "PlayField.h"
+
+// Batch mode is available through --batch <seeds count> cmd parameter: headless games
+// for seeds [seed, seed + seeds count) are played concurrently, each game on a single thread
+// of the pool (--threads). Games are played with game config given by cmd parameters or
+// (with --batchAllVariants) with all combinations of hardMode, useSpecialFeature and
+// aliensFriendFire. Result of each game is written as one line of CSV (--batchResults <file>,
+// standard output by default) and summary of whole batch is printed at the end.
+int RunBatch(GameConfig& config, Vector2D size);
@@ -0,0 +1,1406 @@
+#include "stdafx.h"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include "Benchmark.h"
+#include "Randomization.h"
+#include "GameObjects.h"
+#include "CollisionGrid.h"
+#include "CollisionResponse.h"
+#include "PlayField.h"
+#include "ExplodingAlien.h"
+#include "CanvasDiff.h"
+#include "CanvasRasterizer.h"
+#include "FrameRecorder.h"
+#include "FramePlayer.h"
+#include "PlayFieldSnapshot.h"
+#include "LookaheadBot.h"
+#include "ReplayRecorder.h"
+#include "ReplayPlayer.h"
+#include "Renderer.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include "AnsiTerminalBackend.h"
+#endif
+
+typedef std::chrono::high_resolution_clock BenchmarkClock;
+
+// used for populating benchmark worlds and objects sets
+static localRandGen gRandGen(1);
+
+#ifdef SPACERAIDERS_COUNT_ALLOCATIONS
+// Benchmark build only (game build doesn't define it): global operator new is replaced, so that
+// benchmarks can count all heap allocations, not only those of object pools.
+static std::atomic<long long> gHeapAllocationsCount(0);
+
+void* operator new(size_t size)
+{
+	gHeapAllocationsCount.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = std::malloc(size > 0 ? size : 1);
+	if (ptr == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+// gcc warns (when delete is inlined into library code) that memory of operator new is given to free()
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+#if defined(__GNUC__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+void operator delete[](void* ptr) noexcept
+{
+	operator delete(ptr);
+}
+
+// sized variants (C++14) are replaced too, so that no delete of the library gets memory of malloc()
+void operator delete(void* ptr, size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+static long long GetHeapAllocationsCount()
+{
+	return gHeapAllocationsCount.load(std::memory_order_relaxed);
+}
+#endif
+
+static double ElapsedMs(BenchmarkClock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+}
+
+// the same tests as PlayField::HandleCollisions(...) but without
+// collision side effects, so that objects set can be reused between iterations
+static bool NarrowphaseProbe(GameObject& o1, GameObject& o2)
+{
+	if (!CanObjectsCollide(o1.GetType(), o2.GetType()))
+	{
+		return false;
+	}
+	float toi;
+	Vector2D contact;
+	return PlayField::SweepObjects(o1.GetPosPrev(), o1.GetPos(), o2.GetPosPrev(), o2.GetPos(), toi, contact);
+}
+
+// Previous PlayField collision map (fixed 20x20 hash of game cells),
+// kept here only as a reference point for CollisionGrid
+class LegacyCollisionMap
+{
+	static const int COLLISION_MAP_X_CELLS = 20;
+	static const int COLLISION_MAP_Y_CELLS = 20;
+	static const int COLLISION_MAP_SIZE = COLLISION_MAP_X_CELLS * COLLISION_MAP_Y_CELLS;
+	std::vector<std::pair<Vector2D, GameObjPtr>> m_collisionMap[COLLISION_MAP_SIZE];
+public:
+	// returns number of narrowphase candidate pairs
+	long long Run(const std::vector<GameObjPtr>& objects, int& hitsOut)
+	{
+		long long pairs = 0;
+		for (int i = 0; i < COLLISION_MAP_SIZE; i++)
+		{
+			m_collisionMap[i].clear();
+		}
+		for (auto obj : objects)
+		{
+			// collision points used to be object current and previous positions
+			Vector2D points[2] = { obj->GetPos(), obj->GetPosPrev() };
+			for (int i = 0; i < (obj->GetPos().IntCmp(obj->GetPosPrev()) ? 1 : 2); i++)
+			{
+				auto& p = points[i];
+				if (p.x < 0 || p.y < 0)
+				{
+					continue;
+				}
+				auto& bucket = m_collisionMap[((int)p.y % COLLISION_MAP_Y_CELLS) * COLLISION_MAP_X_CELLS
+					+ ((int)p.x % COLLISION_MAP_X_CELLS)];
+				for (auto& it : bucket)
+				{
+					pairs++;
+					hitsOut += NarrowphaseProbe(*obj, *it.second) ? 1 : 0;
+				}
+				bucket.push_back({ p, obj });
+			}
+		}
+		return pairs;
+	}
+};
+
+static long long RunCollisionGrid(CollisionGrid& grid, const std::vector<GameObjPtr>& objects, int& hitsOut)
+{
+	long long pairs = 0;
+	grid.Clear();
+	for (int objIndex = 0; objIndex < (int)objects.size(); objIndex++)
+	{
+		GameObjPtr obj = objects[objIndex];
+		grid.AddSegment(obj->GetPosPrev(), obj->GetPos(), objIndex, obj->GetHandle(), obj->GetType(), gCollisionTable.pairMasks[obj->GetType()]);
+	}
+	grid.Build();
+	for (int c = 0; c < grid.GetCellsCount(); c++)
+	{
+		auto& cell = grid.GetCell(c);
+		if (!CollisionGrid::IsCellColliding(cell))
+		{
+			continue;
+		}
+		int count = cell.count;
+		auto entries = grid.GetCellEntries(cell);
+		for (int j = 1; j < count; j++)
+		{
+			for (int i = 0; i < j; i++)
+			{
+				pairs++;
+				hitsOut += NarrowphaseProbe(*objects[entries[j]], *objects[entries[i]]) ? 1 : 0;
+			}
+		}
+	}
+	return pairs;
+}
+
+static void CreateBenchmarkObjects(std::vector<GameObjPtr>& objects, int objectsCount, int sizeX, int sizeY)
+{
+	objects.reserve(objectsCount);
+	for (int i = 0; i < objectsCount; i++)
+	{
+		Vector2D pos((float)getRandInt(gRandGen, 0, sizeX - 1), (float)getRandInt(gRandGen, 1, sizeY - 2));
+		// lasers are spawned relatively to their parent position
+		Alien parent(pos, 0.f);
+		switch (getRandInt(gRandGen, 0, 3))
+		{
+		case 0: objects.push_back(new Alien(pos, 0.02f)); break;
+		case 1: objects.push_back(new WallBlock(pos)); break;
+		case 2: objects.push_back(new AlienLaser(&parent)); break;
+		case 3: objects.push_back(new PlayerLaser(&parent)); break;
+		}
+	}
+}
+
+// Broadphase benchmark: mix of aliens, wall blocks and lasers randomly placed on the field.
+// Collision side effects are not applied (see NarrowphaseProbe(...)) so the same objects set
+// is used in each iteration.
+// Field is either default 80x29 one or it is scaled with objects count (~4 cells per object).
+static void BenchmarkCollisionBroadphase(bool scaleField)
+{
+	const int objectCounts[] = { 1000, 10000, 100000 };
+	std::printf("Collision broadphase (%s field):\n", scaleField ? "scaled" : "80x29");
+	std::printf("%10s %12s %14s %14s %14s %14s %10s\n", "objects", "field", "legacy ms/tick", "grid ms/tick",
+		"legacy pairs", "grid pairs", "hits");
+	for (int objectsCount : objectCounts)
+	{
+		int sizeX = 80, sizeY = 29;
+		if (scaleField)
+		{
+			sizeX = sizeY = (int)sqrt(4.f * objectsCount);
+		}
+		std::vector<GameObjPtr> objects;
+		CreateBenchmarkObjects(objects, objectsCount, sizeX, sizeY);
+		const int ticks = std::max(5, 200000 / objectsCount);
+		LegacyCollisionMap *legacy = new LegacyCollisionMap();
+		CollisionGrid grid(sizeX, sizeY);
+		// both broadphases have to report the same number of colliding pairs
+		int legacyHits = 0, gridHits = 0;
+		long long legacyPairs = 0, gridPairs = 0;
+
+		auto start = BenchmarkClock::now();
+		for (int t = 0; t < ticks; t++)
+		{
+			legacyHits = 0;
+			legacyPairs = legacy->Run(objects, legacyHits);
+		}
+		double legacyMs = ElapsedMs(start) / ticks;
+
+		start = BenchmarkClock::now();
+		for (int t = 0; t < ticks; t++)
+		{
+			gridHits = 0;
+			gridPairs = RunCollisionGrid(grid, objects, gridHits);
+		}
+		double gridMs = ElapsedMs(start) / ticks;
+
+		char field[32];
+		std::sprintf(field, "%dx%d", sizeX, sizeY);
+		std::printf("%10d %12s %14.3f %14.3f %14lld %14lld %10d%s\n", objectsCount, field, legacyMs, gridMs,
+			legacyPairs, gridPairs, gridHits, legacyHits == gridHits ? "" : " (MISMATCH)");
+		delete legacy;
+		for (auto obj : objects)
+		{
+			delete obj;
+		}
+	}
+}
+
+// Previous collision dispatch (virtual CheckCollision(...) -> OnObjectStriked(...) chain
+// with per-object collision bitmaps), kept here only as a reference point for gCollisionTable.
+// Strikes are counted instead of being applied.
+class LegacyDispatchObject
+{
+protected:
+	UINT32 m_collisionTypeBitmap;
+	RaiderObjectTypeId m_objType;
+	int m_strikeForce;
+	virtual void OnObjectStriked(LegacyDispatchObject& attacker, int& strikesOut) { strikesOut++; }
+public:
+	LegacyDispatchObject(GameObject& obj) : m_objType(obj.GetType()), m_strikeForce(obj.GetStrikeForce())
+	{
+		m_collisionTypeBitmap = gCollisionTable.collidingTypes[m_objType];
+		// (StrongAlienLaser constructor used to unset player lasers bit)
+		if (m_objType == RI_AlienLaser && CollisionResponse::IsStrongLaser(obj))
+		{
+			m_collisionTypeBitmap &= ~(1U << RI_PlayerLaser);
+		}
+	}
+	virtual ~LegacyDispatchObject() {}
+	virtual void CheckCollision(LegacyDispatchObject& other, int& strikesOut)
+	{
+		if (m_collisionTypeBitmap & (1U << other.m_objType))
+		{
+			OnObjectStriked(other, strikesOut);
+		}
+	}
+	RaiderObjectTypeId GetType() { return m_objType; }
+	int GetStrikeForce() { return m_strikeForce; }
+};
+
+class LegacyDispatchLaser : public LegacyDispatchObject
+{
+protected:
+	void OnObjectStriked(LegacyDispatchObject& attacker, int& strikesOut)
+	{
+		if (attacker.GetType() != m_objType)
+		{
+			LegacyDispatchObject::OnObjectStriked(attacker, strikesOut);
+		}
+	}
+public:
+	LegacyDispatchLaser(GameObject& obj) : LegacyDispatchObject(obj) {}
+};
+
+class LegacyDispatchWallBlock : public LegacyDispatchObject
+{
+protected:
+	void OnObjectStriked(LegacyDispatchObject& attacker, int& strikesOut)
+	{
+		if (attacker.GetType() != RI_AlienLaser || attacker.GetStrikeForce() >= CollisionResponse::StrongLaserStrikeForce)
+		{
+			LegacyDispatchObject::OnObjectStriked(attacker, strikesOut);
+		}
+	}
+public:
+	LegacyDispatchWallBlock(GameObject& obj) : LegacyDispatchObject(obj) {}
+};
+
+static int gDispatchStrikes = 0;
+
+static void CountStrike(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+{
+	gDispatchStrikes++;
+}
+
+static void CountStrikeIfStrongLaser(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+{
+	gDispatchStrikes += CollisionResponse::IsStrongLaser(attacker) ? 1 : 0;
+}
+
+static void CountStrikeIfNotStrongLaser(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+{
+	gDispatchStrikes += CollisionResponse::IsStrongLaser(target) ? 0 : 1;
+}
+
+// gCollisionTable with every handler replaced by its counting equivalent
+// (friend fire is enabled in legacy objects, so it is treated as usual strike)
+static CollisionTable BuildCountingCollisionTable()
+{
+	CollisionTable table = gCollisionTable;
+	for (int target = 0; target < RI_End; target++)
+	{
+		for (int attacker = 0; attacker < RI_End; attacker++)
+		{
+			auto& response = table.responses[target][attacker];
+			if (response == &CollisionResponse::StrikeIfStrongLaser)
+				response = &CountStrikeIfStrongLaser;
+			else if (response == &CollisionResponse::StrikeIfNotStrongLaser)
+				response = &CountStrikeIfNotStrongLaser;
+			else if (response != nullptr)
+				response = &CountStrike;
+		}
+	}
+	return table;
+}
+
+// Dispatch benchmark: cost of handling one candidate pair (narrowphase excluded),
+// legacy double virtual dispatch vs. single mask test + table lookup as in ResolveCollision(...)
+static void BenchmarkCollisionDispatch()
+{
+	const int objectsCount = 1000;
+	const int pairsCount = 1000000;
+	std::printf("Collision dispatch (%d pairs):\n", pairsCount);
+	std::printf("%14s %14s %14s %14s\n", "legacy ns/pair", "table ns/pair", "legacy strikes", "table strikes");
+	std::vector<GameObjPtr> objects;
+	std::vector<LegacyDispatchObject*> legacyObjects;
+	for (int i = 0; i < objectsCount; i++)
+	{
+		Vector2D pos((float)getRandInt(gRandGen, 0, 79), (float)getRandInt(gRandGen, 1, 27));
+		Alien parent(pos, 0.f);
+		switch (getRandInt(gRandGen, 0, 5))
+		{
+		case 0: objects.push_back(new Alien(pos, 0.02f)); break;
+		case 1: objects.push_back(new WallBlock(pos)); break;
+		case 2: objects.push_back(new AlienLaser(&parent)); break;
+		case 3: objects.push_back(new StrongAlienLaser(&parent)); break;
+		case 4: objects.push_back(new PlayerLaser(&parent)); break;
+		case 5: objects.push_back(new Explosion(pos)); break;
+		}
+		GameObject& obj = *objects.back();
+		if (obj.GetType() == RI_PlayerLaser || obj.GetType() == RI_AlienLaser)
+			legacyObjects.push_back(new LegacyDispatchLaser(obj));
+		else if (obj.GetType() == RI_WallBlock)
+			legacyObjects.push_back(new LegacyDispatchWallBlock(obj));
+		else
+			legacyObjects.push_back(new LegacyDispatchObject(obj));
+	}
+	std::vector<std::pair<int, int>> pairs(pairsCount);
+	for (auto& it : pairs)
+	{
+		it = { getRandInt(gRandGen, 0, objectsCount - 1), getRandInt(gRandGen, 0, objectsCount - 1) };
+	}
+	GameConfig config = { true, 0, false, false, false, true, 1, 0, false, 1 };
+	PlayField world(Vector2D(80, 30), config);
+	const CollisionTable table = BuildCountingCollisionTable();
+	Vector2D point;
+
+	int legacyStrikes = 0;
+	auto start = BenchmarkClock::now();
+	for (auto& it : pairs)
+	{
+		legacyObjects[it.first]->CheckCollision(*legacyObjects[it.second], legacyStrikes);
+		legacyObjects[it.second]->CheckCollision(*legacyObjects[it.first], legacyStrikes);
+	}
+	double legacyNs = ElapsedMs(start) * 1e6 / pairsCount;
+
+	gDispatchStrikes = 0;
+	start = BenchmarkClock::now();
+	for (auto& it : pairs)
+	{
+		GameObject& o1 = *objects[it.first];
+		GameObject& o2 = *objects[it.second];
+		if ((table.pairMasks[o1.GetType()] & (1U << o2.GetType())) == 0)
+		{
+			continue;
+		}
+		CollisionResponseFunc response = table.responses[o1.GetType()][o2.GetType()];
+		if (response != nullptr)
+		{
+			response(o1, o2, world, point);
+		}
+		response = table.responses[o2.GetType()][o1.GetType()];
+		if (response != nullptr)
+		{
+			response(o2, o1, world, point);
+		}
+	}
+	double tableNs = ElapsedMs(start) * 1e6 / pairsCount;
+
+	std::printf("%14.2f %14.2f %14d %14d%s\n", legacyNs, tableNs, legacyStrikes, gDispatchStrikes,
+		legacyStrikes == gDispatchStrikes ? "" : " (MISMATCH)");
+	for (int i = 0; i < objectsCount; i++)
+	{
+		delete objects[i];
+		delete legacyObjects[i];
+	}
+}
+
+// FNV-1a hash of all objects types and positions, used to compare game state between runs
+static UINT32 HashWorldState(PlayField& world)
+{
+	UINT32 hash = 2166136261U;
+	auto addValue = [&hash](const void *data, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ ((const unsigned char*)data)[i]) * 16777619U;
+		}
+	};
+	for (int type = 0; type < RI_End; type++)
+	{
+		EntityGroup& group = world.GetEntityStore().GetGroup((RaiderObjectTypeId)type);
+		for (int i = 0; i < group.Size(); i++)
+		{
+			addValue(&type, sizeof(type));
+			addValue(&group.sprite[i], sizeof(group.sprite[i]));
+			addValue(&group.pos[i], sizeof(Vector2D));
+		}
+	}
+	addValue(&world.AlienLasers, sizeof(world.AlienLasers));
+	addValue(&world.PlayerLasers, sizeof(world.PlayerLasers));
+	return hash;
+}
+
+// Parallel update benchmark: stress configuration with thousands of aliens on a big field,
+// the same seed is run with different number of update threads and it has to end up
+// in exactly the same state.
+static void BenchmarkParallelUpdate()
+{
+	const int aliensCount = 20000;
+	const int ticks = 200;
+	const int sizeX = 400, sizeY = 400;
+	// at least 4 threads are used even on smaller machines so that determinism is always verified
+	int maxThreads = std::max((int)std::thread::hardware_concurrency(), 4);
+	std::printf("Parallel update (%d aliens, %dx%d field, %d ticks):\n", aliensCount, sizeX, sizeY, ticks);
+	std::printf("%10s %10s %10s %12s\n", "threads", "ms/tick", "objects", "state hash");
+	UINT32 referenceHash = 0;
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		gRandGen.seed(1);
+		GameConfig config = { true, 0, false, false, false, true, 1, 0, false, threads };
+		PlayField world(Vector2D((float)sizeX, (float)sizeY), config);
+		world.MaxAlienLasers = aliensCount / 10;
+		world.AddPlayerObject(Vector2D(sizeX / 2.f, sizeY - 2.f));
+		for (int i = 0; i < aliensCount; i++)
+		{
+			world.AddObject(new Alien(Vector2D((float)getRandInt(gRandGen, 0, sizeX - 1), (float)getRandInt(gRandGen, 0, sizeY / 2)), 0.02f));
+		}
+		// first update only moves newly added objects into the play field
+		world.Update();
+		auto start = BenchmarkClock::now();
+		for (int t = 0; t < ticks; t++)
+		{
+			world.Update();
+		}
+		double ms = ElapsedMs(start) / ticks;
+		UINT32 hash = HashWorldState(world);
+		if (threads == 1)
+		{
+			referenceHash = hash;
+		}
+		std::printf("%10d %10.3f %10d     %08x%s\n", threads, ms, world.GetEntityStore().GetSize(), hash,
+			hash == referenceHash ? "" : " (MISMATCH)");
+		if (threads < maxThreads && threads * 2 > maxThreads)
+		{
+			threads = maxThreads / 2;
+		}
+	}
+}
+
+// Object pools benchmark: lasers, explosions and explosion cells are spawned and released
+// all the time, after warm up pools should have enough free slots so that following
+// ticks don't take any memory from the heap. In benchmark build (SPACERAIDERS_COUNT_ALLOCATIONS
+// defined) all operator new calls are counted as well (objects which aren't pooled, growing
+// arrays), steady state ticks shouldn't make any.
+static void BenchmarkObjectPools()
+{
+	const int aliensCount = 2000;
+	const int explodingAliensCount = 200;
+	// more than one round of TickScheduler wheel, so that all its buckets have grown
+	const int warmUpTicks = 1100;
+	const int ticks = 300;
+	const int sizeX = 300, sizeY = 300;
+	ObjectPool* pools[] = { &Laser::GetPool(), &Explosion::GetPool(), &EAExplosionCell::GetPool() };
+	const int poolsCount = sizeof(pools) / sizeof(pools[0]);
+
+	gRandGen.seed(1);
+	GameConfig config = { true, 0, false, false, false, true, 1, 0, false, 1 };
+	PlayField world(Vector2D((float)sizeX, (float)sizeY), config);
+	world.MaxAlienLasers = aliensCount / 10;
+	// there is no player, so that game doesn't end before measured ticks
+	for (int i = 0; i < aliensCount + explodingAliensCount; i++)
+	{
+		Vector2D pos((float)getRandInt(gRandGen, 0, sizeX - 1), (float)getRandInt(gRandGen, 0, sizeY / 2));
+		world.AddObject(i < aliensCount ? new Alien(pos, 0.02f) : new ExplodingAlien(pos, 0.06f));
+	}
+	for (int t = 0; t < warmUpTicks; t++)
+	{
+		world.Update();
+	}
+	long long allocations[poolsCount];
+	int heapAllocations[poolsCount];
+	for (int i = 0; i < poolsCount; i++)
+	{
+		allocations[i] = pools[i]->GetAllocationsCount();
+		heapAllocations[i] = pools[i]->GetHeapAllocationsCount();
+	}
+#ifdef SPACERAIDERS_COUNT_ALLOCATIONS
+	long long allHeapAllocations = GetHeapAllocationsCount();
+#endif
+	auto start = BenchmarkClock::now();
+	for (int t = 0; t < ticks; t++)
+	{
+		world.Update();
+	}
+	double ms = ElapsedMs(start) / ticks;
+#ifdef SPACERAIDERS_COUNT_ALLOCATIONS
+	allHeapAllocations = GetHeapAllocationsCount() - allHeapAllocations;
+#endif
+
+	std::printf("Object pools (%d aliens, %d exploding aliens, %d ticks after %d warm up ticks, %.3f ms/tick):\n",
+		aliensCount, explodingAliensCount, ticks, warmUpTicks, ms);
+	std::printf("%16s %12s %16s %12s\n", "pool", "allocations", "heap allocations", "capacity");
+	for (int i = 0; i < poolsCount; i++)
+	{
+		std::printf("%16s %12lld %16d %12d\n", pools[i]->GetName(),
+			pools[i]->GetAllocationsCount() - allocations[i],
+			pools[i]->GetHeapAllocationsCount() - heapAllocations[i],
+			pools[i]->GetCapacity());
+	}
+#ifdef SPACERAIDERS_COUNT_ALLOCATIONS
+	// everything else (i.e. objects which aren't pooled and growing arrays) is counted here
+	std::printf("%16s %12s %16lld (all operator new calls in measured ticks)\n", "total", "", allHeapAllocations);
+#endif
+}
+
+// Random draws benchmark and concurrent worlds check: each play field has its own WorldRandom,
+// so worlds updated at the same time on different threads have to end up in exactly the same
+// state as when each of them runs alone.
+static void BenchmarkWorldRandom()
+{
+	const int drawsCount = 10000000;
+	std::default_random_engine engine(1);
+	float sum = 0.f;
+	auto start = BenchmarkClock::now();
+	for (int i = 0; i < drawsCount; i++)
+	{
+		floatRand tmp(0.f, 1.f);
+		sum += tmp(engine);
+	}
+	double engineNs = ElapsedMs(start) * 1e6 / drawsCount;
+	WorldRandom worldRandom(1);
+	start = BenchmarkClock::now();
+	for (int i = 0; i < drawsCount; i++)
+	{
+		// a new stream per draw is the worst case (objects take a few draws from their streams)
+		sum += worldRandom.GetStream((UINT32)i, RP_AlienFire).GetFloat(0.f, 1.f);
+	}
+	double streamNs = ElapsedMs(start) * 1e6 / drawsCount;
+	RandomStream stream = worldRandom.GetStream(WorldRandom::WorldEntity, RP_SpawnWave);
+	start = BenchmarkClock::now();
+	for (int i = 0; i < drawsCount; i++)
+	{
+		sum += stream.GetFloat(0.f, 1.f);
+	}
+	double sequentialNs = ElapsedMs(start) * 1e6 / drawsCount;
+	std::printf("Random draws (%d draws, checksum %.0f):\n", drawsCount, sum);
+	std::printf("%22s %22s %22s\n", "engine+distribution ns", "philox new stream ns", "philox one stream ns");
+	std::printf("%22.2f %22.2f %22.2f\n", engineNs, streamNs, sequentialNs);
+
+	const int worldsCount = 4;
+	const int aliensCount = 2000;
+	const int ticks = 300;
+	const int sizeX = 200, sizeY = 200;
+	auto runWorld = [&](int seed, UINT32& hashOut)
+	{
+		GameConfig config = { true, 0, false, false, false, true, seed, 0, false, 1 };
+		PlayField world(Vector2D((float)sizeX, (float)sizeY), config);
+		world.MaxAlienLasers = aliensCount / 10;
+		// objects are placed the same way in each world, worlds differ only in their seed
+		localRandGen gen(1);
+		for (int i = 0; i < aliensCount; i++)
+		{
+			world.AddObject(new Alien(Vector2D((float)getRandInt(gen, 0, sizeX - 1), (float)getRandInt(gen, 0, sizeY / 2)), 0.02f));
+		}
+		for (int t = 0; t < ticks; t++)
+		{
+			world.Update();
+		}
+		hashOut = HashWorldState(world);
+	};
+	UINT32 aloneHashes[worldsCount];
+	UINT32 concurrentHashes[worldsCount];
+	for (int i = 0; i < worldsCount; i++)
+	{
+		runWorld(i + 1, aloneHashes[i]);
+	}
+	std::vector<std::thread> threads;
+	for (int i = 0; i < worldsCount; i++)
+	{
+		threads.push_back(std::thread(runWorld, i + 1, std::ref(concurrentHashes[i])));
+	}
+	for (auto& it : threads)
+	{
+		it.join();
+	}
+	std::printf("Concurrent worlds (%d worlds, %d aliens, %d ticks):\n", worldsCount, aliensCount, ticks);
+	std::printf("%10s %12s %12s\n", "seed", "alone", "concurrent");
+	for (int i = 0; i < worldsCount; i++)
+	{
+		std::printf("%10d     %08x     %08x%s\n", i + 1, aloneHashes[i], concurrentHashes[i],
+			aloneHashes[i] == concurrentHashes[i] ? "" : " (MISMATCH)");
+	}
+}
+
+// two-sample Kolmogorov-Smirnov statistic (largest distance between empirical CDFs)
+static double KolmogorovSmirnov(std::vector<UINT32>& a, std::vector<UINT32>& b)
+{
+	std::sort(a.begin(), a.end());
+	std::sort(b.begin(), b.end());
+	size_t i = 0, j = 0;
+	double d = 0.0;
+	while (i < a.size() && j < b.size())
+	{
+		// all equal values are stepped over at once (distributions are discrete)
+		UINT32 value = std::min(a[i], b[j]);
+		while (i < a.size() && a[i] == value) i++;
+		while (j < b.size() && b[j] == value) j++;
+		d = std::max(d, std::abs((double)i / a.size() - (double)j / b.size()));
+	}
+	return d;
+}
+
+static void PrintDistributionsComparison(const char *name, std::vector<UINT32>& legacy, std::vector<UINT32>& scheduled)
+{
+	auto stats = [](std::vector<UINT32>& samples, double& meanOut, double& stdDevOut)
+	{
+		double sum = 0.0, sum2 = 0.0;
+		for (auto it : samples)
+		{
+			sum += it;
+			sum2 += (double)it * it;
+		}
+		meanOut = sum / samples.size();
+		stdDevOut = sqrt(sum2 / samples.size() - meanOut * meanOut);
+	};
+	double legacyMean, legacyStdDev, scheduledMean, scheduledStdDev;
+	stats(legacy, legacyMean, legacyStdDev);
+	stats(scheduled, scheduledMean, scheduledStdDev);
+	double d = KolmogorovSmirnov(legacy, scheduled);
+	// critical value for significance level 0.01
+	double dCritical = 1.628 * sqrt((double)(legacy.size() + scheduled.size()) / ((double)legacy.size() * scheduled.size()));
+	std::printf("%24s %9.2f %9.2f %9.2f %9.2f %9.4f %9.4f %s\n", name, legacyMean, scheduledMean,
+		legacyStdDev, scheduledStdDev, d, dCritical, d < dCritical ? "PASS" : "FAIL");
+}
+
+// Alien scheduling check: number of iterations until alien fires and until it tries to transform
+// are sampled once by the scheduler, their distributions have to be the same as distributions
+// of the same numbers produced by checks done each iteration (as aliens did before).
+static void BenchmarkAlienScheduling()
+{
+	const int samplesCount = 200000;
+	const float maxEnergyPerTick = 0.02f;
+	std::default_random_engine engine(1);
+	WorldRandom worldRandom(1);
+	std::printf("Alien scheduling (%d samples, Kolmogorov-Smirnov test at 0.01 level):\n", samplesCount);
+	std::printf("%24s %9s %9s %9s %9s %9s %9s\n", "iterations until", "mean old", "mean new", "sd old", "sd new", "D", "D crit");
+	float fireProbabilities[] = { 0.5f, 0.75f };
+	for (float probability : fireProbabilities)
+	{
+		std::vector<UINT32> legacy, scheduled;
+		for (int i = 0; i < samplesCount; i++)
+		{
+			UINT32 ticks = 1;
+			floatRand fireCheck(0.f, 1.f);
+			while (fireCheck(engine) >= probability)
+			{
+				ticks++;
+			}
+			legacy.push_back(ticks);
+			RandomStream random = worldRandom.GetStream((UINT32)i, RP_AlienFire);
+			scheduled.push_back(Alien::SampleTicksToFire(random, probability));
+		}
+		char name[64];
+		std::sprintf(name, "fire (p = %.2f)", probability);
+		PrintDistributionsComparison(name, legacy, scheduled);
+	}
+	float transformEnergies[] = { 1.f, 3.f, 5.f };
+	for (float energy : transformEnergies)
+	{
+		std::vector<UINT32> legacy, scheduled;
+		for (int i = 0; i < samplesCount; i++)
+		{
+			UINT32 ticks = 0;
+			float sum = 0.f;
+			floatRand energyGain(0.f, maxEnergyPerTick);
+			while (sum < energy)
+			{
+				sum += energyGain(engine);
+				ticks++;
+			}
+			legacy.push_back(ticks);
+			RandomStream random = worldRandom.GetStream((UINT32)i, RP_AlienTransform);
+			scheduled.push_back(Alien::SampleTicksToTransformAttempt(random, energy, maxEnergyPerTick));
+		}
+		char name[64];
+		std::sprintf(name, "transform (energy %.0f)", energy);
+		PrintDistributionsComparison(name, legacy, scheduled);
+	}
+}
+
+// render list which Renderer used before CanvasRasterizer: an object with virtual
+// GetSpriteCharsArray() placement-new'ed into a union for each item, items copied by value
+namespace LegacyRenderList
+{
+	class ItemBase
+	{
+	public:
+		ItemBase(const Vector2D& iPos) : m_pos(iPos) {}
+		Vector2D m_pos;
+		virtual const char* GetSpriteCharsArray() = 0;
+	};
+
+	class ItemSprite : public ItemBase
+	{
+	protected:
+		char m_sprite[2];
+	public:
+		ItemSprite(const Vector2D& iPos, char iSprite) : ItemBase(iPos)
+		{
+			m_sprite[0] = iSprite;
+			m_sprite[1] = 0;
+		}
+		virtual const char* GetSpriteCharsArray() { return m_sprite; }
+	};
+
+	class ItemString : public ItemBase
+	{
+	protected:
+		const char *m_str;
+	public:
+		ItemString(const Vector2D& iPos, const char *str) : ItemBase(iPos), m_str(str) {}
+		virtual const char* GetSpriteCharsArray() { return m_str; }
+	};
+
+	typedef union _ItemUnionBuffer
+	{
+		char reserved1[sizeof(ItemSprite)];
+		char reserved2[sizeof(ItemString)];
+		_ItemUnionBuffer() {}
+	} ItemUnion;
+
+	static void Draw(unsigned char* canvas, int width, int height, const WorldSnapshot& snapshot, std::vector<ItemUnion>& renderList)
+	{
+		renderList.resize(snapshot.sprites.size() + snapshot.stringsCount);
+		int i = 0;
+		for (auto& it : snapshot.sprites)
+		{
+			new(&renderList[i++])ItemSprite(Vector2D(it.x, it.y), it.glyph);
+		}
+		for (int s = 0; s < snapshot.stringsCount; s++)
+		{
+			const SnapshotString& str = snapshot.strings[s];
+			new(&renderList[i++])ItemString(Vector2D(str.x, str.y), str.text.c_str());
+		}
+		for (auto ri : renderList)
+		{
+			ItemBase *item = (ItemBase*)&ri;
+			if (item->m_pos.x < 0 || item->m_pos.y < 0)
+			{
+				continue;
+			}
+			int x = int(item->m_pos.x);
+			int y = int(item->m_pos.y);
+			if (y >= height)
+			{
+				continue;
+			}
+			for (auto renderChars = item->GetSpriteCharsArray(); *renderChars != 0 && x < width; renderChars++, x++)
+			{
+				canvas[x + width * y] = *renderChars;
+			}
+		}
+	}
+}
+
+// CanvasRasterizer against the legacy render list, both canvases have to be the same
+// (sprites overlap each other and strings overlap sprites, so write order is checked too)
+static void BenchmarkRasterizer()
+{
+	const int width = 1000, height = 400;
+	const int spritesCounts[] = { 1000, 10000, 100000 };
+	const int framesCount = 200;
+	std::vector<unsigned char> canvas(width * height), legacyCanvas(width * height);
+	std::vector<LegacyRenderList::ItemUnion> renderList;
+	WorldSnapshot snapshot;
+	std::printf("Rasterizer (%dx%d canvas, %d frames):\n", width, height, framesCount);
+	std::printf("%14s %14s %14s %10s %10s\n", "sprites", "direct us", "render list us", "speedup", "check");
+	for (int spritesCount : spritesCounts)
+	{
+		snapshot.Clear();
+		for (int i = 0; i < spritesCount; i++)
+		{
+			snapshot.sprites.push_back({ (short)getRandInt(gRandGen, 0, width - 1), (short)getRandInt(gRandGen, 0, height - 1),
+				(char)getRandInt(gRandGen, 'A', 'Z') });
+		}
+		for (int i = 0; i < 64; i++)
+		{
+			// some of strings are clipped by the right edge
+			snapshot.AddString((short)getRandInt(gRandGen, 0, width - 1), (short)getRandInt(gRandGen, 0, height - 1),
+				std::string(getRandInt(gRandGen, 1, 40), (char)getRandInt(gRandGen, 'a', 'z')));
+		}
+		auto start = BenchmarkClock::now();
+		for (int frame = 0; frame < framesCount; frame++)
+		{
+			std::fill(canvas.begin(), canvas.end(), ' ');
+			CanvasRasterizer::Draw(canvas.data(), width, height, snapshot);
+		}
+		double directUs = ElapsedMs(start) * 1e3 / framesCount;
+		start = BenchmarkClock::now();
+		for (int frame = 0; frame < framesCount; frame++)
+		{
+			std::fill(legacyCanvas.begin(), legacyCanvas.end(), ' ');
+			LegacyRenderList::Draw(legacyCanvas.data(), width, height, snapshot, renderList);
+		}
+		double legacyUs = ElapsedMs(start) * 1e3 / framesCount;
+		std::printf("%14d %14.2f %14.2f %9.2fx %10s\n", spritesCount, directUs, legacyUs, legacyUs / directUs,
+			canvas == legacyCanvas ? "PASS" : "FAIL");
+	}
+}
+
+// CanvasDiff::Build(...) with plain byte by byte comparisons
+static void BuildCanvasDiffScalar(const unsigned char* canvas, const unsigned char* prevCanvas, int width, int height,
+	std::vector<char>& out)
+{
+	auto findDifference = [](const unsigned char* a, const unsigned char* b, int from, int size)
+	{
+		for (; from < size && a[from] == b[from]; from++);
+		return from;
+	};
+	auto findEquality = [](const unsigned char* a, const unsigned char* b, int from, int size)
+	{
+		for (; from < size && a[from] != b[from]; from++);
+		return from;
+	};
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = canvas + y * width;
+		const unsigned char* prevRow = prevCanvas + y * width;
+		int x = findDifference(row, prevRow, 0, width);
+		while (x < width)
+		{
+			int end = findEquality(row, prevRow, x, width);
+			int next = findDifference(row, prevRow, end, width);
+			while (next < width && next - end < CanvasDiff::MergeGap)
+			{
+				end = findEquality(row, prevRow, next, width);
+				next = findDifference(row, prevRow, end, width);
+			}
+			CanvasDiff::AppendCursorPosition(x, y, out);
+			out.insert(out.end(), row + x, row + end);
+			x = next;
+		}
+	}
+}
+
+static void BenchmarkCanvasDiff()
+{
+	const int width = 80, height = 29;
+	const int framesCount = 20000;
+	const int changedCellsCounts[] = { 0, 20, 100, 500 };
+	std::vector<unsigned char> prevCanvas(width * height), canvas(width * height);
+	std::vector<char> out, outScalar;
+	std::printf("Canvas diff (%dx%d, %d frames):\n", width, height, framesCount);
+	std::printf("%14s %14s %14s %14s %10s\n", "changed cells", "bytes/frame", "sse2 us", "scalar us", "check");
+	for (int changedCells : changedCellsCounts)
+	{
+		// sprites are scattered over the screen, like after a game iteration
+		for (int i = 0; i < width * height; i++)
+		{
+			prevCanvas[i] = canvas[i] = getRandInt(gRandGen, 0, 20) == 0 ? 'X' : ' ';
+		}
+		for (int i = 0; i < changedCells; i++)
+		{
+			canvas[getRandInt(gRandGen, 0, width * height - 1)] ^= 1;
+		}
+		bool isSame = true;
+		size_t bytes = 0;
+		auto start = BenchmarkClock::now();
+		for (int frame = 0; frame < framesCount; frame++)
+		{
+			out.clear();
+			CanvasDiff::Build(canvas.data(), prevCanvas.data(), width, height, width * height * 2, out);
+			bytes += out.size();
+		}
+		double diffUs = ElapsedMs(start) * 1e3 / framesCount;
+		start = BenchmarkClock::now();
+		for (int frame = 0; frame < framesCount; frame++)
+		{
+			outScalar.clear();
+			BuildCanvasDiffScalar(canvas.data(), prevCanvas.data(), width, height, outScalar);
+			bytes -= outScalar.size();
+		}
+		double scalarUs = ElapsedMs(start) * 1e3 / framesCount;
+		isSame = bytes == 0 && out == outScalar;
+		std::printf("%14d %14d %14.3f %14.3f %10s\n", changedCells, (int)out.size(), diffUs, scalarUs, isSame ? "PASS" : "FAIL");
+	}
+}
+
+// static sprites (like wall blocks), sprites moving down the screen (like aliens and lasers)
+// and info string changing every frame
+static void FillTerminalBenchmarkSnapshot(WorldSnapshot& snapshot, int frame, int width, int height,
+	int spritesCount, int movingSpritesCount)
+{
+	snapshot.Clear();
+	for (int i = 0; i < spritesCount; i++)
+	{
+		int y = i < movingSpritesCount ? i * 31 + frame : i * 31;
+		snapshot.sprites.push_back({ (short)((i * 7919) % width), (short)(y % (height - 1)), i < movingSpritesCount ? '|' : '#' });
+	}
+	char info[64];
+	std::sprintf(info, "Iteration: % 8d", frame);
+	snapshot.AddString(4, (short)(height - 1), info);
+}
+
+
+// frames are recorded like by the game (recorder thread compresses them), then the recording is
+// played back sequentially and with random seeks, decoded frames have to be the same as recorded ones
+static void BenchmarkFrameRecording()
+{
+	const int width = 80, height = 29;
+	const int framesCount = 5000, seeksCount = 2000;
+	const int keyframeIntervals[] = { 25, 100, 400 };
+	const char* path = "SpaceRaiders_benchmark.rec";
+	std::vector<unsigned char> frames((size_t)framesCount * width * height);
+	WorldSnapshot snapshot;
+	for (int frame = 0; frame < framesCount; frame++)
+	{
+		FillTerminalBenchmarkSnapshot(snapshot, frame, width, height, 100, 20);
+		unsigned char* canvas = &frames[(size_t)frame * width * height];
+		std::fill(canvas, canvas + width * height, ' ');
+		CanvasRasterizer::Draw(canvas, width, height, snapshot);
+	}
+	std::printf("Frame recording (%dx%d, %d frames, 100 sprites, 20 moving):\n", width, height, framesCount);
+	std::printf("%10s %12s %12s %12s %14s %14s %10s\n", "keyframes", "bytes/frame", "AddFrame us", "close ms", "sequential us", "seek us", "check");
+	for (int keyframeInterval : keyframeIntervals)
+	{
+		double addUs = 0.0, closeMs = 0.0;
+		{
+			FrameRecorder recorder;
+			if (!recorder.Open(path, width, height, keyframeInterval))
+			{
+				return;
+			}
+			for (int frame = 0; frame < framesCount; frame++)
+			{
+				FillTerminalBenchmarkSnapshot(snapshot, frame, width, height, 100, 20);
+				snapshot.iteration = frame;
+				auto start = BenchmarkClock::now();
+				recorder.AddFrame(&frames[(size_t)frame * width * height], snapshot);
+				addUs += ElapsedMs(start) * 1e3;
+				// the game produces frames at most a few thousands per second
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+			auto start = BenchmarkClock::now();
+			recorder.Close();
+			closeMs = ElapsedMs(start);
+		}
+		FramePlayer player;
+		bool isSame = player.Open(path) && player.GetFramesCount() == framesCount;
+		size_t fileSize = 0;
+		if (FILE* file = std::fopen(path, "rb"))
+		{
+			std::fseek(file, 0, SEEK_END);
+			fileSize = (size_t)std::ftell(file);
+			std::fclose(file);
+		}
+		auto start = BenchmarkClock::now();
+		for (int frame = 0; frame < framesCount && isSame; frame++)
+		{
+			isSame = player.Seek(frame) && std::equal(player.GetCanvas(), player.GetCanvas() + width * height,
+				&frames[(size_t)frame * width * height]);
+		}
+		double sequentialUs = ElapsedMs(start) * 1e3 / framesCount;
+		start = BenchmarkClock::now();
+		for (int i = 0; i < seeksCount && isSame; i++)
+		{
+			int frame = getRandInt(gRandGen, 0, framesCount - 1);
+			isSame = player.Seek(frame) && player.GetIteration() == (UINT32)frame && std::equal(player.GetCanvas(),
+				player.GetCanvas() + width * height, &frames[(size_t)frame * width * height]);
+		}
+		double seekUs = ElapsedMs(start) * 1e3 / seeksCount;
+		std::printf("%10d %12.1f %12.3f %12.3f %14.3f %14.3f %10s\n", keyframeInterval, (double)fileSize / framesCount,
+			addUs / framesCount, closeMs, sequentialUs, seekUs, isSame ? "PASS" : "FAIL");
+	}
+	std::remove(path);
+}
+
+// Snapshot benchmark: world of 100k entities of all kinds is saved, written into a file
+// and restored (from memory and from memory mapped file), restored worlds have to be in the
+// same state as the original one and stay in it for following ticks.
+static void BenchmarkSnapshot()
+{
+	const int sizeX = 1000, sizeY = 1000;
+	const int aliensCount = 40000, explodingAliensCount = 1000, wallBlocksCount = 40000, lasersCount = 18000;
+	const int repetitions = 10;
+	const int ticks = 5;
+	const char* path = "SpaceRaiders_benchmark.snapshot";
+	gRandGen.seed(1);
+	GameConfig config = { true, 0, false, false, true, true, 1, 0, false, 1 };
+	const Vector2D size((float)sizeX, (float)sizeY);
+	auto randomPos = [&](int maxY) { return Vector2D((float)getRandInt(gRandGen, 0, sizeX - 1), (float)getRandInt(gRandGen, 0, maxY)); };
+
+	// the world is built like by the game: objects are added and the first tick moves them into entity store
+	auto start = BenchmarkClock::now();
+	PlayField world(size, config);
+	world.MaxAlienLasers = world.MaxPlayerLasers = lasersCount + explodingAliensCount;
+	world.AddPlayerObject(Vector2D(sizeX / 2.f, sizeY - 2.f));
+	for (int i = 0; i < aliensCount; i++)
+	{
+		world.AddObject(new Alien(randomPos(sizeY / 2), 0.02f));
+	}
+	for (int i = 0; i < explodingAliensCount; i++)
+	{
+		world.AddObject(new ExplodingAlien(randomPos(sizeY / 2), 0.06f));
+	}
+	for (int i = 0; i < wallBlocksCount; i++)
+	{
+		world.AddObject(new WallBlock(randomPos(sizeY - 3)));
+	}
+	for (int i = 0; i < lasersCount; i++)
+	{
+		WallBlock parent(randomPos(sizeY - 3));
+		world.SpawnLaser(i % 2 == 0 ? (GameObject*)new AlienLaser(&parent) : new PlayerLaser(&parent));
+	}
+	world.Update();
+	double buildMs = ElapsedMs(start);
+
+	std::vector<unsigned char> snapshot;
+	double saveMs = 0.0;
+	for (int rep = 0; rep < repetitions; rep++)
+	{
+		start = BenchmarkClock::now();
+		PlayFieldSnapshot::Save(world, snapshot);
+		saveMs += ElapsedMs(start) / repetitions;
+	}
+	UINT64 hash = PlayFieldSnapshot::Hash(snapshot);
+	start = BenchmarkClock::now();
+	bool isSame = PlayFieldSnapshot::WriteFile(path, snapshot);
+	double writeMs = ElapsedMs(start);
+
+	// restores are timed without creating play fields they are restored into
+	std::vector<unsigned char> restoredSnapshot;
+	double restoreMs = 0.0, restoreFileMs = 0.0;
+	for (int rep = 0; rep < repetitions && isSame; rep++)
+	{
+		PlayField restored(size, config);
+		start = BenchmarkClock::now();
+		isSame = PlayFieldSnapshot::Restore(restored, snapshot.data(), snapshot.size());
+		restoreMs += ElapsedMs(start) / repetitions;
+		PlayFieldSnapshot::Save(restored, restoredSnapshot);
+		isSame = isSame && PlayFieldSnapshot::Hash(restoredSnapshot) == hash;
+	}
+	PlayField restored(size, config);
+	for (int rep = 0; rep < repetitions && isSame; rep++)
+	{
+		// (restoring into used world also releases its objects)
+		start = BenchmarkClock::now();
+		isSame = PlayFieldSnapshot::RestoreFile(restored, path);
+		restoreFileMs += ElapsedMs(start) / repetitions;
+	}
+	PlayFieldSnapshot::Save(restored, restoredSnapshot);
+	isSame = isSame && PlayFieldSnapshot::Hash(restoredSnapshot) == hash;
+	for (int t = 0; t < ticks && isSame; t++)
+	{
+		world.Update();
+		restored.Update();
+		PlayFieldSnapshot::Save(world, snapshot);
+		PlayFieldSnapshot::Save(restored, restoredSnapshot);
+		isSame = PlayFieldSnapshot::Hash(snapshot) == PlayFieldSnapshot::Hash(restoredSnapshot);
+	}
+	std::remove(path);
+	std::printf("Snapshot (%d entities, %dx%d field):\n", world.GetEntityStore().GetSize(), sizeX, sizeY);
+	std::printf("%10s %10s %10s %10s %12s %16s %10s\n", "MB", "build ms", "save ms", "write ms", "restore ms", "restore file ms", "check");
+	std::printf("%10.2f %10.3f %10.3f %10.3f %12.3f %16.3f %10s\n", snapshot.size() / 1048576.0, buildMs, saveMs, writeMs,
+		restoreMs, restoreFileMs, isSame ? "PASS" : "FAIL");
+}
+
+// Fork benchmark: world with default counts of objects is forked and the branch is simulated
+// LookaheadBot::LookaheadTicks iterations (cost of one move considered by the bot), forking
+// into a new play field each time is the baseline. Branch with the same (random) input as the
+// world has to end in the same state as the world.
+static void BenchmarkFork()
+{
+	const int repetitions = 1000;
+	const int ticks = LookaheadBot::LookaheadTicks;
+	gRandGen.seed(1);
+	GameConfig config = { true, 100000, false, false, true, true, 3, 0, false, 1 };
+	const Vector2D size(80, 29);
+	PlayField world(size, config);
+	world.SetupGame();
+	world.SpawnAliens(200, true);
+	for (int t = 0; t < 50; t++)
+	{
+		world.Update();
+	}
+	PlayField branch(size, config);
+	double forkMs = 0.0, forkSimulateMs = 0.0, newWorldForkMs = 0.0;
+#ifdef SPACERAIDERS_COUNT_ALLOCATIONS
+	// heap allocations of forks into the branch (simulated ticks aren't counted)
+	long long forkAllocations = 0;
+#endif
+	bool isSame = true;
+	for (int rep = 0; rep < repetitions && isSame; rep++)
+	{
+		auto start = BenchmarkClock::now();
+#ifdef SPACERAIDERS_COUNT_ALLOCATIONS
+		long long allocations = GetHeapAllocationsCount();
+		isSame = world.Fork(branch);
+		forkAllocations += GetHeapAllocationsCount() - allocations;
+#else
+		isSame = world.Fork(branch);
+#endif
+		forkMs += ElapsedMs(start) / repetitions;
+		for (int t = 0; t < ticks; t++)
+		{
+			branch.Update();
+		}
+		forkSimulateMs += ElapsedMs(start) / repetitions;
+	}
+	for (int rep = 0; rep < repetitions / 10 && isSame; rep++)
+	{
+		auto start = BenchmarkClock::now();
+		PlayField newBranch(size, config);
+		isSame = world.Fork(newBranch);
+		newWorldForkMs += ElapsedMs(start) / (repetitions / 10);
+	}
+	// branch has its own random input which is forked with the world
+	std::vector<unsigned char> worldState, branchState;
+	isSame = isSame && world.Fork(branch);
+	for (int t = 0; t < ticks; t++)
+	{
+		world.Update();
+		branch.Update();
+	}
+	PlayFieldSnapshot::Save(world, worldState);
+	PlayFieldSnapshot::Save(branch, branchState);
+	isSame = isSame && PlayFieldSnapshot::Hash(worldState) == PlayFieldSnapshot::Hash(branchState);
+	std::printf("Fork (%d objects, %dx%d field, %d ticks simulated after fork):\n", world.GetEntityStore().GetSize(),
+		(int)size.x, (int)size.y, ticks);
+#ifdef SPACERAIDERS_COUNT_ALLOCATIONS
+	std::printf("%12s %18s %18s %16s %10s\n", "fork ms", "fork+simulate ms", "fork into new ms", "allocs per fork", "check");
+	std::printf("%12.4f %18.4f %18.4f %16.2f %10s\n", forkMs, forkSimulateMs, newWorldForkMs,
+		(double)forkAllocations / repetitions, isSame ? "PASS" : "FAIL");
+#else
+	std::printf("%12s %18s %18s %10s\n", "fork ms", "fork+simulate ms", "fork into new ms", "check");
+	std::printf("%12.4f %18.4f %18.4f %10s\n", forkMs, forkSimulateMs, newWorldForkMs, isSame ? "PASS" : "FAIL");
+#endif
+}
+
+static void BenchmarkReplay()
+{
+	const int ticksCount = 4000, checkInterval = 50, seeksCount = 200;
+	const int snapshotIntervals[] = { 100, 1000 };
+	const char* path = "SpaceRaiders_benchmark.rp";
+	const Vector2D size(200, 100);
+	GameConfig config = { true, ticksCount, false, false, true, true, 7, 0, false, 1 };
+	config.maxAliens = 1000;
+	std::printf("Replay (%dx%d field, 300 aliens, up to %d ticks, state compared every %d ticks):\n",
+		(int)size.x, (int)size.y, ticksCount, checkInterval);
+	std::printf("%10s %8s %10s %12s %12s %12s %12s %14s %10s\n", "snapshots", "ticks", "file KB", "snapshot KB", "save ms",
+		"replay t/s", "seek ms", "from tick 0 ms", "check");
+	for (int snapshotInterval : snapshotIntervals)
+	{
+		// the original game, hash of its state is taken before each checked tick
+		std::vector<UINT64> hashes;
+		std::vector<unsigned char> snapshot;
+		double saveMs = 0.0;
+		size_t snapshotsSize = 0;
+		UINT32 endTick = 0;
+		{
+			PlayField world(size, config);
+			world.SetupGame();
+			world.SpawnAliens(300, true);
+			ReplayRecorder recorder(world);
+			if (!recorder.Open(path, config.seed, (int)size.x, (int)size.y, snapshotInterval))
+			{
+				return;
+			}
+			while (world.IsStillRunning())
+			{
+				if (world.GetIteration() % checkInterval == 0)
+				{
+					auto start = BenchmarkClock::now();
+					PlayFieldSnapshot::Save(world, snapshot);
+					saveMs += ElapsedMs(start);
+					snapshotsSize += snapshot.size();
+					hashes.push_back(PlayFieldSnapshot::Hash(snapshot));
+				}
+				world.Update();
+			}
+			recorder.Close();
+			endTick = world.GetIteration();
+		}
+		size_t fileSize = 0;
+		if (FILE* file = std::fopen(path, "rb"))
+		{
+			std::fseek(file, 0, SEEK_END);
+			fileSize = (size_t)std::ftell(file);
+			std::fclose(file);
+		}
+
+		// replay from the beginning reaches the same states
+		ReplayPlayer player;
+		bool isSame = player.Open(path) && player.GetEndTick() == endTick;
+		PlayField world(size, config);
+		ReplayInput input(player, world);
+		world.SetControllerInput(&input);
+		isSame = isSame && player.Seek(world, 0);
+		double replayMs = 0.0;
+		for (size_t i = 0; i < hashes.size() && isSame; i++)
+		{
+			auto start = BenchmarkClock::now();
+			while (world.GetIteration() < (UINT32)(i * checkInterval))
+			{
+				world.Update();
+			}
+			replayMs += ElapsedMs(start);
+			PlayFieldSnapshot::Save(world, snapshot);
+			isSame = PlayFieldSnapshot::Hash(snapshot) == hashes[i];
+		}
+		// and so does seeking to random ticks (through the nearest snapshot)
+		double seekMs = 0.0;
+		UINT64 seekTicksSum = 0;
+		for (int i = 0; i < seeksCount && isSame; i++)
+		{
+			int check = getRandInt(gRandGen, 0, (int)hashes.size() - 1);
+			auto start = BenchmarkClock::now();
+			isSame = player.Seek(world, (UINT32)(check * checkInterval));
+			seekMs += ElapsedMs(start);
+			seekTicksSum += (UINT64)check * checkInterval;
+			PlayFieldSnapshot::Save(world, snapshot);
+			isSame = isSame && PlayFieldSnapshot::Hash(snapshot) == hashes[check];
+		}
+		double replayTicksPerSecond = replayMs > 0.0 ? (hashes.size() - 1) * checkInterval * 1000.0 / replayMs : 0.0;
+		// without snapshots each seek would play all ticks from the beginning
+		double fromStartMs = replayTicksPerSecond > 0.0 ? seekTicksSum * 1000.0 / seeksCount / replayTicksPerSecond : 0.0;
+		std::printf("%10d %8u %10.1f %12.1f %12.3f %12.0f %12.3f %14.3f %10s\n", snapshotInterval, endTick, fileSize / 1024.0,
+			hashes.empty() ? 0.0 : snapshotsSize / 1024.0 / hashes.size(), hashes.empty() ? 0.0 : saveMs / hashes.size(), replayTicksPerSecond,
+			seekMs / seeksCount, fromStartMs, isSame ? "PASS" : "FAIL");
+	}
+	std::remove(path);
+}
+
+#ifndef _WIN32
+static void WriteAll(int fd, const char* data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t written = write(fd, data, size);
+		if (written <= 0)
+		{
+			return;
+		}
+		data += written;
+		size -= (size_t)written;
+	}
+}
+
+static void BenchmarkTerminalOutput()
+{
+	const int width = 80, height = 29;
+	const int framesCount = 2000;
+	const int spritesCount = 100;
+	const int movingSpritesCount = 20;
+	// the slave side of pty is the terminal, master side is drained by another thread (like by terminal emulator)
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+	{
+		std::printf("Terminal output: can't open pty\n");
+		return;
+	}
+	int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+	struct winsize size = { (unsigned short)(height + 1), (unsigned short)width, 0, 0 };
+	ioctl(slave, TIOCSWINSZ, &size);
+	std::thread drain([master]()
+	{
+		char buffer[65536];
+		while (read(master, buffer, sizeof(buffer)) > 0);
+	});
+	int devNull = open("/dev/null", O_WRONLY);
+	const char* targetNames[] = { "/dev/null", "pty" };
+	int targets[] = { devNull, slave };
+
+	std::printf("Terminal output (%dx%d, %d frames, %d sprites, %d of them moving):\n", width, height, framesCount,
+		spritesCount, movingSpritesCount);
+	std::printf("%10s %16s %16s %16s %16s %16s\n", "target", "renderer us", "renderer bytes", "full frame us", "per-row us", "full frame MB/s");
+	for (int t = 0; t < 2; t++)
+	{
+		// renderer: differential output, one write() per frame
+		Renderer renderer(Vector2D((float)width, (float)height), new AnsiTerminalBackend(targets[t]));
+		renderer.AdjustConsoleSize();
+		FrameProfiler profiler;
+		WorldSnapshot snapshot;
+		UINT64 initialBytes = renderer.GetOutputBytesCount();
+		auto start = BenchmarkClock::now();
+		for (int frame = 0; frame < framesCount; frame++)
+		{
+			FillTerminalBenchmarkSnapshot(snapshot, frame, width, height, spritesCount, movingSpritesCount);
+			renderer.Render(snapshot, profiler);
+		}
+		double rendererUs = ElapsedMs(start) * 1e3 / framesCount;
+		UINT64 rendererBytes = (renderer.GetOutputBytesCount() - initialBytes) / framesCount;
+
+		// whole frame with one write() against one write() per row
+		std::vector<char> frameBuffer, rowBuffer;
+		std::vector<unsigned char> canvas(width * height, ' ');
+		start = BenchmarkClock::now();
+		for (int frame = 0; frame < framesCount; frame++)
+		{
+			canvas[frame % canvas.size()] ^= 1;
+			frameBuffer.clear();
+			CanvasDiff::AppendCursorPosition(0, 0, frameBuffer);
+			frameBuffer.insert(frameBuffer.end(), canvas.begin(), canvas.end());
+			WriteAll(targets[t], frameBuffer.data(), frameBuffer.size());
+		}
+		double fullFrameMs = ElapsedMs(start);
+		start = BenchmarkClock::now();
+		for (int frame = 0; frame < framesCount; frame++)
+		{
+			canvas[frame % canvas.size()] ^= 1;
+			for (int y = 0; y < height; y++)
+			{
+				rowBuffer.clear();
+				CanvasDiff::AppendCursorPosition(0, y, rowBuffer);
+				rowBuffer.insert(rowBuffer.end(), canvas.begin() + y * width, canvas.begin() + (y + 1) * width);
+				WriteAll(targets[t], rowBuffer.data(), rowBuffer.size());
+			}
+		}
+		double perRowUs = ElapsedMs(start) * 1e3 / framesCount;
+		std::printf("%10s %16.2f %16d %16.2f %16.2f %16.1f\n", targetNames[t], rendererUs, (int)rendererBytes,
+			fullFrameMs * 1e3 / framesCount, perRowUs, fullFrameMs > 0 ? frameBuffer.size() * framesCount / fullFrameMs / 1e3 : 0.0);
+	}
+	close(devNull);
+	close(slave);
+	drain.join();
+	close(master);
+}
+#endif
+
+void RunBenchmarks()
+{
+	BenchmarkCollisionBroadphase(false);
+	BenchmarkCollisionBroadphase(true);
+	BenchmarkCollisionDispatch();
+	BenchmarkParallelUpdate();
+	BenchmarkObjectPools();
+	BenchmarkWorldRandom();
+	BenchmarkAlienScheduling();
+	BenchmarkRasterizer();
+	BenchmarkCanvasDiff();
+	BenchmarkFrameRecording();
+	BenchmarkSnapshot();
+	BenchmarkFork();
+	BenchmarkReplay();
+#ifndef _WIN32
+	BenchmarkTerminalOutput();
+#endif
+}
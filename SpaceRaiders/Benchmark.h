@@ -0,0 +1,7 @@
+#pragma once
+
+// Benchmarks are available through --benchmark cmd parameter,
+// they are not using renderer so they can be run without console window.
+// Build with SPACERAIDERS_COUNT_ALLOCATIONS defined to have all heap allocations counted
+// (operator new is replaced then, so it isn't defined for the game build).
+void RunBenchmarks();
@@ -0,0 +1,126 @@
+#include "stdafx.h"
+#include "CanvasDiff.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CANVAS_DIFF_SSE2
+#endif
+
+#ifdef CANVAS_DIFF_SSE2
+static inline int CountTrailingZeros(int mask)
+{
+	int count = 0;
+	for (; (mask & 1) == 0; mask >>= 1)
+	{
+		count++;
+	}
+	return count;
+}
+
+// bit i of the result is set if a[i] == b[i]
+static inline int CompareBlock(const unsigned char* a, const unsigned char* b)
+{
+	__m128i va = _mm_loadu_si128((const __m128i*)a);
+	__m128i vb = _mm_loadu_si128((const __m128i*)b);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+}
+#endif
+
+int CanvasDiff::FindDifference(const unsigned char* a, const unsigned char* b, int from, int size)
+{
+#ifdef CANVAS_DIFF_SSE2
+	// runs are often a single cell long (sprites), so the first cell is checked before loading blocks
+	if (from < size && a[from] != b[from])
+	{
+		return from;
+	}
+	for (; from + 16 <= size; from += 16)
+	{
+		int differentMask = ~CompareBlock(a + from, b + from) & 0xFFFF;
+		if (differentMask != 0)
+		{
+			return from + CountTrailingZeros(differentMask);
+		}
+	}
+#endif
+	for (; from < size && a[from] == b[from]; from++);
+	return from;
+}
+
+int CanvasDiff::FindEquality(const unsigned char* a, const unsigned char* b, int from, int size)
+{
+#ifdef CANVAS_DIFF_SSE2
+	if (from < size && a[from] == b[from])
+	{
+		return from;
+	}
+	for (; from + 16 <= size; from += 16)
+	{
+		int equalMask = CompareBlock(a + from, b + from);
+		if (equalMask != 0)
+		{
+			return from + CountTrailingZeros(equalMask);
+		}
+	}
+#endif
+	for (; from < size && a[from] != b[from]; from++);
+	return from;
+}
+
+// appends decimal digits of value (without snprintf, it is called for each run of changed cells)
+static inline char* WriteNumber(char* dest, int value)
+{
+	char digits[12];
+	int count = 0;
+	do
+	{
+		digits[count++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	while (count > 0)
+	{
+		*dest++ = digits[--count];
+	}
+	return dest;
+}
+
+void CanvasDiff::AppendCursorPosition(int x, int y, std::vector<char>& out)
+{
+	char sequence[32] = { '\x1b', '[' };
+	char* end = WriteNumber(sequence + 2, y + 1);
+	*end++ = ';';
+	end = WriteNumber(end, x + 1);
+	*end++ = 'H';
+	out.insert(out.end(), sequence, end);
+}
+
+bool CanvasDiff::Build(const unsigned char* canvas, const unsigned char* prevCanvas, int width, int height,
+	int maxBytes, std::vector<char>& out)
+{
+	size_t initialSize = out.size();
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* row = canvas + y * width;
+		const unsigned char* prevRow = prevCanvas + y * width;
+		int x = FindDifference(row, prevRow, 0, width);
+		while (x < width)
+		{
+			int end = FindEquality(row, prevRow, x, width);
+			int next = FindDifference(row, prevRow, end, width);
+			while (next < width && next - end < MergeGap)
+			{
+				end = FindEquality(row, prevRow, next, width);
+				next = FindDifference(row, prevRow, end, width);
+			}
+			AppendCursorPosition(x, y, out);
+			out.insert(out.end(), row + x, row + end);
+			if ((int)(out.size() - initialSize) > maxBytes)
+			{
+				out.resize(initialSize);
+				return false;
+			}
+			x = next;
+		}
+	}
+	return true;
+}
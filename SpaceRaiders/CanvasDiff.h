@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+// Differential output of character canvas for terminals understanding VT (ANSI) sequences:
+// each row of canvas is compared with the previous frame (16 bytes at once with SSE2)
+// and only runs of changed cells are written, each one preceded by cursor positioning
+// sequence. Runs separated by less than MergeGap unchanged cells are merged (writing
+// the unchanged cells is cheaper than another cursor positioning sequence).
+class CanvasDiff
+{
+public:
+	static const int MergeGap = 8;
+	// appends diff of canvas against prevCanvas (both width * height cells) to out,
+	// returns false (and leaves out as it was) when it would be longer than maxBytes
+	static bool Build(const unsigned char* canvas, const unsigned char* prevCanvas, int width, int height,
+		int maxBytes, std::vector<char>& out);
+	// index of the first cell in [from, size) which differs (size if there is no such cell)
+	static int FindDifference(const unsigned char* a, const unsigned char* b, int from, int size);
+	// index of the first cell in [from, size) which is the same in both rows
+	static int FindEquality(const unsigned char* a, const unsigned char* b, int from, int size);
+	// appends VT sequence moving cursor to given cell (0-based)
+	static void AppendCursorPosition(int x, int y, std::vector<char>& out);
+};
@@ -0,0 +1,30 @@
+#include "stdafx.h"
+#include <cstring>
+#include <algorithm>
+#include "CanvasRasterizer.h"
+
+void CanvasRasterizer::DrawSprites(unsigned char* canvas, int width, int height, const SnapshotSprite* sprites, size_t count)
+{
+	// (negative coordinates become huge unsigned values, so one comparison checks both edges)
+	for (const SnapshotSprite* it = sprites, *end = sprites + count; it != end; ++it)
+	{
+		if ((unsigned)it->x < (unsigned)width && (unsigned)it->y < (unsigned)height)
+		{
+			canvas[it->x + width * it->y] = (unsigned char)it->glyph;
+		}
+	}
+}
+
+void CanvasRasterizer::DrawStrings(unsigned char* canvas, int width, int height, const SnapshotString* strings, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const SnapshotString& str = strings[i];
+		if ((unsigned)str.x >= (unsigned)width || (unsigned)str.y >= (unsigned)height)
+		{
+			continue;
+		}
+		size_t length = (std::min)(str.text.size(), (size_t)(width - str.x));
+		std::memcpy(&canvas[str.x + width * str.y], str.text.data(), length);
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "RenderSnapshot.h"
+
+// Draws snapshot items straight into character canvas (width * height cells, row by row).
+// Sprites are single cells, so each one is a bounds check and a store - there is no
+// per-item object, virtual call or terminating zero to look for. Strings are copied
+// with memcpy, clipped at the right edge of canvas.
+// Later items overwrite earlier ones, so callers keep the snapshot order: sprites
+// first (in their order), then strings.
+class CanvasRasterizer
+{
+public:
+	static void DrawSprites(unsigned char* canvas, int width, int height, const SnapshotSprite* sprites, size_t count);
+	static void DrawStrings(unsigned char* canvas, int width, int height, const SnapshotString* strings, int count);
+	// all items of snapshot in the order described above
+	static void Draw(unsigned char* canvas, int width, int height, const WorldSnapshot& snapshot)
+	{
+		DrawSprites(canvas, width, height, snapshot.sprites.data(), snapshot.sprites.size());
+		DrawStrings(canvas, width, height, snapshot.strings.data(), snapshot.stringsCount);
+	}
+};
@@ -0,0 +1,112 @@
+#include "stdafx.h"
+#include <algorithm>
+#include "CollisionGrid.h"
+
+CollisionGrid::CollisionGrid(int sizeX, int sizeY) :
+	m_sizeX(sizeX), m_sizeY(sizeY), m_cellIndexBits(1)
+{
+	while (m_cellIndexBits < 31 && (1 << m_cellIndexBits) < sizeX * sizeY)
+	{
+		m_cellIndexBits++;
+	}
+}
+
+void CollisionGrid::Clear()
+{
+	m_pendingPoints.clear();
+	m_cells.clear();
+	m_entries.clear();
+	m_handles.clear();
+}
+
+void CollisionGrid::AddSegment(const Vector2D& from, const Vector2D& to, int objIndex, ObjectHandle handle,
+	RaiderObjectTypeId objType, UINT32 collisionTypeBitmap)
+{
+	// grid traversal (DDA) between centers of start and end cells,
+	// segment is treated as "supercover" line - if it passes exactly through cells corner
+	// both cells adjacent to this corner are added as well
+	PendingPoint point = { -1, objIndex, handle, 1U << objType, collisionTypeBitmap };
+	// (std::floor instead of FLOOR since cells at negative positions have to stay beyond the grid)
+	int x = (int)std::floor(from.x), y = (int)std::floor(from.y);
+	int xEnd = (int)std::floor(to.x), yEnd = (int)std::floor(to.y);
+	int dx = std::abs(xEnd - x), dy = std::abs(yEnd - y);
+	int xStep = xEnd > x ? 1 : -1, yStep = yEnd > y ? 1 : -1;
+	int error = dx - dy;
+	AddCell(x, y, point);
+	for (int n = dx + dy; n > 0; n--)
+	{
+		if (error > 0)
+		{
+			x += xStep;
+			error -= 2 * dy;
+		}
+		else if (error < 0)
+		{
+			y += yStep;
+			error += 2 * dx;
+		}
+		else
+		{
+			AddCell(x + xStep, y, point);
+			AddCell(x, y + yStep, point);
+			x += xStep;
+			y += yStep;
+			error += 2 * (dx - dy);
+			n--;
+		}
+		AddCell(x, y, point);
+	}
+}
+
+void CollisionGrid::Build()
+{
+	// 1. LSD radix sort of points by cell index. It is stable, so points
+	// within the same cell keep the order in which they were added.
+	// Digits are as wide as possible (up to MaxRadixBits) so that default
+	// sized play field is sorted in one pass.
+	int passes = (m_cellIndexBits + MaxRadixBits - 1) / MaxRadixBits;
+	int radixBits = (m_cellIndexBits + passes - 1) / passes;
+	UINT32 radixMask = (1U << radixBits) - 1;
+	m_histogram.resize((size_t)1 << radixBits);
+	m_sortBuffer.resize(m_pendingPoints.size());
+	auto *src = &m_pendingPoints, *dst = &m_sortBuffer;
+	for (int pass = 0; pass < passes; pass++)
+	{
+		int shift = pass * radixBits;
+		std::fill(m_histogram.begin(), m_histogram.end(), 0);
+		for (auto& it : *src)
+		{
+			m_histogram[((UINT32)it.cell >> shift) & radixMask]++;
+		}
+		int offset = 0;
+		for (auto& it : m_histogram)
+		{
+			int count = it;
+			it = offset;
+			offset += count;
+		}
+		for (auto& it : *src)
+		{
+			(*dst)[m_histogram[((UINT32)it.cell >> shift) & radixMask]++] = it;
+		}
+		std::swap(src, dst);
+	}
+
+	// 2. sorted points form runs of the same cell index, each run becomes one cell
+	m_entries.resize(src->size());
+	m_handles.resize(src->size());
+	for (size_t i = 0; i < src->size(); i++)
+	{
+		auto& point = (*src)[i];
+		if (m_cells.empty() || m_cells.back().index != point.cell)
+		{
+			m_cells.push_back({ point.cell, (int)i, 0, 0, 0 });
+		}
+		Cell& cell = m_cells.back();
+		cell.count++;
+		cell.typeMask |= point.typeMask;
+		cell.collisionMask |= point.collisionMask;
+		m_entries[i] = point.objIndex;
+		m_handles[i] = point.handle;
+	}
+}
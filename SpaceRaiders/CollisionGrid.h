@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include "GameObjects.h"
+
+// CollisionGrid is a broadphase structure with exactly one cell per game cell
+// (so unlike hash map there is no aliasing between distant cells).
+// It is rebuilt every iteration in 3 steps:
+//	AddSegment(...) [ for each object movement segment since last iteration ]
+//		Build() [ stable radix sort of all cells touched by segments by cell index ]
+//			GetCell(...)/GetCellEntries(...) [ contiguous range of object indexes for each non-empty cell ]
+// All cells share flat arrays (cells offsets + object indexes), there are no per-cell
+// dynamic allocations and memory usage doesn't depend on grid size, only on number of points.
+// Grid doesn't store objects, only their indexes in caller's objects collection
+// (and their handles, which stay valid after objects collection has changed, so that
+// the grid can be queried for objects in given area, i.e. by Renderer, until it is rebuilt).
+class CollisionGrid
+{
+public:
+	struct Cell
+	{
+		int index;
+		int offset;
+		int count;
+		// bitmap of types of objects present in the cell and bitmap of types
+		// that any object in the cell may collide with
+		UINT32 typeMask;
+		UINT32 collisionMask;
+	};
+private:
+	struct PendingPoint
+	{
+		int cell;
+		int objIndex;
+		ObjectHandle handle;
+		UINT32 typeMask;
+		UINT32 collisionMask;
+	};
+	static const int MaxRadixBits = 14;
+	int m_sizeX;
+	int m_sizeY;
+	int m_cellIndexBits;
+	std::vector<PendingPoint> m_pendingPoints;
+	std::vector<PendingPoint> m_sortBuffer;
+	std::vector<int> m_histogram;
+	// non-empty cells sorted by cell index
+	std::vector<Cell> m_cells;
+	std::vector<int> m_entries;
+	std::vector<ObjectHandle> m_handles;
+	inline void AddCell(int x, int y, const PendingPoint& point)
+	{
+		if (x >= 0 && y >= 0 && x < m_sizeX && y < m_sizeY)
+		{
+			m_pendingPoints.push_back(point);
+			m_pendingPoints.back().cell = x + y * m_sizeX;
+		}
+	}
+public:
+	CollisionGrid(int sizeX, int sizeY);
+	void Clear();
+	// adds object to every cell crossed by from -> to segment (both ends inclusive),
+	// objects have to be added in the same order in which they should be tested in narrowphase
+	void AddSegment(const Vector2D& from, const Vector2D& to, int objIndex, ObjectHandle handle,
+		RaiderObjectTypeId objType, UINT32 collisionTypeBitmap);
+	void Build();
+	int GetCellsCount() const { return (int)m_cells.size(); }
+	const Cell& GetCell(int i) const { return m_cells[i]; }
+	// there is no point in running narrowphase for cell if none of its objects
+	// is able to collide with any other object type present in this cell
+	static inline bool IsCellColliding(const Cell& cell)
+	{
+		return cell.count > 1 && (cell.typeMask & cell.collisionMask) != 0;
+	}
+	// object indexes are stored in the same order as they were added
+	inline const int* GetCellEntries(const Cell& cell) const
+	{
+		return &m_entries[cell.offset];
+	}
+	// calls func(handle) for each object in cells of given rectangle (both corners inclusive),
+	// object is reported once for each of its cells in this rectangle
+	template <typename Func>
+	void ForEachHandleInRect(int x0, int y0, int x1, int y1, Func func) const
+	{
+		x0 = std::max(x0, 0);
+		x1 = std::min(x1, m_sizeX - 1);
+		for (int y = std::max(y0, 0); y <= std::min(y1, m_sizeY - 1) && x0 <= x1; y++)
+		{
+			// cells are sorted by index, so each line of the rectangle is a contiguous range of cells
+			int first = x0 + y * m_sizeX, last = x1 + y * m_sizeX;
+			auto cell = std::lower_bound(m_cells.begin(), m_cells.end(), first,
+				[](const Cell& c, int index) { return c.index < index; });
+			for (; cell != m_cells.end() && cell->index <= last; ++cell)
+			{
+				for (int i = 0; i < cell->count; i++)
+				{
+					func(m_handles[cell->offset + i]);
+				}
+			}
+		}
+	}
+};
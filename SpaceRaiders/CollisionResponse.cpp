@@ -0,0 +1,37 @@
+#include "stdafx.h"
+#include "CollisionResponse.h"
+#include "PlayField.h"
+
+void CollisionResponse::Strike(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+{
+	target.Health() -= attacker.m_strikeForce;
+	if (target.Health() <= 0)
+	{
+		world.RemoveObject(&target);
+		target.OnObjectDestroyed(attacker, world, collisionPoint);
+	}
+}
+
+void CollisionResponse::StrikeIfStrongLaser(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+{
+	if (IsStrongLaser(attacker))
+	{
+		Strike(target, attacker, world, collisionPoint);
+	}
+}
+
+void CollisionResponse::StrikeIfNotStrongLaser(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+{
+	if (!IsStrongLaser(target))
+	{
+		Strike(target, attacker, world, collisionPoint);
+	}
+}
+
+void CollisionResponse::StrikeIfFriendFire(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+{
+	if (world.IsAliensFriendFireEnabled())
+	{
+		Strike(target, attacker, world, collisionPoint);
+	}
+}
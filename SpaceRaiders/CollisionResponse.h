@@ -0,0 +1,133 @@
+#pragma once
+
+#include <initializer_list>
+#include "GameObjects.h"
+
+class PlayField;
+
+// response of target object that has been hit by attacker object
+typedef void (*CollisionResponseFunc)(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
+
+// Handlers that can be placed in collision table.
+// All of them end up in Strike(...) which decreases target health by attacker strike force
+// and invokes target OnObjectDestroyed(...) if its health dropped to 0 or below.
+class CollisionResponse
+{
+public:
+	// strong alien lasers may destroy wall blocks and are resistant to player lasers
+	static const int StrongLaserStrikeForce = 5;
+	static inline bool IsStrongLaser(GameObject& obj) { return obj.GetStrikeForce() >= StrongLaserStrikeForce; }
+
+	static void Strike(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
+	static void StrikeIfStrongLaser(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
+	static void StrikeIfNotStrongLaser(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
+	static void StrikeIfFriendFire(GameObject& target, GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
+};
+
+constexpr UINT32 SetupCollidingObjects(std::initializer_list<RaiderObjectTypeId> l)
+{
+	UINT32 retVal = 0;
+	for (auto it : l)
+	{
+		retVal |= (1U << (int)it);
+	}
+	return retVal;
+}
+
+typedef struct
+{
+	// types that are able to hit given object type
+	// (we can afford simple 32-bit bitmap since we have less then 32 types of game objects)
+	UINT32 collidingTypes[RI_End];
+	// bit of type B is set in pairMasks[A] if A may be hit by B or B may be hit by A,
+	// pair of objects for which this bit is not set doesn't need any narrowphase test
+	UINT32 pairMasks[RI_End];
+	// [target type][attacker type], nullptr means that target is not affected by attacker
+	CollisionResponseFunc responses[RI_End][RI_End];
+} CollisionTable;
+
+constexpr CollisionTable BuildCollisionTable()
+{
+	CollisionTable table = {};
+	table.collidingTypes[RI_Player] = SetupCollidingObjects({ RI_AlienLaser, RI_Alien, RI_PowerUp, RI_ExplosionCell });
+	table.collidingTypes[RI_Alien] = SetupCollidingObjects({ RI_AlienLaser, RI_PlayerLaser, RI_Player, RI_ExplosionCell });
+	table.collidingTypes[RI_PlayerLaser] = SetupCollidingObjects({ RI_AlienLaser, RI_PlayerLaser,
+		RI_Player, RI_Alien, RI_WallBlock, RI_ExplosionCell });
+	table.collidingTypes[RI_AlienLaser] = table.collidingTypes[RI_PlayerLaser];
+	table.collidingTypes[RI_WallBlock] = SetupCollidingObjects({ RI_PlayerLaser, RI_ExplosionCell, RI_AlienLaser });
+	table.collidingTypes[RI_PowerUp] = SetupCollidingObjects({ RI_Player });
+	// Explosion is only a visual effect and exploding alien explosion cells
+	// are resistant to any other objects
+	table.collidingTypes[RI_Explosion] = 0;
+	table.collidingTypes[RI_ExplosionCell] = 0;
+
+	// responses are marked in hasResponse too, since comparing function pointers (with nullptr)
+	// isn't a constant expression for all compilers (i.e. gcc with -fsanitize=undefined)
+	bool hasResponse[RI_End][RI_End] = {};
+	for (int target = 0; target < RI_End; target++)
+	{
+		for (int attacker = 0; attacker < RI_End; attacker++)
+		{
+			if (table.collidingTypes[target] & (1U << attacker))
+			{
+				table.responses[target][attacker] = &CollisionResponse::Strike;
+				hasResponse[target][attacker] = true;
+			}
+		}
+	}
+	// let's assume that player lasers cannot hit player lasers
+	// and alien lasers cannot hit alien lasers
+	// (without this, if they move the same direction
+	// and are very close to each other, they may mistakenly
+	// by treated as collided when they occupy the same cell)
+	table.responses[RI_PlayerLaser][RI_PlayerLaser] = nullptr;
+	hasResponse[RI_PlayerLaser][RI_PlayerLaser] = false;
+	table.responses[RI_AlienLaser][RI_AlienLaser] = nullptr;
+	hasResponse[RI_AlienLaser][RI_AlienLaser] = false;
+	// PlayerShip lasers are not able to destroy strong alien lasers
+	table.responses[RI_AlienLaser][RI_PlayerLaser] = &CollisionResponse::StrikeIfNotStrongLaser;
+	hasResponse[RI_AlienLaser][RI_PlayerLaser] = true;
+	// in case of alien laser, only strong one can hurt wall block
+	table.responses[RI_WallBlock][RI_AlienLaser] = &CollisionResponse::StrikeIfStrongLaser;
+	hasResponse[RI_WallBlock][RI_AlienLaser] = true;
+	// aliens are able to kill each other only if it is enabled in game config
+	table.responses[RI_Alien][RI_AlienLaser] = &CollisionResponse::StrikeIfFriendFire;
+	hasResponse[RI_Alien][RI_AlienLaser] = true;
+
+	for (int target = 0; target < RI_End; target++)
+	{
+		for (int attacker = 0; attacker < RI_End; attacker++)
+		{
+			if (hasResponse[target][attacker])
+			{
+				table.pairMasks[target] |= 1U << attacker;
+				table.pairMasks[attacker] |= 1U << target;
+			}
+		}
+	}
+	return table;
+}
+
+constexpr CollisionTable gCollisionTable = BuildCollisionTable();
+
+inline bool CanObjectsCollide(RaiderObjectTypeId type1, RaiderObjectTypeId type2)
+{
+	return (gCollisionTable.pairMasks[type1] & (1U << type2)) != 0;
+}
+
+// Applies collision of o1 and o2 to both of them (o1 is hit first).
+// Response for o2 is looked up after o1 is handled since o1 type may change
+// when it is destroyed (i.e. exploding alien turns into explosion cell)
+inline void ResolveCollision(GameObject& o1, GameObject& o2, PlayField& world, const Vector2D& collisionPoint)
+{
+	CollisionResponseFunc response = gCollisionTable.responses[o1.GetType()][o2.GetType()];
+	if (response != nullptr)
+	{
+		response(o1, o2, world, collisionPoint);
+	}
+	response = gCollisionTable.responses[o2.GetType()][o1.GetType()];
+	if (response != nullptr)
+	{
+		response(o2, o1, world, collisionPoint);
+	}
+}
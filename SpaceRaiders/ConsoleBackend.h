@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+// Output side of Renderer: console (terminal) on which canvas is drawn.
+// Renderer builds each frame in its own buffer and passes it to Write(...) at once,
+// backends should output it with as few system calls as possible.
+class ConsoleBackend
+{
+public:
+	virtual ~ConsoleBackend() {}
+	// prepares console for drawing width x height cells, false (with error printed) if it isn't possible
+	virtual bool Init(int width, int height) = 0;
+	// true if console interprets VT (ANSI) cursor positioning sequences, so that only changed cells
+	// may be written - otherwise MoveCursorHome() and whole canvas is written every frame
+	virtual bool IsVirtualTerminal() = 0;
+	virtual void MoveCursorHome() = 0;
+	virtual void Write(const char* data, size_t size) = 0;
+	virtual void SetCursorVisibility(bool isVisible) = 0;
+};
+
+// console of the platform: Windows console (WinConsoleBackend) or ANSI terminal on standard output
+ConsoleBackend* CreateConsoleBackend();
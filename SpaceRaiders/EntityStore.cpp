@@ -0,0 +1,133 @@
+#include "stdafx.h"
+#include "EntityStore.h"
+#include "CollisionResponse.h"
+
+template <typename T>
+static inline void RemoveSwapWithLast(std::vector<T>& arr, int index)
+{
+	arr[index] = arr.back();
+	arr.pop_back();
+}
+
+EntityStore::~EntityStore()
+{
+	// objects may outlive the store (i.e. caught power-ups), so they have to get their state back
+	for (int type = 0; type < RI_End; type++)
+	{
+		EntityGroup& group = m_groups[type];
+		while (group.Size() > 0)
+		{
+			GameObject* obj = group.objects[group.Size() - 1];
+			Detach((RaiderObjectTypeId)type, group.Size() - 1);
+			obj->m_handle = InvalidObjectHandle;
+		}
+	}
+}
+
+int EntityStore::GetSize()
+{
+	int size = 0;
+	for (auto& group : m_groups)
+	{
+		size += group.Size();
+	}
+	return size;
+}
+
+ObjectHandle EntityStore::CreateHandle(GameObject* obj)
+{
+	obj->m_handle = m_slots.Insert({ obj, -1 });
+	return obj->m_handle;
+}
+
+GameObject* EntityStore::GetObject(ObjectHandle handle)
+{
+	ObjectSlot* slot = m_slots.Get(handle);
+	return slot ? slot->obj : nullptr;
+}
+
+int EntityStore::GetEntityId(ObjectHandle handle)
+{
+	ObjectSlot* slot = m_slots.Get(handle);
+	return slot ? slot->entityId : -1;
+}
+
+void EntityStore::Add(GameObject* obj)
+{
+	EntityGroup& group = m_groups[obj->m_objType];
+	EntityData& data = obj->m_data;
+	m_slots.Get(obj->m_handle)->entityId = MakeEntityId(obj->m_objType, group.Size());
+	obj->m_group = &group;
+	obj->m_entityIndex = group.Size();
+	group.objects.push_back(obj);
+	group.handle.push_back(obj->m_handle);
+	group.pos.push_back(data.pos);
+	group.posPrev.push_back(data.posPrev);
+	group.velocity.push_back(data.velocity);
+	group.health.push_back(data.health);
+	group.ticksLeft.push_back(data.ticksLeft);
+	group.sprite.push_back(data.sprite);
+	group.isActive.push_back(data.isActive ? 1 : 0);
+	group.collisionMask.push_back(gCollisionTable.pairMasks[obj->m_objType]);
+}
+
+void EntityStore::Detach(RaiderObjectTypeId type, int index)
+{
+	EntityGroup& group = m_groups[type];
+	GameObject* obj = group.objects[index];
+	EntityData& data = obj->m_data;
+	data.pos = group.pos[index];
+	data.posPrev = group.posPrev[index];
+	data.velocity = group.velocity[index];
+	data.health = group.health[index];
+	data.ticksLeft = group.ticksLeft[index];
+	data.sprite = group.sprite[index];
+	data.isActive = group.isActive[index] != 0;
+	obj->m_group = nullptr;
+
+	// the last entity takes place of removed one (like it was done for objects collection before)
+	RemoveSwapWithLast(group.objects, index);
+	RemoveSwapWithLast(group.handle, index);
+	RemoveSwapWithLast(group.pos, index);
+	RemoveSwapWithLast(group.posPrev, index);
+	RemoveSwapWithLast(group.velocity, index);
+	RemoveSwapWithLast(group.health, index);
+	RemoveSwapWithLast(group.ticksLeft, index);
+	RemoveSwapWithLast(group.sprite, index);
+	RemoveSwapWithLast(group.isActive, index);
+	RemoveSwapWithLast(group.collisionMask, index);
+	if (index < group.Size())
+	{
+		GameObject* moved = group.objects[index];
+		moved->m_entityIndex = index;
+		m_slots.Get(moved->m_handle)->entityId = MakeEntityId(type, index);
+	}
+}
+
+void EntityStore::Remove(ObjectHandle handle)
+{
+	ObjectSlot* slot = m_slots.Get(handle);
+	if (slot == nullptr)
+	{
+		return;
+	}
+	GameObject* obj = slot->obj;
+	if (slot->entityId != -1)
+	{
+		Detach(GetEntityType(slot->entityId), GetEntityIndex(slot->entityId));
+	}
+	m_slots.Remove(handle);
+	obj->m_handle = InvalidObjectHandle;
+}
+
+void EntityStore::Regroup(ObjectHandle handle)
+{
+	ObjectSlot* slot = m_slots.Get(handle);
+	if (slot == nullptr || slot->entityId == -1 || GetEntityType(slot->entityId) == slot->obj->m_objType)
+	{
+		return;
+	}
+	GameObject* obj = slot->obj;
+	Detach(GetEntityType(slot->entityId), GetEntityIndex(slot->entityId));
+	Add(obj);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include "GameObjects.h"
+#include "SlotMap.h"
+
+// EntityStore keeps hot fields of all game objects that are part of the play field
+// in parallel arrays grouped by object type, so that per iteration passes (update,
+// collisions, rendering) are tight loops over contiguous memory instead of chasing
+// GameObject pointers.
+// Objects are referenced by generational handles (see SlotMap), handle is assigned
+// by CreateHandle(...) and it is the only reference to the object that stays valid while
+// entities are relocated in the arrays. Entity indexes are stable between Add(...),
+// Remove(...) and Regroup(...) calls, all of which are O(1). They keep group and index of
+// the object up to date, so that GameObject accessors read the arrays without handle lookup.
+class EntityStore
+{
+	// snapshot restores slots and groups as they were
+	friend class PlayFieldSnapshot;
+public:
+	// entity id is a group type in upper bits and entity index in this group in lower bits
+	static const int EntityIndexBits = 24;
+	static inline int MakeEntityId(RaiderObjectTypeId type, int index) { return ((int)type << EntityIndexBits) | index; }
+	static inline RaiderObjectTypeId GetEntityType(int id) { return (RaiderObjectTypeId)(id >> EntityIndexBits); }
+	static inline int GetEntityIndex(int id) { return id & ((1 << EntityIndexBits) - 1); }
+private:
+	typedef struct
+	{
+		GameObject *obj;
+		// -1 if object has handle assigned but hasn't been added to its group yet
+		int entityId;
+	} ObjectSlot;
+	SlotMap<ObjectSlot> m_slots;
+	EntityGroup m_groups[RI_End];
+	void Detach(RaiderObjectTypeId type, int index);
+public:
+	~EntityStore();
+	EntityGroup& GetGroup(RaiderObjectTypeId type) { return m_groups[type]; }
+	int GetSize();
+	ObjectHandle CreateHandle(GameObject* obj);
+	// nullptr if object has been removed from the store
+	GameObject* GetObject(ObjectHandle handle);
+	// -1 if object has been removed from the store (or hasn't been added yet)
+	int GetEntityId(ObjectHandle handle);
+	// adds object (with handle already created) to the group of its type
+	void Add(GameObject* obj);
+	// releases object handle and removes its entity, the last entity of the group takes its place
+	void Remove(ObjectHandle handle);
+	// moves entity to the group of its object current type (if type has changed since it was added)
+	void Regroup(ObjectHandle handle);
+};
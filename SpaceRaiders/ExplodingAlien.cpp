@@ -2,23 +2,22 @@
 #include "stdafx.h"
 #include "ExplodingAlien.h"
 #include "PlayField.h"
+#include "WorldCommands.h"
 
 // EAExplosionCell stands for ExplodinAlien ExplosionCell
 
+// each ring of exploding alien explosion spawns dozens of cells
+ObjectPool EAExplosionCell::m_pool("EAExplosionCell", sizeof(EAExplosionCell), 256);
+
+thread_local std::vector<Vector2D> ExplodingAlien::m_newPoints;
+
 // Exploding alien explosion cells will be very strong (they shold kill any other game object with one hit),
-// they will also be resistant to any other objects
+// they will also be resistant to any other objects (see gCollisionTable)
 EAExplosionCell::EAExplosionCell(Vector2D& pos) :
 	GameObject(RI_ExplosionCell, pos, RS_ExplosionCell, 10000, 10000)
 {
-	m_collisionTypeBitmap = 0;
-}
-
-void EAExplosionCell::Update(PlayField& world)
-{
-	if (m_time-- == 0)
-	{
-		world.RemoveObject(this);
-	}
+	// cell stays for two iterations (see GameObject::UpdateTimedGroup)
+	TicksLeft() = 2;
 }
 
 void ExplodingAlien::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
@@ -27,39 +26,41 @@ void ExplodingAlien::OnObjectDestroyed(GameObject& attacker, PlayField& world, c
 	{
 		return;
 	}
-	__super::OnObjectDestroyed(attacker, world, collisionPoint);
+	Alien::OnObjectDestroyed(attacker, world, collisionPoint);
 	m_isDead = true;
-	m_isActive = true; // we will fake PlayField that we are still active so that we will still be able to respond to Update(..)
-	m_explosionStartPoint = m_pos.Floor() + Vector2D(0.5f, 0.5f); // instead of using round() later, we will just add now [0.5,0.5] vector to starting point
-	m_pos.x = m_pos.y = -1.f; // let's move this object beyond visible area
-	m_posPrev = m_pos;
+	SetActive(true); // we will fake PlayField that we are still active so that we will still be able to respond to Update(..)
+	m_explosionStartPoint = Pos().Floor() + Vector2D(0.5f, 0.5f); // instead of using round() later, we will just add now [0.5,0.5] vector to starting point
+	Pos().x = Pos().y = -1.f; // let's move this object beyond visible area
+	PosPrev() = Pos();
+	// entity will be moved to explosion cells group, where (with no ticks left) it gets Update(...) calls
 	m_objType = RI_ExplosionCell;
 }
-ExplodingAlien::ExplodingAlien(Vector2D pos, float velocityY, bool enableFriendFire) :
-	Alien(pos, velocityY, enableFriendFire)
+ExplodingAlien::ExplodingAlien(Vector2D pos, float velocityY) :
+	Alien(pos, velocityY)
 {
-	m_sprite = RS_ExplodingAlien;
+	Sprite() = RS_ExplodingAlien;
 	// exploding aliens will not be able to transform to better aliens 
 	// (we don't want to change their attributes at runtime)
 	m_isTransformationEnabled = false;
 }
 
-void ExplodingAlien::Update(PlayField& world)
+void ExplodingAlien::Update(PlayField& world, WorldCommands& commands)
 {
+	// alive exploding aliens are moved by Alien::UpdateGroup(...)
 	if (!m_isDead)
 	{
-		__super::Update(world);
 		return;
 	}
 	if (m_currExplosionRing == m_maxExplosionRing)
 	{
-		world.RemoveObject(this);
+		SetToInactive();
+		commands.RemoveObject(this);
 		return;
 	}
 	CreateCircle(m_currExplosionRing++);
 	for (auto it : m_newPoints)
 	{
-		world.AddObject(new EAExplosionCell(it));
+		commands.AddObject(new EAExplosionCell(it));
 	}
 }
 
@@ -5,30 +5,41 @@
 
 class EAExplosionCell : public GameObject
 {
-	int m_time = 1;
+	static ObjectPool m_pool;
 public:
 	EAExplosionCell(Vector2D &pos);
-	void Update(PlayField& world);
+	virtual GameObjectClass GetClass() { return GC_EAExplosionCell; }
+	static void* operator new(size_t size) { return m_pool.Allocate(size); }
+	static void operator delete(void *ptr) { m_pool.Free(ptr); }
+	static ObjectPool& GetPool() { return m_pool; }
 };
 
 
 class ExplodingAlien : public Alien
 {
+	friend class PlayFieldSnapshot;
 protected:
 	bool m_isDead = false;
 	int m_currExplosionRing = 0;
 	static const int m_maxExplosionRing = 14;
 	static const int m_positionMapX = 2 * (m_maxExplosionRing + 1);
 	static const int m_positionMapY = m_positionMapX;
-	std::vector<Vector2D> m_collisionPoints;
-	std::vector<Vector2D> m_newPoints;
+	typedef PositionMapStatic<m_positionMapX, m_positionMapY> ExplosionPositionMap;
+	// points of the ring being created, shared by aliens updated on the same thread (it is used only
+	// within Update(...)), so that each exploding alien doesn't grow its own array
+	static thread_local std::vector<Vector2D> m_newPoints;
 	Vector2D m_explosionStartPoint;
-	PositionMapStatic<m_positionMapX, m_positionMapY> m_positionMap;
+	ExplosionPositionMap m_positionMap;
 	void OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
 	static inline int MapXPosition(float x) { return (int)(x + 0.5f + (float)m_maxExplosionRing); }
 	static inline int MapYPosition(float y) { return MapXPosition(y); }
 public:
-	ExplodingAlien(Vector2D pos, float velocityY, bool enableFriendFire);
-	virtual void Update(PlayField& world);
+	// words of position map (snapshot saves them as they are)
+	static const int PositionMapWordsCount = ExplosionPositionMap::WordsCount;
+	ExplodingAlien(Vector2D pos, float velocityY);
+	virtual GameObjectClass GetClass() { return GC_ExplodingAlien; }
+	virtual void Update(PlayField& world, WorldCommands& commands);
 	void CreateCircle(int r);
+	// number of CreateCircle(...) calls (one per iteration) done by exploding alien
+	static int GetExplosionRingsCount() { return m_maxExplosionRing; }
 };
@@ -0,0 +1,132 @@
+#include "stdafx.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include "FramePacer.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <mmsystem.h>
+#endif
+
+// spinning is never shorter than that (sleep overshoots are not always visible in recent frames)
+static const double MinSpinMarginNs = 2e5;
+// and never longer than that (single overshoot of a coarse timer would make thread spin a whole core)
+static const double MaxSpinMarginNs = 2e6;
+#ifdef _WIN32
+static const UINT TimerResolutionInMs = 1;
+#endif
+
+static inline INT64 ToNs(FramePacer::Clock::duration duration)
+{
+	return (INT64)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+FramePacer::FramePacer(int stepInMs, int maxCatchUpSteps) :
+	m_step(std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(std::max(stepInMs, 0)))),
+	m_maxCatchUpSteps(maxCatchUpSteps > 0 ? maxCatchUpSteps : DefaultMaxCatchUpSteps),
+	m_accumulator(Clock::duration::zero())
+{
+#ifdef _WIN32
+	if (IsEnabled())
+	{
+		timeBeginPeriod(TimerResolutionInMs);
+	}
+#endif
+}
+
+FramePacer::~FramePacer()
+{
+#ifdef _WIN32
+	if (IsEnabled())
+	{
+		timeEndPeriod(TimerResolutionInMs);
+	}
+#endif
+}
+
+void FramePacer::WaitUntil(Clock::time_point deadline)
+{
+	auto now = Clock::now();
+	auto sleepTime = deadline - now - std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds((INT64)m_spinMarginNs));
+	if (sleepTime > Clock::duration::zero())
+	{
+		auto sleepEnd = now + sleepTime;
+		std::this_thread::sleep_for(sleepTime);
+		now = Clock::now();
+		// margin jumps up to the biggest overshoot and decays slowly
+		m_spinMarginNs = std::max((double)ToNs(now - sleepEnd) * 1.25, m_spinMarginNs * 0.98);
+		m_spinMarginNs = std::min(std::max(m_spinMarginNs, MinSpinMarginNs), MaxSpinMarginNs);
+	}
+	while (now < deadline)
+	{
+		std::this_thread::yield();
+		now = Clock::now();
+	}
+}
+
+int FramePacer::WaitForNextFrame()
+{
+	if (!IsEnabled())
+	{
+		return 1;
+	}
+	auto now = Clock::now();
+	if (!m_isStarted)
+	{
+		m_isStarted = true;
+		m_lastFrameTime = now;
+		m_deadline = now + m_step;
+	}
+	bool isDeadlineMissed = now > m_deadline;
+	WaitUntil(m_deadline);
+	now = Clock::now();
+	m_framesCount++;
+	if (isDeadlineMissed)
+	{
+		m_missedDeadlinesCount++;
+	}
+	else
+	{
+		m_wakeUpLateness.Add((UINT64)ToNs(now - m_deadline));
+	}
+
+	m_accumulator += now - m_lastFrameTime;
+	m_lastFrameTime = now;
+	INT64 steps = m_accumulator / m_step;
+	if (steps > m_maxCatchUpSteps)
+	{
+		m_droppedStepsCount += steps - m_maxCatchUpSteps;
+		m_accumulator -= (steps - m_maxCatchUpSteps) * m_step;
+		steps = m_maxCatchUpSteps;
+	}
+	m_accumulator -= steps * m_step;
+	m_catchUpStepsCount += steps > 1 ? steps - 1 : 0;
+	// next deadline is when accumulator reaches the whole step - as long as frames aren't dropped
+	// it is always start + n * step (lateness of this frame is in accumulator)
+	m_deadline = now + (m_step - m_accumulator);
+	return (int)steps;
+}
+
+void FramePacer::WriteReport(std::ostream& out)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+	char line[160];
+	std::snprintf(line, sizeof(line), "Frame pacing (%llu frames, %.1f ms step):\n",
+		(unsigned long long)m_framesCount, (double)ToNs(m_step) / 1e6);
+	out << line;
+	std::snprintf(line, sizeof(line), "%24s %10llu (%.1f%%)\n", "missed deadlines", (unsigned long long)m_missedDeadlinesCount,
+		m_framesCount > 0 ? m_missedDeadlinesCount * 100.0 / m_framesCount : 0.0);
+	out << line;
+	std::snprintf(line, sizeof(line), "%24s %10llu\n", "catch-up iterations", (unsigned long long)m_catchUpStepsCount);
+	out << line;
+	std::snprintf(line, sizeof(line), "%24s %10llu\n", "dropped iterations", (unsigned long long)m_droppedStepsCount);
+	out << line;
+	std::snprintf(line, sizeof(line), "%24s mean %.4f p50 %.4f p99 %.4f max %.4f\n", "wake-up jitter ms",
+		m_wakeUpLateness.GetMeanInMs(), m_wakeUpLateness.GetPercentileInMs(50),
+		m_wakeUpLateness.GetPercentileInMs(99), m_wakeUpLateness.GetMaxInMs());
+	out << line;
+}
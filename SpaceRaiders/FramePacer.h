@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include "FrameProfiler.h"
+
+// Fixed time step pacing of game iterations: frames are scheduled against absolute deadlines
+// (start + n * step), so time spent on update and rendering doesn't make frame rate drift.
+// Time elapsed between frames is added to accumulator which is spent in whole steps, so when
+// a frame was late, next one runs more than one iteration (up to maxCatchUpSteps, steps over
+// this limit are dropped, so that slow machine doesn't end in a spiral of catching up).
+// Waiting is a hybrid: thread sleeps until spin margin before the deadline and then spins
+// (yielding) - spin margin follows observed sleep overshoots, so it adapts to OS timer granularity
+// (it is capped, so that coarse timer doesn't turn waiting into spinning for most of the frame).
+// On Windows timer resolution is raised to 1 ms while pacer is enabled (default is 15.6 ms).
+class FramePacer
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+	static const int DefaultMaxCatchUpSteps = 5;
+private:
+	Clock::duration m_step;
+	int m_maxCatchUpSteps;
+	bool m_isStarted = false;
+	Clock::time_point m_deadline;
+	Clock::time_point m_lastFrameTime;
+	Clock::duration m_accumulator;
+	double m_spinMarginNs = 2e6;
+	// statistics
+	DurationHistogram m_wakeUpLateness;
+	UINT64 m_framesCount = 0;
+	UINT64 m_missedDeadlinesCount = 0;
+	UINT64 m_catchUpStepsCount = 0;
+	UINT64 m_droppedStepsCount = 0;
+	void WaitUntil(Clock::time_point deadline);
+public:
+	// stepInMs <= 0 disables pacing (each frame runs one step without waiting)
+	FramePacer(int stepInMs, int maxCatchUpSteps);
+	~FramePacer();
+	bool IsEnabled() { return m_step.count() > 0; }
+	// waits for deadline of the next frame and returns number of steps (iterations) to run in it
+	int WaitForNextFrame();
+	void WriteReport(std::ostream& out);
+};
@@ -0,0 +1,135 @@
+#include "stdafx.h"
+#include <cstdio>
+#include <cstring>
+#include "FramePlayer.h"
+
+bool FramePlayer::Open(const char* path)
+{
+	if (!m_file.Open(path) || m_file.GetSize() < sizeof(RecordingHeader))
+	{
+		std::printf("Error can't read recording file %s\n", path);
+		return false;
+	}
+	std::memcpy(&m_header, m_file.GetData(), sizeof(m_header));
+	if (std::memcmp(m_header.magic, RecordingMagic, sizeof(RecordingMagic)) != 0 || m_header.version != RecordingVersion
+		|| m_header.width == 0 || m_header.height == 0)
+	{
+		std::printf("Error %s isn't a recording of this game version\n", path);
+		return false;
+	}
+	m_canvas.assign(m_header.width * m_header.height, 0);
+	m_currentFrame = -1;
+	RecordingFooter footer;
+	bool hasFooter = false;
+	if (m_file.GetSize() >= sizeof(RecordingHeader) + sizeof(footer))
+	{
+		std::memcpy(&footer, m_file.GetData() + m_file.GetSize() - sizeof(footer), sizeof(footer));
+		hasFooter = std::memcmp(footer.magic, RecordingFooterMagic, sizeof(RecordingFooterMagic)) == 0
+			&& footer.indexOffset % 8 == 0
+			&& footer.indexOffset + (UINT64)footer.framesCount * sizeof(RecordingIndexEntry) + sizeof(footer) == m_file.GetSize();
+	}
+	if (hasFooter)
+	{
+		m_index = (const RecordingIndexEntry*)(m_file.GetData() + footer.indexOffset);
+		m_framesCount = footer.framesCount;
+	}
+	else
+	{
+		RebuildIndex();
+	}
+	return true;
+}
+
+void FramePlayer::RebuildIndex()
+{
+	m_rebuiltIndex.clear();
+	UINT64 offset = sizeof(RecordingHeader);
+	UINT32 keyframe = 0;
+	RecordedFrameHeader header;
+	while (offset + sizeof(header) <= m_file.GetSize())
+	{
+		std::memcpy(&header, m_file.GetData() + offset, sizeof(header));
+		UINT64 end = offset + sizeof(header) + header.stringsSize + header.canvasSize;
+		// the last frame may have been written partially (or index has been written partially after it)
+		if (end > m_file.GetSize() || (header.flags & ~(UINT32)RFF_Keyframe) != 0 || header.canvasSize == 0)
+		{
+			break;
+		}
+		if ((header.flags & RFF_Keyframe) != 0)
+		{
+			keyframe = (UINT32)m_rebuiltIndex.size();
+		}
+		m_rebuiltIndex.push_back({ offset, header.iteration, keyframe });
+		offset = end;
+	}
+	m_index = m_rebuiltIndex.data();
+	m_framesCount = (UINT32)m_rebuiltIndex.size();
+}
+
+const unsigned char* FramePlayer::GetFrameData(int frame, RecordedFrameHeader& header)
+{
+	UINT64 offset = m_index[frame].offset;
+	if (offset + sizeof(header) > m_file.GetSize())
+	{
+		return nullptr;
+	}
+	std::memcpy(&header, m_file.GetData() + offset, sizeof(header));
+	if (offset + sizeof(header) + header.stringsSize + header.canvasSize > m_file.GetSize())
+	{
+		return nullptr;
+	}
+	return m_file.GetData() + offset + sizeof(header);
+}
+
+bool FramePlayer::DecodeFrame(int frame)
+{
+	RecordedFrameHeader header;
+	const unsigned char* data = GetFrameData(frame, header);
+	if (data == nullptr)
+	{
+		return false;
+	}
+	m_decodedFramesCount++;
+	return FrameCodec::Decode(data + header.stringsSize, header.canvasSize, m_canvas.data(), (int)m_canvas.size(),
+		(header.flags & RFF_Keyframe) == 0);
+}
+
+bool FramePlayer::Seek(int frame)
+{
+	if (frame < 0 || frame >= (int)m_framesCount)
+	{
+		return false;
+	}
+	// decoding continues from current frame if it is between keyframe and requested frame
+	int keyframe = (int)m_index[frame].keyframe;
+	int from = m_currentFrame >= keyframe && m_currentFrame <= frame ? m_currentFrame + 1 : keyframe;
+	for (int i = from; i <= frame; i++)
+	{
+		if (!DecodeFrame(i))
+		{
+			m_currentFrame = -1;
+			return false;
+		}
+		m_currentFrame = i;
+	}
+	return true;
+}
+
+int FramePlayer::FindFrame(UINT32 iteration)
+{
+	// iterations grow with frames
+	int begin = 0, end = (int)m_framesCount;
+	while (begin < end)
+	{
+		int middle = (begin + end) / 2;
+		if (m_index[middle].iteration < iteration)
+		{
+			begin = middle + 1;
+		}
+		else
+		{
+			end = middle;
+		}
+	}
+	return begin;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include "MappedFile.h"
+#include "FrameRecording.h"
+
+// Reads recording written by FrameRecorder from memory mapped file. Index at the end of the file
+// gives offset and keyframe of each frame, so seeking to any frame costs decoding at most
+// keyframe interval frames (the next frame costs decoding one frame). Frames are decoded straight
+// from the mapping, nothing is read with file I/O.
+class FramePlayer
+{
+private:
+	MappedFile m_file;
+	RecordingHeader m_header;
+	// points into mapped file, or to m_rebuiltIndex if recording hasn't been closed
+	const RecordingIndexEntry* m_index = nullptr;
+	UINT32 m_framesCount = 0;
+	std::vector<RecordingIndexEntry> m_rebuiltIndex;
+	std::vector<unsigned char> m_canvas;
+	// frame which is in m_canvas, -1 if none
+	int m_currentFrame = -1;
+	UINT64 m_decodedFramesCount = 0;
+	// copies header of the frame (frames aren't aligned in the file) and returns data which
+	// follows it, nullptr if frame doesn't fit in the file
+	const unsigned char* GetFrameData(int frame, RecordedFrameHeader& header);
+	bool DecodeFrame(int frame);
+	// walks frames from the beginning of the file (recording without footer)
+	void RebuildIndex();
+public:
+	// false (with error printed) if file isn't a recording
+	bool Open(const char* path);
+	int GetFramesCount() { return (int)m_framesCount; }
+	int GetWidth() { return (int)m_header.width; }
+	int GetHeight() { return (int)m_header.height; }
+	// decodes given frame into canvas, false if frame doesn't exist or recording is corrupted
+	bool Seek(int frame);
+	int GetCurrentFrame() { return m_currentFrame; }
+	const unsigned char* GetCanvas() { return m_canvas.data(); }
+	UINT32 GetIteration() { return m_index[m_currentFrame].iteration; }
+	// first frame recorded in given iteration or later (frames count if there is none)
+	int FindFrame(UINT32 iteration);
+	// frames decoded so far (seeking decodes frames between keyframe and requested one)
+	UINT64 GetDecodedFramesCount() { return m_decodedFramesCount; }
+	// calls func(x, y, text) for each string of current frame
+	template <typename Func>
+	void ForEachString(Func func)
+	{
+		RecordedFrameHeader header;
+		const unsigned char* data = GetFrameData(m_currentFrame, header);
+		for (UINT32 i = 0; i < header.stringsCount; i++)
+		{
+			RecordedStringHeader str;
+			std::memcpy(&str, data, sizeof(str));
+			data += sizeof(str);
+			func(str.x, str.y, std::string((const char*)data, str.length));
+			data += str.length;
+		}
+	}
+};
@@ -0,0 +1,213 @@
+#include "stdafx.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "FrameProfiler.h"
+
+#ifndef NO_FRAME_PROFILER
+static const char* gProfilePhaseNames[PP_End] =
+{
+	"Input",
+	"Update",
+	"Collisions",
+	"PowerUps",
+	"CollectionChanges",
+	"GameInfo",
+	"RenderSnapshot",
+	"RenderFill",
+	"RenderRasterize",
+	"RenderDraw",
+	"RenderRecord",
+	"Tick"
+};
+#endif
+
+int DurationHistogram::GetBucket(UINT64 ns)
+{
+	if (ns < SubBuckets)
+	{
+		return (int)ns;
+	}
+	int exponent = 0;
+	for (UINT64 value = ns >> 1; value != 0; value >>= 1)
+	{
+		exponent++;
+	}
+	int bucket = (exponent - SubBucketBits + 1) * SubBuckets + (int)((ns >> (exponent - SubBucketBits)) & (SubBuckets - 1));
+	return bucket < BucketsCount ? bucket : BucketsCount - 1;
+}
+
+UINT64 DurationHistogram::GetBucketUpperBound(int bucket)
+{
+	if (bucket < SubBuckets)
+	{
+		return (UINT64)bucket;
+	}
+	int shift = bucket / SubBuckets - 1;
+	UINT64 lowerBound = (UINT64)(SubBuckets + bucket % SubBuckets) << shift;
+	return lowerBound + (1ULL << shift) - 1;
+}
+
+void DurationHistogram::Clear()
+{
+	memset(m_buckets, 0, sizeof(m_buckets));
+	m_count = 0;
+	m_sumNs = 0;
+	m_maxNs = 0;
+}
+
+void DurationHistogram::Add(const DurationHistogram& other)
+{
+	for (int i = 0; i < BucketsCount; i++)
+	{
+		m_buckets[i] += other.m_buckets[i];
+	}
+	m_count += other.m_count;
+	m_sumNs += other.m_sumNs;
+	m_maxNs = other.m_maxNs > m_maxNs ? other.m_maxNs : m_maxNs;
+}
+
+double DurationHistogram::GetPercentileInMs(double percentile) const
+{
+	if (m_count == 0)
+	{
+		return 0.0;
+	}
+	UINT64 rank = (UINT64)std::ceil(m_count * percentile / 100.0);
+	rank = rank > 0 ? rank : 1;
+	UINT64 count = 0;
+	for (int i = 0; i < BucketsCount; i++)
+	{
+		count += m_buckets[i];
+		if (count >= rank)
+		{
+			UINT64 upperBound = GetBucketUpperBound(i);
+			return (double)(upperBound < m_maxNs ? upperBound : m_maxNs) / 1e6;
+		}
+	}
+	return GetMaxInMs();
+}
+
+#ifndef NO_FRAME_PROFILER
+double FrameProfiler::MeasureClockReadNs()
+{
+	const int readsCount = 2000;
+	auto start = Clock::now();
+	for (int i = 0; i < readsCount - 1; i++)
+	{
+		Clock::now();
+	}
+	return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count() / readsCount;
+}
+
+void FrameProfiler::SetEnabled(bool isEnabled)
+{
+	m_isEnabled = isEnabled;
+	if (m_isEnabled && m_clockReadNs == 0.0)
+	{
+		m_clockReadNs = MeasureClockReadNs();
+	}
+}
+
+void FrameProfiler::BeginTick()
+{
+	EndTick();
+	m_ticksCount++;
+	m_isSampling = m_isEnabled && m_ticksToNextSample == 0;
+	if (m_isSampling)
+	{
+		m_ticksToNextSample = m_samplingPeriod - 1;
+	}
+	else if (m_ticksToNextSample > 0)
+	{
+		m_ticksToNextSample--;
+	}
+	m_tickNs = 0;
+	m_readsInTick = 0;
+}
+
+void FrameProfiler::EndTick()
+{
+	if (!m_isSampling || m_readsInTick == 0)
+	{
+		return;
+	}
+	m_isSampling = false;
+	m_total[PP_Tick].Add(m_tickNs);
+	m_window[PP_Tick].Add(m_tickNs);
+	if (m_window[PP_Tick].GetCount() >= WindowSize)
+	{
+		for (int i = 0; i < PP_End; i++)
+		{
+			m_prevWindow[i] = m_window[i];
+			m_window[i].Clear();
+		}
+	}
+	// the next tick is measured after as many ticks as needed to keep clock reads cost low
+	m_avgTickNs = m_avgTickNs == 0.0 ? (double)m_tickNs : m_avgTickNs * 0.9 + m_tickNs * 0.1;
+	double readsCostNs = m_readsInTick * m_clockReadNs;
+	double period = std::ceil(readsCostNs / (m_avgTickNs * MaxOverheadPercent / 100.0 + 1.0));
+	m_samplingPeriod = (int)(period < 1.0 ? 1.0 : (period > 1000.0 ? 1000.0 : period));
+	m_ticksToNextSample = m_samplingPeriod - 1;
+}
+
+std::string FrameProfiler::GetHudString()
+{
+	DurationHistogram window[PP_End];
+	int slowestPhase = PP_Input;
+	for (int i = 0; i < PP_End; i++)
+	{
+		window[i] = m_prevWindow[i];
+		window[i].Add(m_window[i]);
+		if (i != PP_Tick && window[i].GetPercentileInMs(99) > window[slowestPhase].GetPercentileInMs(99))
+		{
+			slowestPhase = i;
+		}
+	}
+	char buffer[128];
+	std::snprintf(buffer, sizeof(buffer), "Tick ms p50 %.3f p95 %.3f p99 %.3f max %.3f  %s p99 %.3f",
+		window[PP_Tick].GetPercentileInMs(50), window[PP_Tick].GetPercentileInMs(95),
+		window[PP_Tick].GetPercentileInMs(99), window[PP_Tick].GetMaxInMs(),
+		gProfilePhaseNames[slowestPhase], window[slowestPhase].GetPercentileInMs(99));
+	return buffer;
+}
+
+void FrameProfiler::WriteReport(std::ostream& out)
+{
+	EndTick();
+	UINT64 measuredTicks = m_total[PP_Tick].GetCount();
+	UINT64 readsCount = 0;
+	for (int i = 0; i < PP_Tick; i++)
+	{
+		readsCount += 2 * m_total[i].GetCount();
+	}
+	// overhead against time of all ticks (estimated from measured ones)
+	double allTicksNs = m_total[PP_Tick].GetMeanInMs() * 1e6 * m_ticksCount;
+	double overheadPercent = allTicksNs > 0.0 ? readsCount * m_clockReadNs * 100.0 / allTicksNs : 0.0;
+	char line[160];
+	std::snprintf(line, sizeof(line), "Frame profile (%llu of %llu ticks measured, estimated overhead %.2f%% of tick time):\n",
+		(unsigned long long)measuredTicks, (unsigned long long)m_ticksCount, overheadPercent);
+	out << line;
+	std::snprintf(line, sizeof(line), "%18s %10s %10s %10s %10s %10s %10s\n",
+		"phase", "samples", "mean ms", "p50 ms", "p95 ms", "p99 ms", "max ms");
+	out << line;
+	for (int i = 0; i < PP_End; i++)
+	{
+		const DurationHistogram& histogram = m_total[i];
+		if (histogram.GetCount() == 0)
+		{
+			continue;
+		}
+		std::snprintf(line, sizeof(line), "%18s %10llu %10.4f %10.4f %10.4f %10.4f %10.4f\n",
+			gProfilePhaseNames[i], (unsigned long long)histogram.GetCount(), histogram.GetMeanInMs(),
+			histogram.GetPercentileInMs(50), histogram.GetPercentileInMs(95),
+			histogram.GetPercentileInMs(99), histogram.GetMaxInMs());
+		out << line;
+	}
+}
+#else
+void FrameProfiler::WriteReport(std::ostream& out)
+{
+	out << "Frame profiler is compiled out (NO_FRAME_PROFILER is defined)\n";
+}
+#endif
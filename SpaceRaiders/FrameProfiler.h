@@ -0,0 +1,162 @@
+#pragma once
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include "IntTypes.h"
+
+// Phases of game iteration (tick) measured by FrameProfiler
+typedef enum
+{
+	PP_Input = 0,
+	PP_Update,
+	PP_Collisions,
+	PP_PowerUps,
+	PP_CollectionChanges,
+	PP_GameInfo,
+	PP_RenderSnapshot,
+	PP_RenderFill,
+	PP_RenderRasterize,
+	PP_RenderDraw,
+	// copying frame to FrameRecorder
+	PP_RenderRecord,
+	// sum of all phases measured in the tick
+	PP_Tick,
+	PP_End
+} ProfilePhase;
+
+// Histogram of durations with logarithmic buckets, each power of two range is split
+// into SubBuckets linear buckets (so percentiles are accurate to 1/SubBuckets).
+class DurationHistogram
+{
+public:
+	static const int SubBucketBits = 4;
+	static const int SubBuckets = 1 << SubBucketBits;
+	// durations up to 2^40 ns (~18 minutes), longer ones are counted in the last bucket
+	static const int BucketsCount = (40 - SubBucketBits + 1) * SubBuckets + SubBuckets;
+private:
+	UINT32 m_buckets[BucketsCount];
+	UINT64 m_count;
+	UINT64 m_sumNs;
+	UINT64 m_maxNs;
+	static int GetBucket(UINT64 ns);
+	// the highest duration counted in given bucket
+	static UINT64 GetBucketUpperBound(int bucket);
+public:
+	DurationHistogram() { Clear(); }
+	void Clear();
+	inline void Add(UINT64 ns)
+	{
+		m_buckets[GetBucket(ns)]++;
+		m_count++;
+		m_sumNs += ns;
+		m_maxNs = ns > m_maxNs ? ns : m_maxNs;
+	}
+	void Add(const DurationHistogram& other);
+	UINT64 GetCount() const { return m_count; }
+	double GetMeanInMs() const { return m_count > 0 ? (double)m_sumNs / m_count / 1e6 : 0.0; }
+	double GetMaxInMs() const { return (double)m_maxNs / 1e6; }
+	// percentile in (0, 100], value is upper bound of the bucket (but not more than max)
+	double GetPercentileInMs(double percentile) const;
+};
+
+// FrameProfiler collects durations of tick phases (see ProfilePhase) in histograms: one for
+// the whole run (end of run report) and rolling one with about last WindowSize samples
+// of each phase (HUD). Phases are measured by PROFILE_SCOPE(...) timers.
+// Clock reads are not free compared to cheap ticks (i.e. headless game with a few objects),
+// so only every n-th tick is measured - n is chosen after each measured tick so that
+// estimated cost of clock reads stays below MaxOverheadPercent of tick time.
+// Define NO_FRAME_PROFILER to compile timers out (macros below expand to nothing and profiler
+// is replaced by stateless stub, so that objects owning it don't carry its histograms).
+#ifndef NO_FRAME_PROFILER
+class FrameProfiler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+	static const int WindowSize = 512;
+	static constexpr double MaxOverheadPercent = 0.5;
+private:
+	bool m_isEnabled = false;
+	bool m_isSampling = false;
+	// histograms of all samples and of current and previous rolling window
+	DurationHistogram m_total[PP_End];
+	DurationHistogram m_window[PP_End];
+	DurationHistogram m_prevWindow[PP_End];
+	UINT64 m_tickNs = 0;
+	int m_readsInTick = 0;
+	UINT64 m_ticksCount = 0;
+	UINT64 m_ticksToNextSample = 0;
+	int m_samplingPeriod = 1;
+	// moving average of measured tick duration
+	double m_avgTickNs = 0.0;
+	// cost of single Clock::now() call, measured when profiler is enabled
+	double m_clockReadNs = 0.0;
+	void EndTick();
+	static double MeasureClockReadNs();
+public:
+	void SetEnabled(bool isEnabled);
+	bool IsEnabled() { return m_isEnabled; }
+	// decides whether the tick is measured (has to be called at the beginning of each tick)
+	void BeginTick();
+	inline bool IsSampling() { return m_isSampling; }
+	inline void Record(ProfilePhase phase, Clock::duration duration)
+	{
+		UINT64 ns = (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+		m_total[phase].Add(ns);
+		m_window[phase].Add(ns);
+		m_tickNs += ns;
+		m_readsInTick += 2;
+	}
+	// "tick p50/p95/p99/max" of rolling window and the phase with the highest p99
+	std::string GetHudString();
+	void WriteReport(std::ostream& out);
+};
+
+// measures time from its construction till the end of its scope
+class ProfileScope
+{
+private:
+	FrameProfiler& m_profiler;
+	ProfilePhase m_phase;
+	FrameProfiler::Clock::time_point m_start;
+public:
+	ProfileScope(FrameProfiler& profiler, ProfilePhase phase) : m_profiler(profiler), m_phase(phase)
+	{
+		if (m_profiler.IsSampling())
+		{
+			m_start = FrameProfiler::Clock::now();
+		}
+	}
+	~ProfileScope()
+	{
+		if (m_profiler.IsSampling())
+		{
+			m_profiler.Record(m_phase, FrameProfiler::Clock::now() - m_start);
+		}
+	}
+};
+
+#else
+// stub of compiled out profiler: the same interface without any state
+class FrameProfiler
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+	void SetEnabled(bool isEnabled) {}
+	bool IsEnabled() { return false; }
+	void BeginTick() {}
+	inline bool IsSampling() { return false; }
+	std::string GetHudString() { return "Frame profiler is compiled out"; }
+	void WriteReport(std::ostream& out);
+};
+#endif
+
+#ifdef NO_FRAME_PROFILER
+#define PROFILE_BEGIN_TICK(profiler)
+#define PROFILE_SCOPE(profiler, phase)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_BEGIN_TICK(profiler) (profiler).BeginTick()
+#define PROFILE_SCOPE(profiler, phase) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)((profiler), (phase))
+#endif
@@ -0,0 +1,177 @@
+#include "stdafx.h"
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include "FrameRecorder.h"
+
+// defined, because wait_for() takes it by reference
+const int FrameRecorder::PollIntervalMs;
+
+FrameRecorder::FrameRecorder() : m_frames(RingCapacity)
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+	Close();
+}
+
+bool FrameRecorder::Open(const char* path, int width, int height, int keyframeInterval)
+{
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file)
+	{
+		std::printf("Error can't create recording file %s\n", path);
+		return false;
+	}
+	std::memcpy(m_header.magic, RecordingMagic, sizeof(m_header.magic));
+	m_header.version = RecordingVersion;
+	m_header.width = width;
+	m_header.height = height;
+	m_header.keyframeInterval = keyframeInterval > 0 ? keyframeInterval : DefaultKeyframeInterval;
+	m_header.reserved = 0;
+	Write(&m_header, sizeof(m_header));
+	m_canvasSize = width * height;
+	// ring slots and encoder buffers are allocated once, so recording doesn't allocate memory
+	for (size_t i = 0; i < m_frames.GetCapacity(); i++)
+	{
+		m_frames.GetSlot(i).canvas.resize(m_canvasSize);
+		m_frames.GetSlot(i).strings.reserve(256);
+	}
+	m_prevCanvas.resize(m_canvasSize);
+	// (the worst case of RLE is a literal control byte per MaxLiteral cells)
+	m_encoded.reserve(m_canvasSize + m_canvasSize / FrameCodec::MaxLiteral + 1);
+	m_thread = std::thread(&FrameRecorder::Loop, this);
+	return true;
+}
+
+void FrameRecorder::AddFrame(const unsigned char* canvas, const WorldSnapshot& snapshot)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	PendingFrame* frame = m_frames.BeginPush();
+	if (frame == nullptr)
+	{
+		m_stallsCount++;
+		WakeUpRecorderThread();
+		// recorder thread frees a slot as soon as it writes a frame
+		while ((frame = m_frames.BeginPush()) == nullptr)
+		{
+			std::this_thread::yield();
+		}
+	}
+	frame->iteration = snapshot.iteration;
+	std::memcpy(frame->canvas.data(), canvas, m_canvasSize);
+	frame->stringsCount = snapshot.stringsCount;
+	frame->strings.clear();
+	for (int i = 0; i < snapshot.stringsCount; i++)
+	{
+		const SnapshotString& str = snapshot.strings[i];
+		RecordedStringHeader header = { str.x, str.y, (UINT32)str.text.size() };
+		const unsigned char* headerBytes = (const unsigned char*)&header;
+		frame->strings.insert(frame->strings.end(), headerBytes, headerBytes + sizeof(header));
+		frame->strings.insert(frame->strings.end(), str.text.begin(), str.text.end());
+	}
+	m_frames.EndPush();
+	if (m_frames.GetCount() == m_frames.GetCapacity() / 2)
+	{
+		WakeUpRecorderThread();
+	}
+	m_addedCount++;
+	m_addTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void FrameRecorder::WakeUpRecorderThread()
+{
+	// (mutex is locked only so that wake up can't be missed between recorder thread check and wait)
+	{
+		std::lock_guard<std::mutex> lock(m_wakeUpMutex);
+	}
+	m_wakeUpCondition.notify_one();
+}
+
+void FrameRecorder::Loop()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_wakeUpMutex);
+			m_wakeUpCondition.wait_for(lock, std::chrono::milliseconds(PollIntervalMs),
+				[this]() { return m_isStopping || m_frames.GetCount() >= m_frames.GetCapacity() / 2; });
+			// all added frames are written before stopping
+			if (m_isStopping && m_frames.IsEmpty())
+			{
+				return;
+			}
+		}
+		while (PendingFrame* frame = m_frames.Front())
+		{
+			WriteFrame(*frame);
+			m_frames.Pop();
+		}
+	}
+}
+
+void FrameRecorder::WriteFrame(const PendingFrame& frame)
+{
+	UINT32 frameIndex = (UINT32)m_index.size();
+	bool isKeyframe = frameIndex % m_header.keyframeInterval == 0;
+	if (isKeyframe)
+	{
+		m_lastKeyframe = frameIndex;
+	}
+	m_encoded.clear();
+	FrameCodec::Encode(frame.canvas.data(), isKeyframe ? nullptr : m_prevCanvas.data(), m_canvasSize, m_encoded);
+	std::memcpy(m_prevCanvas.data(), frame.canvas.data(), m_canvasSize);
+
+	RecordedFrameHeader header = { frame.iteration, isKeyframe ? (UINT32)RFF_Keyframe : 0u, frame.stringsCount,
+		(UINT32)frame.strings.size(), (UINT32)m_encoded.size() };
+	m_index.push_back({ m_fileOffset, frame.iteration, m_lastKeyframe });
+	Write(&header, sizeof(header));
+	Write(frame.strings.data(), frame.strings.size());
+	Write(m_encoded.data(), m_encoded.size());
+}
+
+void FrameRecorder::Write(const void* data, size_t size)
+{
+	m_file.write((const char*)data, size);
+	m_fileOffset += size;
+	if (!m_file)
+	{
+		m_isWriteFailed = true;
+	}
+}
+
+void FrameRecorder::Close()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_wakeUpMutex);
+		m_isStopping = true;
+	}
+	m_wakeUpCondition.notify_one();
+	m_thread.join();
+	// index is 8 byte aligned, so that player can use it in place from mapped file
+	static const char padding[8] = {};
+	Write(padding, (size_t)((8 - m_fileOffset % 8) % 8));
+	RecordingFooter footer = { m_fileOffset, (UINT32)m_index.size(), {} };
+	std::memcpy(footer.magic, RecordingFooterMagic, sizeof(footer.magic));
+	Write(m_index.data(), m_index.size() * sizeof(RecordingIndexEntry));
+	Write(&footer, sizeof(footer));
+	m_file.close();
+}
+
+void FrameRecorder::WriteReport(std::ostream& out)
+{
+	UINT64 rawBytes = (UINT64)m_index.size() * m_canvasSize;
+	char line[256];
+	std::snprintf(line, sizeof(line), "Recording: %u frames, %llu bytes (%.1f bytes per frame, %.1fx smaller than raw canvases)%s\n",
+		(unsigned)m_index.size(), (unsigned long long)m_fileOffset, m_index.empty() ? 0.0 : (double)m_fileOffset / m_index.size(),
+		m_fileOffset > 0 ? (double)rawBytes / m_fileOffset : 0.0, m_isWriteFailed ? ", WRITE FAILED" : "");
+	out << line;
+	std::snprintf(line, sizeof(line), "           AddFrame %.2f us mean, waited for recorder thread %llu times\n",
+		m_addedCount > 0 ? m_addTimeNs / 1e3 / m_addedCount : 0.0, (unsigned long long)m_stallsCount);
+	out << line;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <ostream>
+#include <vector>
+#include "SpscRing.h"
+#include "RenderSnapshot.h"
+#include "FrameRecording.h"
+
+// Records drawn frames into a file (available through --record cmd parameter, format is described
+// in FrameRecording.h). AddFrame(...) only copies canvas and strings into a free slot of lock-free
+// ring, frames are encoded and written by recorder's own thread, so recording costs the thread which
+// draws frames a memcpy of the canvas. Recorder thread wakes up every PollIntervalMs, or earlier when
+// half of the ring is used, so that adding a frame doesn't have to wake it up (system call) each time.
+// When the ring is full (disk is slower than the game) the thread which adds frames waits for a free
+// slot, frames are never dropped.
+class FrameRecorder
+{
+private:
+	typedef struct
+	{
+		UINT32 iteration;
+		UINT32 stringsCount;
+		std::vector<unsigned char> canvas;
+		// strings serialized like in the file (RecordedStringHeader and chars)
+		std::vector<unsigned char> strings;
+	} PendingFrame;
+	static const int RingCapacity = 64;
+	static const int PollIntervalMs = 20;
+	SpscRing<PendingFrame> m_frames;
+	std::ofstream m_file;
+	RecordingHeader m_header;
+	int m_canvasSize = 0;
+	std::thread m_thread;
+	std::mutex m_wakeUpMutex;
+	std::condition_variable m_wakeUpCondition;
+	bool m_isStopping = false;
+	// owned by recorder thread
+	std::vector<unsigned char> m_prevCanvas;
+	std::vector<unsigned char> m_encoded;
+	std::vector<RecordingIndexEntry> m_index;
+	UINT64 m_fileOffset = 0;
+	UINT32 m_lastKeyframe = 0;
+	bool m_isWriteFailed = false;
+	// counted by thread which adds frames
+	UINT64 m_addedCount = 0;
+	UINT64 m_stallsCount = 0;
+	UINT64 m_addTimeNs = 0;
+	void Loop();
+	void WakeUpRecorderThread();
+	void WriteFrame(const PendingFrame& frame);
+	void Write(const void* data, size_t size);
+public:
+	static const int DefaultKeyframeInterval = 100;
+	FrameRecorder();
+	~FrameRecorder();
+	// creates the file and starts recorder thread, false (with error printed) if file can't be created
+	bool Open(const char* path, int width, int height, int keyframeInterval = DefaultKeyframeInterval);
+	bool IsOpen() { return m_thread.joinable(); }
+	// canvas has width * height cells, strings are taken from the snapshot it has been drawn from
+	void AddFrame(const unsigned char* canvas, const WorldSnapshot& snapshot);
+	// waits till all added frames are written, writes index and closes the file
+	void Close();
+	// frames, file size and compression ratio, time spent in AddFrame(...)
+	void WriteReport(std::ostream& out);
+};
@@ -0,0 +1,114 @@
+#include "stdafx.h"
+#include <cstring>
+#include "FrameRecording.h"
+
+static void AppendLiterals(const unsigned char* cells, int count, std::vector<unsigned char>& out)
+{
+	while (count > 0)
+	{
+		int chunk = count < FrameCodec::MaxLiteral ? count : FrameCodec::MaxLiteral;
+		out.push_back((unsigned char)(chunk - 1));
+		out.insert(out.end(), cells, cells + chunk);
+		cells += chunk;
+		count -= chunk;
+	}
+}
+
+void FrameCodec::Encode(const unsigned char* canvas, const unsigned char* prevCanvas, int size, std::vector<unsigned char>& out)
+{
+	// literals are XORed into this buffer, so that they can be appended at once
+	unsigned char literals[MaxLiteral];
+	int literalsCount = 0;
+	int i = 0;
+	while (i < size)
+	{
+		unsigned char value = prevCanvas != nullptr ? canvas[i] ^ prevCanvas[i] : canvas[i];
+		int run = 1;
+		if (prevCanvas != nullptr)
+		{
+			for (; i + run < size && run < MaxRun && (canvas[i + run] ^ prevCanvas[i + run]) == value; run++);
+		}
+		else
+		{
+			for (; i + run < size && run < MaxRun && canvas[i + run] == value; run++);
+		}
+		if (run >= MinRun)
+		{
+			AppendLiterals(literals, literalsCount, out);
+			literalsCount = 0;
+			out.push_back((unsigned char)(128 + run - MinRun));
+			out.push_back(value);
+		}
+		else
+		{
+			for (int j = 0; j < run; j++)
+			{
+				if (literalsCount == MaxLiteral)
+				{
+					AppendLiterals(literals, literalsCount, out);
+					literalsCount = 0;
+				}
+				literals[literalsCount++] = value;
+			}
+		}
+		i += run;
+	}
+	AppendLiterals(literals, literalsCount, out);
+}
+
+bool FrameCodec::Decode(const unsigned char* data, size_t dataSize, unsigned char* canvas, int size, bool isDelta)
+{
+	const unsigned char* end = data + dataSize;
+	int i = 0;
+	while (data < end)
+	{
+		int control = *data++;
+		if (control < 128)
+		{
+			int count = control + 1;
+			if (end - data < count || size - i < count)
+			{
+				return false;
+			}
+			if (isDelta)
+			{
+				for (int j = 0; j < count; j++)
+				{
+					canvas[i + j] ^= data[j];
+				}
+			}
+			else
+			{
+				std::memcpy(canvas + i, data, count);
+			}
+			data += count;
+			i += count;
+		}
+		else
+		{
+			int count = control - 128 + MinRun;
+			if (data == end || size - i < count)
+			{
+				return false;
+			}
+			unsigned char value = *data++;
+			if (isDelta)
+			{
+				// (runs of zeros are unchanged cells)
+				if (value != 0)
+				{
+					for (int j = 0; j < count; j++)
+					{
+						canvas[i + j] ^= value;
+					}
+				}
+			}
+			else
+			{
+				std::memset(canvas + i, value, count);
+			}
+			i += count;
+		}
+	}
+	return i == size;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include "IntTypes.h"
+
+// File format of recorded frames (see FrameRecorder and FramePlayer), little endian:
+//   RecordingHeader
+//   frames: RecordedFrameHeader, strings (RecordedStringHeader and its chars for each string), canvas
+//   index: RecordingIndexEntry for each frame (8 byte aligned)
+//   RecordingFooter
+// Frames are written as they come, so recording which hasn't been closed (i.e. after a crash) has
+// no index and footer - player rebuilds index by walking frames then. Canvas of a keyframe is RLE
+// encoded as it is, canvas of other frames is XORed with the previous frame first (unchanged cells
+// become zeros, which RLE encodes as long runs). Strings (game info and score lines) are stored
+// as text besides the canvas they have been drawn on, so that tools don't have to read them from cells.
+static const char RecordingMagic[4] = { 'S', 'R', 'F', 'R' };
+static const char RecordingFooterMagic[4] = { 'S', 'R', 'F', 'I' };
+static const UINT32 RecordingVersion = 1;
+
+typedef struct
+{
+	char magic[4];
+	UINT32 version;
+	UINT32 width;
+	UINT32 height;
+	UINT32 keyframeInterval;
+	UINT32 reserved;
+} RecordingHeader;
+
+typedef enum
+{
+	RFF_Keyframe = 1
+} RecordedFrameFlags;
+
+typedef struct
+{
+	UINT32 iteration;
+	UINT32 flags;
+	UINT32 stringsCount;
+	// bytes of strings block and of encoded canvas which follow this header
+	UINT32 stringsSize;
+	UINT32 canvasSize;
+} RecordedFrameHeader;
+
+typedef struct
+{
+	short x;
+	short y;
+	UINT32 length;
+} RecordedStringHeader;
+
+typedef struct
+{
+	UINT64 offset;
+	UINT32 iteration;
+	// frame from which decoding has to start to get this one
+	UINT32 keyframe;
+} RecordingIndexEntry;
+
+typedef struct
+{
+	UINT64 indexOffset;
+	UINT32 framesCount;
+	char magic[4];
+} RecordingFooter;
+
+// PackBits-like RLE of canvas cells: control byte c < 128 is followed by c + 1 literal cells,
+// c >= 128 by one cell repeated c - 128 + MinRun times
+class FrameCodec
+{
+public:
+	static const int MinRun = 3;
+	static const int MaxRun = 127 + MinRun;
+	static const int MaxLiteral = 128;
+	// appends encoded cells to out, cells are XORed with prevCanvas if it isn't nullptr
+	static void Encode(const unsigned char* canvas, const unsigned char* prevCanvas, int size, std::vector<unsigned char>& out);
+	// decodes size cells into canvas (XORing them with what canvas contains if isDelta),
+	// false if data is corrupted (doesn't decode to exactly size cells)
+	static bool Decode(const unsigned char* data, size_t dataSize, unsigned char* canvas, int size, bool isDelta);
+};
@@ -1,8 +1,12 @@
 
 #include "stdafx.h"
+#include <algorithm>
+#include <cmath>
 #include "GameObjects.h"
 #include "PlayField.h"
-#include "Renderer.h"
+#include "CollisionResponse.h"
+#include "WorldCommands.h"
+#include "EntityStore.h"
 
 static GameObjectInfo gGameObjectsInfoArr[] =
 {
@@ -11,7 +15,9 @@ static GameObjectInfo gGameObjectsInfoArr[] =
 	{ RS_PlayerLaser,	"ot_PlayerLaser"	},
 	{ RS_AlienLaser,	"ot_AlienLaser"		},
 	{ RS_Explosion,		"ot_Explosion"		},
-	{ RS_WallBlock,		"ot_WallBlock"		}
+	{ RS_WallBlock,		"ot_WallBlock"		},
+	{ RS_PowerUp,		"ot_PowerUp"		},
+	{ RS_ExplosionCell,	"ot_ExplosionCell"	}
 };
 
 GameObjectInfo* getObjectInfo(RaiderObjectTypeId objectTypeId)
@@ -25,104 +31,75 @@ GameObjectInfo* getObjectInfo(RaiderObjectTypeId objectTypeId)
 }
 
 GameObject::GameObject(RaiderObjectTypeId objectType, Vector2D pos, unsigned char sprite, int health, int strikeForce) :
-	m_isActive(true),
 	m_objType(objectType),
-	m_pos(pos),
-	m_posPrev(pos),
 	m_strikeForce(strikeForce),
-	m_health(health),
 	m_isAutoDelete(true)
 {
 	GameObjectInfo *info = getObjectInfo(objectType);
-	m_sprite = sprite == RS_TakeDefault ? (char)info->sprite : sprite;
+	m_data.pos = pos;
+	m_data.posPrev = pos;
+	m_data.health = health;
+	m_data.ticksLeft = 0;
+	m_data.sprite = sprite == RS_TakeDefault ? (char)info->sprite : sprite;
+	m_data.isActive = true;
 	m_name = info->name;
 }
 
-// by default, object potential collision points (cells that are added to collision map)
-// are its current position and its previous position (if it is not equal to its current position)
-void GameObject::GetCollisionPoints(std::vector<Vector2D>& collisionVectorOut)
+void GameObject::UpdateEachObject(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands)
 {
-	collisionVectorOut.push_back(m_pos);
-	if (!(m_pos.IntCmp(m_posPrev)))
+	for (int i = begin; i < end; i++)
 	{
-		collisionVectorOut.push_back(m_posPrev);
+		if (group.isActive[i])
+		{
+			group.objects[i]->Update(world, commands);
+		}
 	}
 }
 
-UINT32 GameObject::SetupCollidingObjects(std::initializer_list<RaiderObjectTypeId> l)
+void GameObject::UpdateTimedGroup(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands)
 {
-	UINT32 retVal = 0;
-	for (auto it : l)
+	for (int i = begin; i < end; i++)
 	{
-		retVal |= (1 << (int)it);
+		if (!group.isActive[i])
+		{
+			continue;
+		}
+		if (group.ticksLeft[i] == 0)
+		{
+			// (i.e. exploding alien which is spreading its explosion)
+			group.objects[i]->Update(world, commands);
+		}
+		else if (--group.ticksLeft[i] == 0)
+		{
+			group.isActive[i] = 0;
+			commands.RemoveObject(group.objects[i]);
+		}
 	}
-	return retVal;
 }
 
-void GameObject::OnObjectStriked(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
-{
-	m_health -= attacker.m_strikeForce;
-	if (m_health <= 0)
-	{
-		world.RemoveObject(this);
-		OnObjectDestroyed(attacker, world, collisionPoint);
-	}
-}
+ObjectPool Explosion::m_pool("Explosion", sizeof(Explosion), 64);
 
-void GameObject::CheckCollision(GameObject& other, PlayField& world, const Vector2D& collisionPoint)
+Explosion::Explosion(Vector2D pos) : GameObject(RI_Explosion, pos, RS_Explosion, 0, 0)
 {
-	if (IsCollidingWithObject(other))
-	{
-		OnObjectStriked(other, world, collisionPoint);
-	}
+	TicksLeft() = 5;
 }
 
-Explosion::Explosion(Vector2D pos) : GameObject(RI_Explosion, pos, RS_Explosion, 0, 0) {}
-
-void Explosion::Update(PlayField& world)
-{
-	m_timer--;
-	if (!m_timer)
-	{
-		world.RemoveObject(this);
-	}
-}
+ObjectPool Laser::m_pool("Laser", std::max({ sizeof(AlienLaser), sizeof(StrongAlienLaser),
+	sizeof(PlayerLaser), sizeof(PlayerLaserLR) }), 64);
 
 Laser::Laser(RaiderObjectTypeId objectType, 
 	Vector2D pos, 
 	Vector2D direction, 
-	unsigned char sprite, 
-	IsObjectValidFunc isValidFunc) 
+	unsigned char sprite) 
 	:
-	GameObject(objectType, pos, sprite, 1, 1),
-	m_direction(direction),
-	m_isValidFunc(isValidFunc)
+	GameObject(objectType, pos, sprite, 1, 1)
 {
-	// declaring colTypes as static ensures that
-	// SetupCollidingObjects will be invoked only once
-	// which should be a performance improvement
-	// (the same pattern applies to all other game object types)
-	static UINT32 colTypes = SetupCollidingObjects({ RI_AlienLaser, RI_PlayerLaser,
-		RI_Player, RI_Alien, RI_WallBlock, RI_ExplosionCell});
-	m_collisionTypeBitmap = colTypes;
-}
-
-void Laser::OnObjectStriked(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
-{
-	// let's assume that player lasers cannot hit player lasers
-	// and alien lasers cannot hit alien lasers
-	// (without this, if they move the same direction
-	// and are very close to each other, they may mistakenly
-	// by treated as collided when they occupy the same cell)
-	if (attacker.GetType() != m_objType)
-	{
-		__super::OnObjectStriked(attacker, world, collisionPoint);
-	}
+	Velocity() = direction;
 }
 
 void Laser::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint) 
 {
-	m_pos = collisionPoint;
+	Pos() = collisionPoint;
 	// there may be a situation in which there are 2 explosions on the same location
 	// (both colliding parties generated explosion) but this shouldn't be a problem
 	// since Exposion doesn't have any game behaviour side effects except exposing 
@@ -131,246 +108,305 @@ void Laser::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vect
 	world.DespawnLaser(this); 
 }
 
-void Laser::Update(PlayField& world)
+void Laser::UpdateGroup(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands)
 {
-	m_posPrev = m_pos;
-	m_pos += m_direction;
-	// check if laser is not beyound acceptable area
-	if (!m_isValidFunc(*this, world))
+	// all lasers are flying up or down (player lasers left-right also sideways) from a point
+	// inside of play field, so it's enough to check all play field borders for each of them
+	float maxX = world.GetBounds().x - 1;
+	float maxY = world.GetBounds().y;
+	for (int i = begin; i < end; i++)
 	{
-		world.RemoveObject(this);
-		world.DespawnLaser(this);
+		if (!group.isActive[i])
+		{
+			continue;
+		}
+		Vector2D& pos = group.pos[i];
+		group.posPrev[i] = pos;
+		pos += group.velocity[i];
+		// check if laser is not beyound acceptable area
+		if (pos.x < 0 || pos.y < 0 || pos.x > maxX || pos.y > maxY)
+		{
+			group.isActive[i] = 0;
+			commands.DespawnLaser(group.objects[i]);
+			commands.RemoveObject(group.objects[i]);
+		}
 	}
 }
 
 AlienLaser::AlienLaser(GameObject *parent) :
-	Laser(RI_AlienLaser, parent->GetPos() + Vector2D(0, 1), Vector2D(0, 1), RS_TakeDefault,
-		[](GameObject& obj, PlayField& world)->bool { return obj.GetPos().y <= world.GetBounds().y; })
+	Laser(RI_AlienLaser, parent->GetPos() + Vector2D(0, 1), Vector2D(0, 1), RS_TakeDefault)
 {}
 
 StrongAlienLaser::StrongAlienLaser(GameObject *parent) :
 	AlienLaser(parent)
 {
 	// PlayerShip lasers will not be able to destroy strong alien lasers
-	// (unlike usual alien lasers)
-	UnsetCollidingObject(RI_PlayerLaser);
-	m_strikeForce = 5;
-	m_sprite = RS_StrongAlienLaser;
+	// (unlike usual alien lasers), see CollisionResponse::IsStrongLaser(...)
+	m_strikeForce = CollisionResponse::StrongLaserStrikeForce;
+	Sprite() = RS_StrongAlienLaser;
 }
 
 PlayerLaser::PlayerLaser(GameObject *parent) :
-	Laser(RI_PlayerLaser, parent->GetPos() + Vector2D(0, -1), Vector2D(0, -1), RS_TakeDefault,
-		[](GameObject& obj, PlayField& world)->bool { return obj.GetPos().y >= 0; })
+	Laser(RI_PlayerLaser, parent->GetPos() + Vector2D(0, -1), Vector2D(0, -1), RS_TakeDefault)
 {}
 
 PlayerLaserLR::PlayerLaserLR(GameObject *parent, bool isLeft) : 
-	Laser(RI_PlayerLaser, parent->GetPos().Floor() + Vector2D(0, -1), Vector2D(0, 0), RS_PlayerLaserLR,
-		[](GameObject& obj, PlayField& world)->bool 
-			{ return obj.GetPos().y >= 0 && obj.GetPos().x >= 0 && obj.GetPos().x <= world.GetBounds().x - 1; })
+	Laser(RI_PlayerLaser, parent->GetPos().Floor() + Vector2D(0, -1), Vector2D(0, 0), RS_PlayerLaserLR)
 {
 	// if left/right lasers would have speed (-1/1,-1), then
 	// their relative speed would be higher then
 	// straight laser speed, lets avoid that by dividing
 	// such vector by sqrt(2.f)
 	float speed = 1.f/sqrt(2.f);
-	m_direction = Vector2D(isLeft ? -speed : speed, -speed);
-	m_pos.x += isLeft ? -1 : 1;
+	Velocity() = Vector2D(isLeft ? -speed : speed, -speed);
+	Pos().x += isLeft ? -1 : 1;
 
 }
 
 void SpaceShip::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
 { 
-	m_pos = collisionPoint;
+	Pos() = collisionPoint;
 	if (attacker.GetPosPrev().x == attacker.GetPos().x)
 	{
 		// to avoid confusing impression that laser striked space ship
 		// at wrong x position (Explosion doesn't cross laser path)
 		// we are setting space ship x point to laser x point
-		m_pos.x = attacker.GetPos().x;
+		Pos().x = attacker.GetPos().x;
 	}
 	world.AddObject(new Explosion(collisionPoint));
 }
 
-Alien::Alien(Vector2D pos, float velocityY, bool enableFriendFire) : 
-	SpaceShip(RI_Alien, pos, RS_TakeDefault, 1, 10),
-	m_velocityY(velocityY)
+Alien::Alien(Vector2D pos, float velocityY) : 
+	SpaceShip(RI_Alien, pos, RS_TakeDefault, 1, 10)
 {
-	static UINT32 colTypes = SetupCollidingObjects(
-		{ RI_AlienLaser, RI_PlayerLaser, RI_Player, RI_ExplosionCell });
-	m_collisionTypeBitmap = colTypes;
-	if (!enableFriendFire)
-	{
-		UnsetCollidingObject(RI_AlienLaser);
-	}
+	Velocity() = Vector2D(0.5f, velocityY);
+}
+
+void Alien::OnAddedToWorld(PlayField& world)
+{
+	RandomStream random = world.GetRandom().GetStream(GetHandle(), RP_AlienSpawn);
 	// we will randomize transform energy so that aliens
 	// will not transform to better aliens in waves
-	floatRand updateRate(0.f, 4.f);
-	m_transformEnergy = updateRate(rGen) + 1.f;
+	m_transformEnergy = random.GetFloat(0.f, 4.f) + 1.f;
 	// as well as direction to avoid all aliens going the same direction at spawn time
-	m_direction = updateRate(rGen) < 2.f ? 1.f : -1.f;
+	if (random.GetFloat(0.f, 4.f) >= 2.f)
+	{
+		Velocity().x = -Velocity().x;
+	}
+	UINT32 tick = world.GetIteration();
+	ScheduleFire(world, tick, random);
+	if (m_isTransformationEnabled)
+	{
+		ScheduleTransformAttempt(world, tick, random);
+	}
 }
 
 void Alien::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
 {
-	m_pos = collisionPoint;
+	Pos() = collisionPoint;
 	if (attacker.GetType() == RI_PlayerLaser)
 	{
 		// 10 points for normal aliens and 20 for better aliens
 		world.AddScore(m_state == as_Normal ? 10 : 20);
 	}
-	__super::OnObjectDestroyed(attacker, world, collisionPoint);
+	SpaceShip::OnObjectDestroyed(attacker, world, collisionPoint);
 	world.NotifyAlienDestroyed();
 	// add power-up with 10% prob.
-	if (getRandInt(0, 9) == 0)
+	RandomStream random = world.GetRandom().GetStream(GetHandle(), RP_PowerUpDrop);
+	if (random.GetInt(0, 9) == 0)
 	{
-		world.AddPowerUp(m_pos);
+		world.AddPowerUp(Pos(), random);
 	}
 }
 
 void Alien::Transform()
 {
 	m_state = as_Better;
-	m_sprite = RS_BetterAlien;
-	m_velocityX *= 2.f;
+	Sprite() = RS_BetterAlien;
 	// I decided to preserve the direction vector of normal alien
 	// so I have to also increase y direction velocity
-	m_velocityY *= 2.f;
-	m_health *= 2;
+	Velocity().x *= 2.f;
+	Velocity().y *= 2.f;
+	Health() *= 2;
 	m_fireRateBorder *= 1.5f;
 }
 
-void Alien::Update(PlayField& world)
+void Alien::UpdateGroup(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands)
 {
-	m_posPrev = m_pos;
-	m_pos.x += m_direction * m_velocityX;
-	m_pos.y += m_velocityY;
-	// Border check
-	if (m_pos.x < 0 || m_pos.x >= world.GetBounds().x - 1)
-	{	
-		m_direction = -m_direction;
-		m_pos.x = m_direction > 0 ? 0 : world.GetBounds().x - 1;
-	}
-
-	// Border check vertical:
-	if (m_pos.y >= world.GetBounds().y - 1)
+	float maxX = world.GetBounds().x - 1;
+	float maxY = world.GetBounds().y - 1;
+	for (int i = begin; i < end; i++)
 	{
-		world.NotifyGameOver();
-		return;
-	}
+		if (!group.isActive[i])
+		{
+			continue;
+		}
+		Vector2D& pos = group.pos[i];
+		Vector2D& velocity = group.velocity[i];
+		group.posPrev[i] = pos;
+		pos += velocity;
+		// Border check
+		if (pos.x < 0 || pos.x >= maxX)
+		{
+			velocity.x = -velocity.x;
+			pos.x = velocity.x > 0 ? 0 : maxX;
+		}
 
-	// Transform into better Alien
-	if (m_isTransformationEnabled && m_state != as_Better)
-	{
-		m_energy += getRandFloat(0, 2 * m_maxUpdateRate);
-		if (m_energy >= m_transformEnergy)
+		// Border check vertical:
+		if (pos.y >= maxY)
 		{
-			//according to rules, actual transformation should happens with 50% prob.
-			bool bSuccessTransform = getRandInt(0, 1) == 0;
-			if (bSuccessTransform)
-			{
-				Transform();
-			}
-			else
-			{
-				//if transformation fails, start over again.
-				m_energy = 0.f;
-			}
+			commands.NotifyGameOver();
 		}
-			
 	}
+}
 
-	if (getRandFloat(0.f, 1.f) < m_fireRateBorder && world.CanNewLasersBeSpawned(RI_AlienLaser, 1))
+UINT32 Alien::SampleTicksToFire(RandomStream& random, float fireProbability)
+{
+	if (fireProbability >= 1.f)
 	{
-		// Spawn laser
-		// if strong alien lasers are supported (hard mode) and it is better alien, spawn strong laser with 50% probability
-		if (m_state == as_Better && world.AreStrongAlienLasersAllowed() && getRandInt(0, 1) == 0)
-			world.SpawnLaser(new StrongAlienLaser(this));
-		else
-			world.SpawnLaser(new AlienLaser(this));
+		return 1;
 	}
+	// inverse of geometric distribution CDF, u is from (0, 1]
+	float u = 1.f - random.GetFloat(0.f, 1.f);
+	return 1 + (UINT32)(log(u) / log(1.f - fireProbability));
 }
 
-PlayerShip::PlayerShip(Vector2D pos) : SpaceShip(RI_Player, pos, RS_TakeDefault, 1, 10)
+UINT32 Alien::SampleTicksToTransformAttempt(RandomStream& random, float transformEnergy, float maxEnergyPerTick)
 {
-	static UINT32 colTypes = SetupCollidingObjects({ RI_AlienLaser, RI_Alien, RI_PowerUp, RI_ExplosionCell });
-	m_collisionTypeBitmap = colTypes;
+	// energy after n iterations is sum of n uniform values, which (for hundreds of iterations
+	// needed here) is very close to normal distribution with mean n*m and variance n*v,
+	// so P(N <= n) = P(z >= (transformEnergy - n*m) / sqrt(n*v)) for standard normal z
+	// and N is the smallest n for which sampled z satisfies this inequality
+	float m = maxEnergyPerTick / 2.f;
+	float sigma = maxEnergyPerTick / sqrt(12.f);
+	// standard normal value (Box-Muller transform)
+	float u1 = 1.f - random.GetFloat(0.f, 1.f);
+	float u2 = random.GetFloat(0.f, 1.f);
+	float z = sqrt(-2.f * log(u1)) * cos(6.2831853f * u2);
+	// positive root of m*x^2 + z*sigma*x - transformEnergy = 0, where x = sqrt(n)
+	float x = (-z * sigma + sqrt(z * z * sigma * sigma + 4.f * m * transformEnergy)) / (2.f * m);
+	return std::max((UINT32)ceil(x * x), (UINT32)1);
 }
 
-void PlayerShip::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+void Alien::ScheduleFire(PlayField& world, UINT32 tick, RandomStream& random)
 {
-	__super::OnObjectDestroyed(attacker, world, collisionPoint);
-	world.NotifyGameOver();
+	m_nextFireTick = tick + SampleTicksToFire(random, m_fireRateBorder);
+	world.ScheduleEvent(m_nextFireTick, *this, SE_AlienFire);
+}
+
+void Alien::ScheduleTransformAttempt(PlayField& world, UINT32 tick, RandomStream& random)
+{
+	m_nextTransformTick = tick + SampleTicksToTransformAttempt(random, m_transformEnergy, 2 * m_maxUpdateRate);
+	world.ScheduleEvent(m_nextTransformTick, *this, SE_AlienTransform);
+}
+
+void Alien::Fire(PlayField& world, WorldCommands& commands, RandomStream& random)
+{
+	// if strong alien lasers are supported (hard mode) and it is better alien, spawn strong laser with 50% probability
+	m_isNextLaserStrong = m_state == as_Better && world.AreStrongAlienLasersAllowed() && random.GetInt(0, 1) == 0;
+	commands.FireLasers(this, RI_AlienLaser, 1);
 }
 
-void PlayerShip::Update(PlayField& world)
+void Alien::OnScheduledEvent(PlayField& world, WorldCommands& commands, ScheduledEventType type, UINT32 tick)
 {
-	m_posPrev = m_pos;
-	int xLast = (int)m_pos.x;
-	if (world.GetControllerInput().Left())
-		m_pos.x -= m_movementSpeed;
-	else if (world.GetControllerInput().Right())
-		m_pos.x += m_movementSpeed;
-
-	if (m_pos.x <= 0.f)
-		m_pos.x = 0.f;
-	else if (m_pos.x >= world.GetBounds().x - 1)
-		m_pos.x = world.GetBounds().x - 1;
-	m_collisionPoints.clear();
-
-	// we will use m_collisionPoints only if we moved 
-	// for more then one game cell from last iteration
-	int xCurr = (int)m_pos.x;
-	if (xCurr - xLast > 1)
+	if (type == SE_AlienFire && tick == m_nextFireTick)
 	{
-		int iterDiff = xLast < xCurr ? -1 : 1;
-		for (int i = xCurr; i != xLast; i += iterDiff)
-		{
-			m_collisionPoints.push_back(Vector2D((float)i, m_pos.y));
-		}
-		m_collisionPoints.push_back(Vector2D((float)xLast, m_pos.y));
+		RandomStream random = world.GetRandom().GetStream(GetHandle(), RP_AlienFire);
+		Fire(world, commands, random);
+		ScheduleFire(world, tick, random);
 	}
-	int shotsCount = m_useTripleShots ? 3 : 1;
-	//player randomly shoot laser shots depending on fire rate (m_fireRateBorder)
-	if (getRandFloat(0.f, 1.f) < m_fireRateBorder && world.CanNewLasersBeSpawned(RI_PlayerLaser, shotsCount))
+	else if (type == SE_AlienTransform && tick == m_nextTransformTick)
 	{
-		//Spawn laser
-		world.SpawnLaser(new PlayerLaser(this));
-		if (m_useTripleShots)
+		RandomStream random = world.GetRandom().GetStream(GetHandle(), RP_AlienTransform);
+		//according to rules, actual transformation should happens with 50% prob.
+		bool bSuccessTransform = random.GetInt(0, 1) == 0;
+		if (!bSuccessTransform)
 		{
-			world.SpawnLaser(new PlayerLaserLR(this, true));
-			world.SpawnLaser(new PlayerLaserLR(this, false));
+			//if transformation fails, start over again.
+			ScheduleTransformAttempt(world, tick, random);
+			return;
 		}
+		Transform();
+		// better alien fires more often, so its fire is sampled again (starting with this iteration,
+		// fire events are handled after transformations)
+		if (random.GetFloat(0.f, 1.f) < m_fireRateBorder)
+		{
+			Fire(world, commands, random);
+		}
+		ScheduleFire(world, tick, random);
 	}
 }
 
-void PlayerShip::GetCollisionPoints(std::vector<Vector2D>& collisionVectorOut)
+void Alien::FireLasers(PlayField& world)
 {
-	if (m_collisionPoints.size() != 0)
-	{
-		collisionVectorOut.insert(collisionVectorOut.end(), m_collisionPoints.begin(), m_collisionPoints.end());
-		return;
-	}
-	__super::GetCollisionPoints(collisionVectorOut);
+	if (m_isNextLaserStrong)
+		world.SpawnLaser(new StrongAlienLaser(this));
+	else
+		world.SpawnLaser(new AlienLaser(this));
 }
 
-WallBlock::WallBlock(Vector2D pos) :
-	GameObject(RI_WallBlock, pos, RS_TakeDefault, 5, 10)
+PlayerShip::PlayerShip(Vector2D pos) : SpaceShip(RI_Player, pos, RS_TakeDefault, 1, 10) {}
+
+void PlayerShip::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
 {
-	static UINT32 colTypes = SetupCollidingObjects({ RI_PlayerLaser, RI_ExplosionCell, RI_AlienLaser });
-	m_collisionTypeBitmap = colTypes;
+	SpaceShip::OnObjectDestroyed(attacker, world, collisionPoint);
+	world.NotifyGameOver();
 }
 
-void WallBlock::OnObjectStriked(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
+void PlayerShip::Update(PlayField& world, WorldCommands& commands)
 {
-	// In case of alien laser, only strong one can hurt wall block
-	if (attacker.GetType() != RI_AlienLaser || attacker.GetStrikeForce() >= 5)
+	Vector2D& pos = Pos();
+	PosPrev() = pos;
+	Input& input = world.GetControllerInput();
+	INT64 pressTimeNs = 0;
+	if (input.Left())
 	{
-		__super::OnObjectStriked(attacker, world, collisionPoint);
+		pos.x -= m_movementSpeed;
+		pressTimeNs = input.GetPressTimeNs(IK_Left);
+	}
+	else if (input.Right())
+	{
+		pos.x += m_movementSpeed;
+		pressTimeNs = input.GetPressTimeNs(IK_Right);
+	}
+
+	if (pos.x <= 0.f)
+		pos.x = 0.f;
+	else if (pos.x >= world.GetBounds().x - 1)
+		pos.x = world.GetBounds().x - 1;
+	// latency of key press is measured till the first frame showing the move it has caused
+	if (pressTimeNs != 0 && pos.x != PosPrev().x)
+	{
+		world.SetInputLatencyStamp(pressTimeNs);
+	}
+	// there is no need to track cells we have passed if we moved for more then one game cell
+	// from last iteration, PlayField sweeps whole m_posPrev -> m_pos segment for collisions
+	int shotsCount = m_useTripleShots ? 3 : 1;
+	//player randomly shoot laser shots depending on fire rate (m_fireRateBorder)
+	RandomStream random = world.GetRandom().GetStream(GetHandle(), RP_PlayerUpdate);
+	if (random.GetFloat(0.f, 1.f) < m_fireRateBorder)
+	{
+		commands.FireLasers(this, RI_PlayerLaser, shotsCount);
+	}
+}
+
+void PlayerShip::FireLasers(PlayField& world)
+{
+	//Spawn laser
+	world.SpawnLaser(new PlayerLaser(this));
+	if (m_useTripleShots)
+	{
+		world.SpawnLaser(new PlayerLaserLR(this, true));
+		world.SpawnLaser(new PlayerLaserLR(this, false));
 	}
 }
 
+WallBlock::WallBlock(Vector2D pos) :
+	GameObject(RI_WallBlock, pos, RS_TakeDefault, 5, 10)
+{}
+
 void WallBlock::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
 {
 	world.NotifyWallBlockDestroyed();
-	world.AddObject(new Explosion(m_pos));
+	world.AddObject(new Explosion(Pos()));
 }
\ No newline at end of file
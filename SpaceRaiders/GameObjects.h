@@ -1,8 +1,10 @@
 #pragma once
 
-#include <basetsd.h> // for UINT32
+#include "IntTypes.h" // for UINT32
 #include "Vector2D.h"
-#include <functional>
+#include "Randomization.h"
+#include "ObjectPool.h"
+#include "SlotMap.h"
 #include <vector>
 
 enum RaiderObjectTypeId
@@ -45,51 +47,134 @@ typedef struct
 
 GameObjectInfo* getObjectInfo(RaiderObjectTypeId objectTypeId);
 
+// concrete classes of game objects, so that objects can be recreated from PlayFieldSnapshot
+typedef enum
+{
+	GC_Unknown = 0,
+	GC_PlayerShip,
+	GC_Alien,
+	GC_ExplodingAlien,
+	GC_AlienLaser,
+	GC_StrongAlienLaser,
+	GC_PlayerLaser,
+	GC_PlayerLaserLR,
+	GC_Explosion,
+	GC_WallBlock,
+	GC_MovementSpeedPowerUp,
+	GC_FasterShotsPowerUp,
+	GC_TripleShotsPowerUp,
+	GC_EAExplosionCell,
+	GC_End
+} GameObjectClass;
+
 class PlayField;
+class PlayFieldSnapshot;
+class WorldCommands;
+class CollisionResponse;
+class EntityStore;
+class GameObject;
+
+// hot fields of all entities of one type, i-th element of each array belongs to i-th entity
+// (see EntityStore)
+struct EntityGroup
+{
+	std::vector<GameObject*> objects;
+	std::vector<ObjectHandle> handle;
+	std::vector<Vector2D> pos;
+	std::vector<Vector2D> posPrev;
+	std::vector<Vector2D> velocity;
+	std::vector<int> health;
+	std::vector<int> ticksLeft;
+	std::vector<unsigned char> sprite;
+	// (not std::vector<bool> since neighbouring entities may be updated by different threads)
+	std::vector<unsigned char> isActive;
+	// types of objects this entity may interact with (gCollisionTable.pairMasks)
+	std::vector<UINT32> collisionMask;
+	int Size() const { return (int)objects.size(); }
+};
+
+// hot fields of game object (see EntityStore)
+typedef struct
+{
+	Vector2D pos;
+	Vector2D posPrev;
+	Vector2D velocity;
+	int health;
+	// number of iterations left before object disappears, 0 means no time limit
+	int ticksLeft;
+	unsigned char sprite;
+	bool isActive;
+} EntityData;
+
 class GameObject
 {
+	// collision handlers from collision table are applying strikes directly
+	friend class CollisionResponse;
+	friend class EntityStore;
+	friend class PlayFieldSnapshot;
+private:
+	// while object is part of the play field, its hot fields are kept in EntityStore arrays
+	// (EntityStore keeps group and index of the entity up to date when it is relocated),
+	// m_data is used only before object is added to the store and after it has been removed from it
+	EntityGroup *m_group = nullptr;
+	int m_entityIndex = 0;
+	ObjectHandle m_handle = InvalidObjectHandle;
+	EntityData m_data;
 protected:
-	// we can afford simple 32-bit bitmap since we have less then 32 types of game objects
-	UINT32 m_collisionTypeBitmap;
-	bool m_isActive;
 	bool m_isAutoDelete;
 	RaiderObjectTypeId m_objType;
-	Vector2D m_pos;
-	Vector2D m_posPrev;
 	int m_strikeForce;
-	int m_health;
-	unsigned char m_sprite;
 	const char *m_name;
-	inline bool IsCollidingWithObject(GameObject& other) 
+	Vector2D& Pos() { return m_group ? m_group->pos[m_entityIndex] : m_data.pos; }
+	Vector2D& PosPrev() { return m_group ? m_group->posPrev[m_entityIndex] : m_data.posPrev; }
+	Vector2D& Velocity() { return m_group ? m_group->velocity[m_entityIndex] : m_data.velocity; }
+	int& Health() { return m_group ? m_group->health[m_entityIndex] : m_data.health; }
+	int& TicksLeft() { return m_group ? m_group->ticksLeft[m_entityIndex] : m_data.ticksLeft; }
+	unsigned char& Sprite() { return m_group ? m_group->sprite[m_entityIndex] : m_data.sprite; }
+	void SetActive(bool isActive)
 	{
-		return (m_collisionTypeBitmap & (1 << (other.m_objType))) > 0;
+		if (m_group)
+		{
+			m_group->isActive[m_entityIndex] = isActive ? 1 : 0;
+		}
+		else
+		{
+			m_data.isActive = isActive;
+		}
 	}
-	static UINT32 SetupCollidingObjects(std::initializer_list<RaiderObjectTypeId> l);
-	void UnsetCollidingObject(RaiderObjectTypeId objType) { m_collisionTypeBitmap &= ~(1U << objType); }
-	// CheckCollision(...), OnObjectStriked(...) and OnObjectDestroyed(...) are
-	// methods that have an intention to make collision handling implemenation
-	// more flexible.
-	// In general case, they are invoked in the following order:
-	//	CheckCollision(...) [ invoked by PlayField if it detected that 2 objects has touched each other ]
-	//		OnObjectStriked(...) [if CheckCollision detected that attacking object is able to collid with "this" object based on attacker type]
-	//			OnObjectDestroyed(...) [if OnObjectStriked detected that objects health dropped to 0 or below]
+	// Collision handling is driven by gCollisionTable (see CollisionResponse.h)
+	// which is indexed by [target type][attacker type].
+	// In general case, collision is handled in the following order:
+	//	ResolveCollision(...) [ invoked by PlayField if it detected that 2 objects has touched each other ]
+	//		CollisionResponse handler [ if table has response of "this" object type to attacker type ]
+	//			OnObjectDestroyed(...) [ if handler detected that objects health dropped to 0 or below ]
 	virtual void OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint) {}
-	virtual void OnObjectStriked(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
 public:
 	GameObject(RaiderObjectTypeId objectType, Vector2D pos, unsigned char sprite, int health, int strikeForce);
 	virtual ~GameObject(){}
-	virtual void GetCollisionPoints(std::vector<Vector2D>& collisionVectorOut);
-	virtual void Update(PlayField& world) {}
-	virtual void CheckCollision(GameObject& other, PlayField& world, const Vector2D& collisionPoint);
-	void SetToInactive() { m_isActive = false; }
-	bool IsActive() { return m_isActive; }
+	virtual GameObjectClass GetClass() { return GC_Unknown; }
+	// Most of object types are updated by UpdateGroup(...) functions running over all objects
+	// of given type at once (see PlayField::UpdateObjects()), Update(...) is used only for objects
+	// with behaviour that doesn't fit into such loop.
+	// Both may be invoked in parallel for different objects, so they can only modify
+	// object itself, all other changes have to be requested through commands
+	virtual void Update(PlayField& world, WorldCommands& commands) {}
+	// invoked by PlayField::AddObject(...) once object has its handle
+	virtual void OnAddedToWorld(PlayField& world) {}
+	static void UpdateEachObject(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands);
+	// objects that have ticksLeft set are removed once it drops to 0
+	static void UpdateTimedGroup(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands);
+	void SetToInactive() { SetActive(false); }
+	bool IsActive() { return m_group ? m_group->isActive[m_entityIndex] != 0 : m_data.isActive; }
 	void SetAutoDelete(bool isEnabled) { m_isAutoDelete = isEnabled; }
 	bool IsAutoDelete() { return m_isAutoDelete; }
 	RaiderObjectTypeId GetType() { return m_objType; }
-	const Vector2D& GetPos() { return m_pos; }
-	const Vector2D& GetPosPrev() { return m_posPrev; }
+	// valid from PlayField::AddObject(...) until object is removed from play field
+	ObjectHandle GetHandle() { return m_handle; }
+	const Vector2D& GetPos() { return Pos(); }
+	const Vector2D& GetPosPrev() { return PosPrev(); }
 	int GetStrikeForce() { return m_strikeForce; }
-	unsigned char GetSprite() { return m_sprite; }
+	unsigned char GetSprite() { return Sprite(); }
 };
 
 typedef GameObject* GameObjPtr;
@@ -109,44 +194,49 @@ public:
 
 class Explosion : public GameObject
 {
-protected:
-	int m_timer = 5;
+	static ObjectPool m_pool;
 public:
-	// Explosion lasts 5 ticks before it dissappears
+	// Explosion lasts 5 ticks before it dissappears (see UpdateTimedGroup(...))
 	Explosion(Vector2D pos);
-	void Update(PlayField& world);
+	virtual GameObjectClass GetClass() { return GC_Explosion; }
+	static void* operator new(size_t size) { return m_pool.Allocate(size); }
+	static void operator delete(void *ptr) { m_pool.Free(ptr); }
+	static ObjectPool& GetPool() { return m_pool; }
 };
 
-typedef const std::function <bool(GameObject&, PlayField&)> IsObjectValidFunc;
-
 class Laser : public GameObject
 {
+	// shared by all laser classes
+	static ObjectPool m_pool;
 protected:
-	IsObjectValidFunc m_isValidFunc;
-	Vector2D m_direction;
-	virtual void OnObjectStriked(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
 	virtual void OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
-	Laser(RaiderObjectTypeId objectType, Vector2D pos, Vector2D direction, unsigned char sprite, IsObjectValidFunc isValidFunc);
+	Laser(RaiderObjectTypeId objectType, Vector2D pos, Vector2D direction, unsigned char sprite);
 public:
-	virtual void Update(PlayField& world);
+	static void UpdateGroup(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands);
+	static void* operator new(size_t size) { return m_pool.Allocate(size); }
+	static void operator delete(void *ptr) { m_pool.Free(ptr); }
+	static ObjectPool& GetPool() { return m_pool; }
 };
 
 class AlienLaser : public Laser
 {
 public:
 	AlienLaser(GameObject *parent);
+	virtual GameObjectClass GetClass() { return GC_AlienLaser; }
 };
 
 class StrongAlienLaser : public AlienLaser
 {
 public:
 	StrongAlienLaser(GameObject *parent);
+	virtual GameObjectClass GetClass() { return GC_StrongAlienLaser; }
 };
 
 class PlayerLaser : public Laser
 {
 public:
 	PlayerLaser(GameObject *parent);
+	virtual GameObjectClass GetClass() { return GC_PlayerLaser; }
 };
 
 // player laser left-right
@@ -154,6 +244,7 @@ class PlayerLaserLR : public Laser
 {
 public:
 	PlayerLaserLR(GameObject *parent, bool isLeft);
+	virtual GameObjectClass GetClass() { return GC_PlayerLaserLR; }
 };
 
 
@@ -163,16 +254,41 @@ protected:
 	virtual void OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
 	SpaceShip(RaiderObjectTypeId objectType, Vector2D pos, unsigned char sprite, int health, int strikeForce)
 		: GameObject(objectType, pos, sprite, health, strikeForce) {}
+public:
+	// invoked by PlayField if space ship requested WorldCommands::FireLasers(...)
+	// and there is still room for new lasers
+	virtual void FireLasers(PlayField& world) {}
 };
 
+// events which aliens schedule in PlayField (see PlayField::ScheduleEvent(...))
+typedef enum
+{
+	SE_AlienTransform = 0,
+	SE_AlienFire
+} ScheduledEventType;
+
 class Alien : public SpaceShip
 {
+	friend class PlayFieldSnapshot;
 protected:
 	bool m_isTransformationEnabled = true;
 	virtual void OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
 public:
-	Alien(Vector2D pos, float velocityY, bool enableFriendFire);
-	virtual void Update(PlayField& world);
+	Alien(Vector2D pos, float velocityY);
+	virtual GameObjectClass GetClass() { return GC_Alien; }
+	virtual void OnAddedToWorld(PlayField& world);
+	static void UpdateGroup(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands);
+	virtual void FireLasers(PlayField& world);
+	// Instead of checking each iteration whether alien fires or gathered enough energy to try
+	// transformation, alien samples iteration of its next fire and next transform attempt
+	// and schedules them in PlayField
+	void OnScheduledEvent(PlayField& world, WorldCommands& commands, ScheduledEventType type, UINT32 tick);
+	// number of iterations until the first success of fire check passed with fireProbability
+	// (geometric distribution)
+	static UINT32 SampleTicksToFire(RandomStream& random, float fireProbability);
+	// number of iterations until energy growing by random value from [0, maxEnergyPerTick)
+	// each iteration reaches transformEnergy (sum of uniform values is approximated by normal distribution)
+	static UINT32 SampleTicksToTransformAttempt(RandomStream& random, float transformEnergy, float maxEnergyPerTick);
 private:
 	const float m_maxUpdateRate = 0.01f;
 	float m_transformEnergy;
@@ -181,37 +297,41 @@ private:
 		as_Normal,
 		as_Better
 	};
-	float m_energy = 0.f;
-	float m_direction;
-	float m_velocityX = 0.5f;
-	float m_velocityY = 0.02f;
 	float m_fireRateBorder = 0.5f;
+	bool m_isNextLaserStrong = false;
 	AlienState m_state = as_Normal;
+	// events with other ticks are outdated (i.e. fire rescheduled after transformation)
+	UINT32 m_nextFireTick = 0;
+	UINT32 m_nextTransformTick = 0;
 
+	void ScheduleFire(PlayField& world, UINT32 tick, RandomStream& random);
+	void ScheduleTransformAttempt(PlayField& world, UINT32 tick, RandomStream& random);
+	void Fire(PlayField& world, WorldCommands& commands, RandomStream& random);
 	void Transform();
 };
 
 class PlayerShip : public SpaceShip
 {
+	friend class PlayFieldSnapshot;
 protected:
 	float m_movementSpeed = 1.f;
 	float m_fireRateBorder = 0.5f;
 	bool m_useTripleShots = false;
 	virtual void OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
-	std::vector<Vector2D> m_collisionPoints;
 public:
 	PlayerShip(Vector2D pos);
+	virtual GameObjectClass GetClass() { return GC_PlayerShip; }
 	void SetMovementSpeed(float speed) { m_movementSpeed = speed; }
 	void SetTripleShots(bool areEnabled) { m_useTripleShots = areEnabled; }
-	void Update(PlayField& world);
-	virtual void GetCollisionPoints(std::vector<Vector2D>& collisionVectorOut);
+	void Update(PlayField& world, WorldCommands& commands);
+	void FireLasers(PlayField& world);
 };
 
 class WallBlock : public GameObject
 {
 protected:
-	virtual void OnObjectStriked(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
 	virtual void OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint);
 public:
 	WallBlock(Vector2D pos);
+	virtual GameObjectClass GetClass() { return GC_WallBlock; }
 };
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include "Headless.h"
+#include "ReplayRecorder.h"
+#include "LookaheadBot.h"
+
+int RunHeadless(GameConfig& config, Vector2D size)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	// random input (or bot) is the only input available without console
+	config.testRun = true;
+	PlayField world(size, config);
+	std::vector<double> tickTimesInMs;
+	tickTimesInMs.reserve(std::max(config.testIterations, 0));
+
+	if (config.loadSnapshotPath != nullptr)
+	{
+		if (!world.LoadSnapshot(config.loadSnapshotPath))
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		world.SetupGame();
+	}
+	std::unique_ptr<LookaheadBot> bot;
+	if (config.lookaheadBot)
+	{
+		bot.reset(new LookaheadBot(world, config));
+		world.SetControllerInput(bot.get());
+	}
+	ReplayRecorder inputRecorder(world);
+	if (config.recordInputPath != nullptr
+		&& !inputRecorder.Open(config.recordInputPath, config.seed, (int)size.x, (int)size.y, config.replaySnapshotInterval))
+	{
+		return -1;
+	}
+	auto start = Clock::now();
+	while (world.IsStillRunning())
+	{
+		auto tickStart = Clock::now();
+		world.Update();
+		tickTimesInMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - tickStart).count());
+	}
+	double totalTimeInMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	inputRecorder.Close();
+	if (config.saveSnapshotPath != nullptr && !world.SaveSnapshot(config.saveSnapshotPath))
+	{
+		return -1;
+	}
+
+	int ticksCount = (int)tickTimesInMs.size();
+	double meanTickTimeInMs = 0.0, p99TickTimeInMs = 0.0, maxTickTimeInMs = 0.0;
+	if (ticksCount > 0)
+	{
+		for (auto it : tickTimesInMs)
+		{
+			meanTickTimeInMs += it;
+		}
+		meanTickTimeInMs /= ticksCount;
+		std::sort(tickTimesInMs.begin(), tickTimesInMs.end());
+		p99TickTimeInMs = tickTimesInMs[std::max((int)std::ceil(ticksCount * 0.99) - 1, 0)];
+		maxTickTimeInMs = tickTimesInMs.back();
+	}
+	std::printf("Headless run (seed %d, %dx%d field, %d iterations%s):\n", config.seed, (int)size.x, (int)size.y,
+		ticksCount, world.IsGameOver() ? ", game over" : "");
+	std::printf("%16s %10.1f\n", "ticks/sec", totalTimeInMs > 0.0 ? ticksCount * 1000.0 / totalTimeInMs : 0.0);
+	std::printf("%16s %10.4f\n", "mean ms/tick", meanTickTimeInMs);
+	std::printf("%16s %10.4f\n", "p99 ms/tick", p99TickTimeInMs);
+	std::printf("%16s %10.4f\n", "max ms/tick", maxTickTimeInMs);
+	std::printf("%16s %10d\n", "score", world.GetScore());
+	std::printf("Objects:\n");
+	EntityStore& store = world.GetEntityStore();
+	for (int type = 0; type < RI_End; type++)
+	{
+		std::printf("%16s %10d\n", getObjectInfo((RaiderObjectTypeId)type)->name, store.GetGroup((RaiderObjectTypeId)type).Size());
+	}
+	std::printf("%16s %10d\n", "total", store.GetSize());
+	if (config.profileFrames || config.profileHud)
+	{
+		std::fflush(stdout);
+		world.GetProfiler().WriteReport(std::cout);
+	}
+	if (config.recordInputPath != nullptr)
+	{
+		std::fflush(stdout);
+		inputRecorder.WriteReport(std::cout);
+	}
+	if (bot)
+	{
+		std::fflush(stdout);
+		bot->WriteReport(std::cout);
+	}
+	return 0;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "PlayField.h"
+
+// Headless mode is available through --headless cmd parameter: game is played with random input
+// as fast as possible (no renderer, no console and no sleeping between iterations), at the end
+// timing statistics and final objects counts are printed.
+// It doesn't depend on Windows API, so it can be built on other platforms as well.
+int RunHeadless(GameConfig& config, Vector2D size);
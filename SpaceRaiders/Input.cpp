@@ -1,6 +1,8 @@
 
 #include "stdafx.h"
 #include "Input.h"
+
+#ifdef _WIN32
 #include <Windows.h>
 
 void KeyboardInput::Update()
@@ -38,4 +40,10 @@ void KeyboardInput::Update()
 			break;
 		}
 	}
-}
\ No newline at end of file
+}
+#else
+// there is no console input outside Windows (headless mode uses RndInput)
+void KeyboardInput::Update()
+{
+}
+#endif
@@ -1,21 +1,47 @@
 #pragma once
 #include "Randomization.h"
 
+typedef enum
+{
+	IK_Left = 0,
+	IK_Right,
+	IK_Fire,
+	IK_End
+} InputKey;
+
 class Input
 {
 public:
+	virtual ~Input() {}
 	virtual bool Left() = 0;
 	virtual bool Right() = 0;
 	virtual bool Fire() = 0;
 	virtual void Update() {}
+	// arrival time (steady clock, ns) of key press which made key active in this iteration,
+	// 0 if key wasn't pressed in it or input doesn't timestamp its events
+	virtual INT64 GetPressTimeNs(InputKey key) { return 0; }
 };
 
 class RndInput : public Input
 {
+protected:
+	bool m_isLeft = false;
+	bool m_isRight = false;
+	bool m_isFire = false;
+	const WorldRandom& m_random;
 public:
-	virtual bool Fire() { return (getRandFloat(0.f, 1.f) < 0.5f); }
-	virtual bool Left() { return (getRandFloat(0.f, 1.f) < 0.3f); }
-	virtual bool Right() { return (getRandFloat(0.f, 1.f) < 0.4f); }
+	RndInput(const WorldRandom& random) : m_random(random) {}
+	virtual bool Fire() { return m_isFire; }
+	virtual bool Left() { return m_isLeft; }
+	virtual bool Right() { return m_isRight; }
+	// input is randomized once per iteration (before game objects are updated in parallel)
+	virtual void Update()
+	{
+		RandomStream random = m_random.GetStream(WorldRandom::WorldEntity, RP_Input);
+		m_isFire = random.GetFloat(0.f, 1.f) < 0.5f;
+		m_isLeft = random.GetFloat(0.f, 1.f) < 0.3f;
+		m_isRight = random.GetFloat(0.f, 1.f) < 0.4f;
+	}
 };
 
 class KeyboardInput : public Input
@@ -0,0 +1,344 @@
+#include "stdafx.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+#include "InputThread.h"
+#include "Randomization.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+
+// terminal state is kept outside of InputThread, so that signal handler can restore it
+static struct termios gSavedTermios;
+static volatile sig_atomic_t gIsTerminalChanged = 0;
+
+// async signal safe (only tcsetattr() and write() are called)
+static void RestoreTerminal()
+{
+	if (gIsTerminalChanged == 0)
+	{
+		return;
+	}
+	gIsTerminalChanged = 0;
+	tcsetattr(STDIN_FILENO, TCSANOW, &gSavedTermios);
+	// renderer hides cursor while the game is running
+	static const char showCursor[] = "\x1b[?25h\r\n";
+	ssize_t written = write(STDOUT_FILENO, showCursor, sizeof(showCursor) - 1);
+	(void)written;
+}
+
+static void OnTerminatingSignal(int signalNumber)
+{
+	RestoreTerminal();
+	// default action (process termination) is taken with the signal raised again
+	signal(signalNumber, SIG_DFL);
+	raise(signalNumber);
+}
+
+static void InstallTerminalRestore()
+{
+	static bool isInstalled = false;
+	if (isInstalled)
+	{
+		return;
+	}
+	isInstalled = true;
+	std::atexit(RestoreTerminal);
+	const int signals[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGABRT };
+	for (int signalNumber : signals)
+	{
+		struct sigaction action = {};
+		action.sa_handler = OnTerminatingSignal;
+		sigemptyset(&action.sa_mask);
+		sigaction(signalNumber, &action, nullptr);
+	}
+}
+#endif
+
+// defined, because std::chrono::milliseconds takes it by reference
+const int InputThread::PollTimeoutMs;
+
+InputThread::InputThread() :
+	m_events(RingCapacity),
+	m_isStopping(false)
+{
+}
+
+InputThread::~InputThread()
+{
+	Stop();
+}
+
+void InputThread::PushEvent(InputKey key, bool isPressed, INT64 timeNs)
+{
+	KeyEvent* slot = m_events.BeginPush();
+	if (slot == nullptr)
+	{
+		// game thread doesn't keep up (i.e. it is paused in debugger)
+		m_droppedCount++;
+		return;
+	}
+	slot->timeNs = timeNs;
+	slot->key = (UINT8)key;
+	slot->isPressed = isPressed ? 1 : 0;
+	m_events.EndPush();
+}
+
+void InputThread::ParseTerminalInput(const char* data, size_t size, INT64 timeNs)
+{
+	// sequences may be split between reads, so parser state is kept between calls
+	for (size_t i = 0; i < size; i++)
+	{
+		char c = data[i];
+		int key = IK_End;
+		if (m_escapeState == 0)
+		{
+			if (c == '\x1b')
+			{
+				m_escapeState = 1;
+			}
+			else if (c == 'f' || c == 'F')
+			{
+				key = IK_Fire;
+			}
+		}
+		else if (m_escapeState == 1)
+		{
+			// arrows are sent as CSI (ESC [) or SS3 (ESC O, application cursor mode) sequences
+			m_escapeState = (c == '[' || c == 'O') ? 2 : 0;
+		}
+		else if (c >= 0x40 && c <= 0x7e)
+		{
+			// final byte (parameters, i.e. modifiers of ESC [ 1 ; 2 C, are skipped)
+			key = c == 'D' ? IK_Left : (c == 'C' ? IK_Right : IK_End);
+			m_escapeState = 0;
+		}
+		if (key != IK_End)
+		{
+			PushEvent((InputKey)key, true, timeNs);
+			PushEvent((InputKey)key, false, timeNs);
+		}
+	}
+}
+
+bool InputThread::StartSynthetic(const char* script)
+{
+	m_script.clear();
+	for (const char* it = script; *it != '\0'; )
+	{
+		char key = (char)std::toupper(*it++);
+		char* end = nullptr;
+		long delayInMs = std::strtol(it, &end, 10);
+		if ((key != 'L' && key != 'R' && key != 'F') || end == it || delayInMs <= 0 || (*end != ',' && *end != '\0'))
+		{
+			std::printf("Error invalid synthetic input script %s (expected i.e. L120,R120,F60)\n", script);
+			return false;
+		}
+		m_script.push_back({ key == 'L' ? IK_Left : (key == 'R' ? IK_Right : IK_Fire), (int)delayInMs });
+		it = *end == ',' ? end + 1 : end;
+	}
+	if (m_script.empty() || m_thread.joinable())
+	{
+		std::printf("Error invalid synthetic input script %s (expected i.e. L120,R120,F60)\n", script);
+		return false;
+	}
+	m_isStopping = false;
+	m_thread = std::thread(&InputThread::PlayScript, this);
+	return true;
+}
+
+void InputThread::PlayScript()
+{
+	// presses exactly on schedule would keep phase with iterations (delays are usually multiples of
+	// the step), so each one is moved by random part of its delay and presses sample whole iteration
+	localRandGen randGen((unsigned int)NowNs());
+	Clock::time_point scheduleTime = Clock::now();
+	for (size_t i = 0; ; i = (i + 1) % m_script.size())
+	{
+		scheduleTime += std::chrono::milliseconds(m_script[i].delayInMs);
+		Clock::time_point pressTime = scheduleTime + std::chrono::microseconds(getRandInt(randGen, 0, m_script[i].delayInMs * 1000 - 1));
+		// sleeping in steps, so that stop request is noticed
+		for (Clock::time_point now = Clock::now(); now < pressTime; now = Clock::now())
+		{
+			if (m_isStopping.load(std::memory_order_acquire))
+			{
+				return;
+			}
+			std::this_thread::sleep_for((std::min)(pressTime - now, Clock::duration(std::chrono::milliseconds(PollTimeoutMs))));
+		}
+		if (m_isStopping.load(std::memory_order_acquire))
+		{
+			return;
+		}
+		// taps like on terminal
+		INT64 timeNs = NowNs();
+		PushEvent(m_script[i].key, true, timeNs);
+		PushEvent(m_script[i].key, false, timeNs);
+	}
+}
+
+#ifdef _WIN32
+bool InputThread::Start()
+{
+	DWORD mode = 0;
+	if (m_thread.joinable() || !GetConsoleMode(GetStdHandle(STD_INPUT_HANDLE), &mode))
+	{
+		return false;
+	}
+	m_isStopping = false;
+	m_thread = std::thread(&InputThread::Loop, this);
+	return true;
+}
+
+void InputThread::Loop()
+{
+	static const DWORD MaxRecords = 64;
+	const HANDLE hIn = GetStdHandle(STD_INPUT_HANDLE);
+	INPUT_RECORD records[MaxRecords];
+	while (!m_isStopping.load(std::memory_order_acquire))
+	{
+		// console handle is signaled when it has input, so ReadConsoleInput(...) doesn't block
+		if (WaitForSingleObject(hIn, PollTimeoutMs) != WAIT_OBJECT_0)
+		{
+			continue;
+		}
+		DWORD recordsCount = 0;
+		if (!ReadConsoleInput(hIn, records, MaxRecords, &recordsCount))
+		{
+			continue;
+		}
+		INT64 timeNs = NowNs();
+		for (DWORD i = 0; i < recordsCount; i++)
+		{
+			if (records[i].EventType != KEY_EVENT)
+			{
+				continue;
+			}
+			bool isPressed = records[i].Event.KeyEvent.bKeyDown == TRUE;
+			switch (records[i].Event.KeyEvent.wVirtualKeyCode)
+			{
+			case VK_LEFT:
+				PushEvent(IK_Left, isPressed, timeNs);
+				break;
+			case VK_RIGHT:
+				PushEvent(IK_Right, isPressed, timeNs);
+				break;
+			case 'F':
+				PushEvent(IK_Fire, isPressed, timeNs);
+				break;
+			}
+		}
+	}
+}
+
+void InputThread::Stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+	m_isStopping.store(true, std::memory_order_release);
+	m_thread.join();
+}
+#else
+bool InputThread::Start()
+{
+	if (m_thread.joinable() || !isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &gSavedTermios) != 0)
+	{
+		return false;
+	}
+	InstallTerminalRestore();
+	// raw mode: keys are available without Enter and aren't echoed (signals, i.e. Ctrl+C, still work)
+	struct termios raw = gSavedTermios;
+	raw.c_lflag &= ~(ICANON | ECHO);
+	raw.c_cc[VMIN] = 0;
+	raw.c_cc[VTIME] = 0;
+	if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0)
+	{
+		return false;
+	}
+	gIsTerminalChanged = 1;
+	m_isStopping = false;
+	m_thread = std::thread(&InputThread::Loop, this);
+	return true;
+}
+
+void InputThread::Loop()
+{
+	char buffer[64];
+	struct pollfd pollFd = { STDIN_FILENO, POLLIN, 0 };
+	while (!m_isStopping.load(std::memory_order_acquire))
+	{
+		if (poll(&pollFd, 1, PollTimeoutMs) <= 0)
+		{
+			continue;
+		}
+		if ((pollFd.revents & POLLIN) == 0)
+		{
+			// terminal is gone
+			return;
+		}
+		ssize_t size = read(STDIN_FILENO, buffer, sizeof(buffer));
+		if (size > 0)
+		{
+			ParseTerminalInput(buffer, (size_t)size, NowNs());
+		}
+	}
+}
+
+void InputThread::Stop()
+{
+	if (m_thread.joinable())
+	{
+		m_isStopping.store(true, std::memory_order_release);
+		m_thread.join();
+	}
+	// renderer shows cursor itself after Stop()
+	if (gIsTerminalChanged != 0)
+	{
+		gIsTerminalChanged = 0;
+		tcsetattr(STDIN_FILENO, TCSANOW, &gSavedTermios);
+	}
+}
+#endif
+
+void InputThread::Update()
+{
+	bool isPressed[IK_End] = {};
+	INT64 nowNs = NowNs();
+	for (KeyEvent* event = m_events.Front(); event != nullptr; event = m_events.Front())
+	{
+		m_isKeyDown[event->key] = event->isPressed != 0;
+		if (event->isPressed != 0 && !isPressed[event->key])
+		{
+			isPressed[event->key] = true;
+			m_pressTimeNs[event->key] = event->timeNs;
+		}
+		m_eventsWait.Add((UINT64)(nowNs > event->timeNs ? nowNs - event->timeNs : 0));
+		m_eventsCount++;
+		m_events.Pop();
+	}
+	for (int key = 0; key < IK_End; key++)
+	{
+		m_isActive[key] = m_isKeyDown[key] || isPressed[key];
+		m_pressTimeNs[key] = isPressed[key] ? m_pressTimeNs[key] : 0;
+	}
+}
+
+void InputThread::WriteReport(std::ostream& out)
+{
+	char line[160];
+	std::snprintf(line, sizeof(line), "Input thread: %llu key events, %llu dropped (ring full)\n",
+		(unsigned long long)m_eventsCount, (unsigned long long)m_droppedCount);
+	out << line;
+	std::snprintf(line, sizeof(line), "%24s mean %.4f p50 %.4f p99 %.4f max %.4f\n", "event wait ms",
+		m_eventsWait.GetMeanInMs(), m_eventsWait.GetPercentileInMs(50),
+		m_eventsWait.GetPercentileInMs(99), m_eventsWait.GetMaxInMs());
+	out << line;
+}
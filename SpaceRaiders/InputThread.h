@@ -0,0 +1,88 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <vector>
+#include "IntTypes.h"
+#include "Input.h"
+#include "SpscRing.h"
+#include "FrameProfiler.h"
+
+typedef struct
+{
+	// steady clock time of event arrival (when reader thread got it)
+	INT64 timeNs;
+	// InputKey
+	UINT8 key;
+	UINT8 isPressed;
+} KeyEvent;
+
+// Keyboard read on its own thread, so that waiting for console input (and reading it) isn't part
+// of game iterations: reader thread waits for input (batched ReadConsoleInput() on Windows console,
+// poll() on terminal switched to raw mode elsewhere) and pushes timestamped key events into lock-free
+// SPSC ring, game thread drains the ring once per iteration (in Update(), called by PlayField::Update()).
+// Presses are edge triggered: key pressed and released between two iterations is still down in the
+// next one. Terminal doesn't report releases, so each key sequence (or its auto-repeat) is a press
+// followed by release and it is down for one iteration.
+// Instead of keyboard, reader thread can play a script of synthetic key presses (StartSynthetic()),
+// so that input latency can be measured without anyone at the keyboard.
+// Terminal mode (and cursor visibility) is restored also when the game is ended by a signal
+// (i.e. Ctrl+C) or exit() instead of Stop().
+class InputThread : public Input
+{
+public:
+	typedef std::chrono::steady_clock Clock;
+	static const int RingCapacity = 256;
+	// reader thread checks stop request at least this often
+	static const int PollTimeoutMs = 50;
+private:
+	SpscRing<KeyEvent> m_events;
+	std::thread m_thread;
+	std::atomic<bool> m_isStopping;
+	// game thread state
+	bool m_isKeyDown[IK_End] = {};
+	bool m_isActive[IK_End] = {};
+	UINT64 m_eventsCount = 0;
+	// from event arrival to the iteration which drained it
+	DurationHistogram m_eventsWait;
+	// reader thread state (read by game thread only after the thread is joined)
+	UINT64 m_droppedCount = 0;
+	// arrival of the first press of each key drained by the last Update()
+	INT64 m_pressTimeNs[IK_End] = {};
+	// escape sequence parser: 0 - text, 1 - after ESC, 2 - inside CSI / SS3 sequence
+	int m_escapeState = 0;
+	typedef struct
+	{
+		InputKey key;
+		// since previous press of the script
+		int delayInMs;
+	} ScriptedPress;
+	std::vector<ScriptedPress> m_script;
+	void Loop();
+	// plays m_script (in loop) till the thread is stopped
+	void PlayScript();
+	void PushEvent(InputKey key, bool isPressed, INT64 timeNs);
+	void ParseTerminalInput(const char* data, size_t size, INT64 timeNs);
+public:
+	InputThread();
+	~InputThread();
+	static INT64 NowNs() { return (INT64)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count(); }
+	// starts reader thread, false if standard input isn't a console (terminal)
+	bool Start();
+	// starts reader thread which presses keys of the script instead of reading keyboard, script is
+	// a list of key (L - left, R - right, F - fire) and delay in ms pairs, i.e. "L120,R120,F60",
+	// it is played in loop (each press comes randomly up to its delay later than scheduled),
+	// false (with error printed) if script is invalid
+	bool StartSynthetic(const char* script);
+	// stops reader thread and restores terminal mode
+	void Stop();
+	virtual bool Left() { return m_isActive[IK_Left]; }
+	virtual bool Right() { return m_isActive[IK_Right]; }
+	virtual bool Fire() { return m_isActive[IK_Fire]; }
+	// drains events pushed since previous iteration
+	virtual void Update();
+	virtual INT64 GetPressTimeNs(InputKey key) { return m_pressTimeNs[key]; }
+	void WriteReport(std::ostream& out);
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+// fixed size integer types (named like in Windows SDK, so that game code
+// compiles also on platforms without basetsd.h, i.e. in headless mode on Linux)
+#ifdef _WIN32
+#include <basetsd.h>
+#else
+#include <cstdint>
+typedef uint8_t UINT8;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
+typedef int64_t INT64;
+#endif
@@ -0,0 +1,97 @@
+#include "stdafx.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include "LookaheadBot.h"
+
+typedef std::chrono::steady_clock BotClock;
+
+static inline UINT64 ElapsedNs(BotClock::time_point start)
+{
+	return (UINT64)std::chrono::duration_cast<std::chrono::nanoseconds>(BotClock::now() - start).count();
+}
+
+GameConfig LookaheadBot::MakeBranchConfig(const GameConfig& config)
+{
+	// branches are small enough to be simulated by calling thread only and they are never shown
+	GameConfig branchConfig = config;
+	branchConfig.testRun = true;
+	branchConfig.workerThreads = 1;
+	branchConfig.displayGameInfo = false;
+	branchConfig.profileFrames = false;
+	branchConfig.profileHud = false;
+	return branchConfig;
+}
+
+LookaheadBot::LookaheadBot(PlayField& world, const GameConfig& config) :
+	m_world(world),
+	m_branchConfig(MakeBranchConfig(config)),
+	m_branch(world.GetFieldSize(), m_branchConfig)
+{
+	m_branch.SetControllerInput(&m_branchInput);
+}
+
+int LookaheadBot::SimulateBranch(BotMove move)
+{
+	m_branchInput.SetMove(move);
+	int startScore = m_branch.GetScore();
+	int survivedTicks = 0;
+	for (; survivedTicks < LookaheadTicks; survivedTicks++)
+	{
+		m_branch.Update();
+		if (m_branch.IsGameOver() || m_branch.GetPlayerObject() == nullptr)
+		{
+			break;
+		}
+	}
+	return survivedTicks * SurvivedTickValue + (m_branch.GetScore() - startScore);
+}
+
+void LookaheadBot::Update()
+{
+	if (m_world.GetPlayerObject() == nullptr)
+	{
+		m_move = BM_Stay;
+		return;
+	}
+	auto start = BotClock::now();
+	// staying is tried first, so it is kept when moves are equal (ship doesn't jitter)
+	int bestValue = INT_MIN;
+	BotMove bestMove = BM_Stay;
+	for (int move = 0; move < BM_End; move++)
+	{
+		auto branchStart = BotClock::now();
+		if (!m_world.Fork(m_branch))
+		{
+			break;
+		}
+		int value = SimulateBranch((BotMove)move);
+		m_branchTime.Add(ElapsedNs(branchStart));
+		if (value > bestValue)
+		{
+			bestValue = value;
+			bestMove = (BotMove)move;
+		}
+	}
+	m_move = bestMove;
+	m_movesCount[m_move]++;
+	m_decisionsCount++;
+	m_decisionTime.Add(ElapsedNs(start));
+}
+
+void LookaheadBot::WriteReport(std::ostream& out)
+{
+	char line[160];
+	std::snprintf(line, sizeof(line), "Lookahead bot: %llu decisions (stay %llu, left %llu, right %llu), %d ticks ahead\n",
+		(unsigned long long)m_decisionsCount, (unsigned long long)m_movesCount[BM_Stay],
+		(unsigned long long)m_movesCount[BM_Left], (unsigned long long)m_movesCount[BM_Right], LookaheadTicks);
+	out << line;
+	std::snprintf(line, sizeof(line), "%24s mean %.4f p50 %.4f p99 %.4f max %.4f\n", "fork + simulate ms",
+		m_branchTime.GetMeanInMs(), m_branchTime.GetPercentileInMs(50),
+		m_branchTime.GetPercentileInMs(99), m_branchTime.GetMaxInMs());
+	out << line;
+	std::snprintf(line, sizeof(line), "%24s mean %.4f p50 %.4f p99 %.4f max %.4f\n", "decision ms",
+		m_decisionTime.GetMeanInMs(), m_decisionTime.GetPercentileInMs(50),
+		m_decisionTime.GetPercentileInMs(99), m_decisionTime.GetMaxInMs());
+	out << line;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ostream>
+#include "IntTypes.h"
+#include "Input.h"
+#include "PlayField.h"
+#include "FrameProfiler.h"
+
+typedef enum
+{
+	BM_Stay = 0,
+	BM_Left,
+	BM_Right,
+	BM_End
+} BotMove;
+
+// Input of branch worlds: the same move is held in each iteration
+class BotMoveInput : public Input
+{
+private:
+	BotMove m_move = BM_Stay;
+public:
+	void SetMove(BotMove move) { m_move = move; }
+	virtual bool Left() { return m_move == BM_Left; }
+	virtual bool Right() { return m_move == BM_Right; }
+	virtual bool Fire() { return false; }
+};
+
+// Reference bot (available through --lookaheadBot cmd parameter) which plays by simulating
+// candidate moves ahead: before each iteration (in Update(), called by PlayField::Update()) world
+// is forked into branch world for each move, branch is simulated LookaheadTicks iterations with
+// the move held and the move whose branch has kept the player alive longest (and then scored
+// the most) is taken. Branch world is created once, so forking doesn't allocate it again.
+class LookaheadBot : public Input
+{
+public:
+	static const int LookaheadTicks = 16;
+	// surviving one more iteration is worth more than any score gained in the lookahead
+	static const int SurvivedTickValue = 100000;
+private:
+	PlayField& m_world;
+	GameConfig m_branchConfig;
+	PlayField m_branch;
+	BotMoveInput m_branchInput;
+	BotMove m_move = BM_Stay;
+	UINT64 m_decisionsCount = 0;
+	UINT64 m_movesCount[BM_End] = {};
+	// fork and simulation of one branch
+	DurationHistogram m_branchTime;
+	DurationHistogram m_decisionTime;
+	static GameConfig MakeBranchConfig(const GameConfig& config);
+	// value of the move (see SurvivedTickValue), branch has to be forked before
+	int SimulateBranch(BotMove move);
+public:
+	LookaheadBot(PlayField& world, const GameConfig& config);
+	virtual bool Left() { return m_move == BM_Left; }
+	virtual bool Right() { return m_move == BM_Right; }
+	virtual bool Fire() { return false; }
+	// chooses the move of this iteration
+	virtual void Update();
+	void WriteReport(std::ostream& out);
+};
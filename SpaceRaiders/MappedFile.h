@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+// Read-only memory mapping of whole file (MapViewOfFile on Windows, mmap elsewhere)
+class MappedFile
+{
+private:
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+public:
+	MappedFile() {}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+	// false if file can't be opened or mapped (empty files can't be mapped either)
+	bool Open(const char* path);
+	void Close();
+	const unsigned char* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+};
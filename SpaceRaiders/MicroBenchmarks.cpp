@@ -0,0 +1,321 @@
+#include "stdafx.h"
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <cstdlib>
+#include "MicroBenchmarks.h"
+#include "Randomization.h"
+#include "ExplodingAlien.h"
+#include "PlayFieldSnapshot.h"
+
+typedef std::chrono::high_resolution_clock MicroBenchmarkClock;
+
+typedef struct
+{
+	const char *name;
+	int sizeX;
+	int sizeY;
+	int aliensCount;
+	int wallBlocksCount;
+	int lasersCount;
+	// exploding aliens are hit by player lasers in the first iteration, so they explode in following ones
+	int explodingAliensCount;
+	// each repetition is done on a new fixture (restored from snapshot of the first one)
+	int repetitions;
+} FixtureConfig;
+
+static const FixtureConfig gFixtures[] =
+{
+	{ "game",	80,		29,		20,		40,		14,		1,		200 },
+	{ "medium",	300,	300,	2000,	2000,	1000,	50,		20 },
+	{ "large",	1000,	1000,	20000,	20000,	10000,	500,	5 }
+};
+
+// number of iterations timed by "Update" measurement in each repetition
+static const int UpdateTicks = 10;
+static const int CreateCircleRepetitions = 2000;
+static const int WarmUpRounds = 3;
+
+// PlayField populated with objects described by FixtureConfig (or restored from a snapshot of
+// populated one), it is a friend of PlayField so that update phases (private methods of PlayField)
+// can be timed separately
+class PlayFieldFixture
+{
+private:
+	GameConfig m_config;
+	PlayField m_world;
+	static GameConfig MakeConfig()
+	{
+		GameConfig config = { true, 0, false, false, false, true, 1, 0, false, 1 };
+		return config;
+	}
+public:
+	// world is empty till it is populated or restored
+	PlayFieldFixture(const FixtureConfig& fixture) :
+		m_config(MakeConfig()),
+		m_world(Vector2D((float)fixture.sizeX, (float)fixture.sizeY), m_config)
+	{
+	}
+	void Populate(const FixtureConfig& fixture)
+	{
+		// objects are always placed at the same positions (there is no player, so game never ends)
+		localRandGen gen(1);
+		auto randomPos = [&](int maxY) { return Vector2D((float)getRandInt(gen, 0, fixture.sizeX - 1), (float)getRandInt(gen, 0, maxY)); };
+		m_world.MaxAlienLasers = m_world.MaxPlayerLasers = fixture.lasersCount + fixture.explodingAliensCount;
+		for (int i = 0; i < fixture.aliensCount; i++)
+		{
+			m_world.AddObject(new Alien(randomPos(fixture.sizeY / 2), 0.02f));
+		}
+		for (int i = 0; i < fixture.wallBlocksCount; i++)
+		{
+			m_world.AddObject(new WallBlock(randomPos(fixture.sizeY - 2)));
+		}
+		for (int i = 0; i < fixture.lasersCount; i++)
+		{
+			// lasers are spawned next to their parent
+			WallBlock parent(randomPos(fixture.sizeY - 2));
+			m_world.SpawnLaser(i % 2 == 0 ? (GameObject*)new AlienLaser(&parent) : new PlayerLaser(&parent));
+		}
+		for (int i = 0; i < fixture.explodingAliensCount; i++)
+		{
+			Vector2D pos = randomPos(fixture.sizeY / 2);
+			m_world.AddObject(new ExplodingAlien(pos, 0.06f));
+			WallBlock parent(pos + Vector2D(0, 1));
+			m_world.SpawnLaser(new PlayerLaser(&parent));
+		}
+		m_world.ApplyObjectsCollectionChanges();
+	}
+	void SaveSnapshot(std::vector<unsigned char>& out) { PlayFieldSnapshot::Save(m_world, out); }
+	bool RestoreSnapshot(const std::vector<unsigned char>& snapshot) { return PlayFieldSnapshot::Restore(m_world, snapshot.data(), snapshot.size()); }
+	void UpdateObjects() { m_world.UpdateObjects(); }
+	void HandleCollisions() { m_world.HandleCollisions(); }
+	void ApplyObjectsCollectionChanges() { m_world.ApplyObjectsCollectionChanges(); }
+	void FillObjectsPositionMaps() { m_world.FillObjectsPositionMaps(); }
+	void InitRandomFreePositions()
+	{
+		m_world.m_aliensPosProvider.InitRandomFreePositions();
+		m_world.m_wallBlocksPosProvider.InitRandomFreePositions();
+	}
+	void Update() { m_world.Update(); }
+};
+
+typedef struct
+{
+	std::string fixture;
+	std::string name;
+	std::vector<double> samplesInMs;
+	double medianInMs;
+	double minInMs;
+} MicroBenchmarkResult;
+
+template <typename Func>
+static double TimeInMs(Func func)
+{
+	auto start = MicroBenchmarkClock::now();
+	func();
+	return std::chrono::duration<double, std::milli>(MicroBenchmarkClock::now() - start).count();
+}
+
+static void AddSample(std::vector<MicroBenchmarkResult>& results, const char *fixture, const char *name, double timeInMs)
+{
+	for (auto& it : results)
+	{
+		if (it.fixture == fixture && it.name == name)
+		{
+			it.samplesInMs.push_back(timeInMs);
+			return;
+		}
+	}
+	results.push_back({ fixture, name, { timeInMs }, 0.0, 0.0 });
+}
+
+static void RunFixture(const FixtureConfig& config, std::vector<MicroBenchmarkResult>& results)
+{
+	// fixture is populated once, repetitions start warm from its snapshot
+	std::vector<unsigned char> snapshot;
+	{
+		PlayFieldFixture source(config);
+		AddSample(results, config.name, "Populate", TimeInMs([&]() { source.Populate(config); }));
+		AddSample(results, config.name, "SaveSnapshot", TimeInMs([&]() { source.SaveSnapshot(snapshot); }));
+	}
+	for (int rep = 0; rep < config.repetitions; rep++)
+	{
+		PlayFieldFixture fixture(config);
+		bool isRestored = false;
+		AddSample(results, config.name, "RestoreSnapshot", TimeInMs([&]() { isRestored = fixture.RestoreSnapshot(snapshot); }));
+		if (!isRestored)
+		{
+			std::cerr << "Can't restore " << config.name << " fixture from its snapshot" << std::endl;
+			return;
+		}
+		// phases are run in the same order as in PlayField::Update()
+		AddSample(results, config.name, "UpdateObjects", TimeInMs([&]() { fixture.UpdateObjects(); }));
+		AddSample(results, config.name, "HandleCollisions", TimeInMs([&]() { fixture.HandleCollisions(); }));
+		AddSample(results, config.name, "ApplyObjectsCollectionChanges", TimeInMs([&]() { fixture.ApplyObjectsCollectionChanges(); }));
+		// used while spawning new wave of aliens and wall blocks
+		AddSample(results, config.name, "FillObjectsPositionMaps", TimeInMs([&]() { fixture.FillObjectsPositionMaps(); }));
+		AddSample(results, config.name, "InitRandomFreePositions", TimeInMs([&]() { fixture.InitRandomFreePositions(); }));
+		AddSample(results, config.name, "Update", TimeInMs([&]()
+		{
+			for (int t = 0; t < UpdateTicks; t++)
+			{
+				fixture.Update();
+			}
+		}) / UpdateTicks);
+	}
+}
+
+// whole explosion of exploding alien (all of its rings)
+static void RunCreateCircle(std::vector<MicroBenchmarkResult>& results)
+{
+	for (int rep = 0; rep < CreateCircleRepetitions; rep++)
+	{
+		ExplodingAlien alien(Vector2D(0, 0), 0.f);
+		AddSample(results, "explosion", "CreateCircle", TimeInMs([&]()
+		{
+			for (int r = 0; r < ExplodingAlien::GetExplosionRingsCount(); r++)
+			{
+				alien.CreateCircle(r);
+			}
+		}));
+	}
+}
+
+static void WriteJson(std::ostream& out, const std::vector<MicroBenchmarkResult>& results)
+{
+	// one measurement per line (baseline reader depends on it)
+	out << "{\n\t\"benchmarks\": [\n" << std::setprecision(6);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const MicroBenchmarkResult& it = results[i];
+		out << "\t\t{ \"fixture\": \"" << it.fixture << "\", \"name\": \"" << it.name
+			<< "\", \"samples\": " << it.samplesInMs.size() << ", \"median_ms\": " << it.medianInMs
+			<< ", \"min_ms\": " << it.minInMs << " }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "\t]\n}\n";
+}
+
+static bool GetJsonString(const std::string& line, const char *key, std::string& valueOut)
+{
+	std::string pattern = std::string("\"") + key + "\": \"";
+	size_t begin = line.find(pattern);
+	if (begin == std::string::npos)
+	{
+		return false;
+	}
+	begin += pattern.size();
+	size_t end = line.find('"', begin);
+	if (end == std::string::npos)
+	{
+		return false;
+	}
+	valueOut = line.substr(begin, end - begin);
+	return true;
+}
+
+static bool GetJsonNumber(const std::string& line, const char *key, double& valueOut)
+{
+	std::string pattern = std::string("\"") + key + "\": ";
+	size_t begin = line.find(pattern);
+	if (begin == std::string::npos)
+	{
+		return false;
+	}
+	const char *str = line.c_str() + begin + pattern.size();
+	char *end = nullptr;
+	valueOut = strtod(str, &end);
+	return end != str;
+}
+
+// reads median times from file written by WriteJson(...), keyed by "fixture/name"
+static bool ReadBaseline(const char *path, std::map<std::string, double>& mediansOut)
+{
+	std::ifstream in(path);
+	if (!in)
+	{
+		return false;
+	}
+	std::string line;
+	while (std::getline(in, line))
+	{
+		std::string fixture, name;
+		double median;
+		if (GetJsonString(line, "fixture", fixture) && GetJsonString(line, "name", name)
+			&& GetJsonNumber(line, "median_ms", median))
+		{
+			mediansOut[fixture + "/" + name] = median;
+		}
+	}
+	return true;
+}
+
+int RunMicroBenchmarks(GameConfig& config)
+{
+	std::map<std::string, double> baseline;
+	if (config.benchmarkBaselinePath != nullptr && !ReadBaseline(config.benchmarkBaselinePath, baseline))
+	{
+		std::cerr << "Can't read " << config.benchmarkBaselinePath << std::endl;
+		return -1;
+	}
+
+	std::vector<MicroBenchmarkResult> results;
+	// warm up (caches, heap, CPU clock), so that the first fixture isn't measured on cold machine
+	for (int i = 0; i < WarmUpRounds; i++)
+	{
+		std::vector<MicroBenchmarkResult> warmUpResults;
+		RunFixture(gFixtures[0], warmUpResults);
+	}
+	for (auto& it : gFixtures)
+	{
+		RunFixture(it, results);
+	}
+	RunCreateCircle(results);
+	for (auto& it : results)
+	{
+		std::vector<double> samples = it.samplesInMs;
+		std::sort(samples.begin(), samples.end());
+		it.medianInMs = samples[samples.size() / 2];
+		it.minInMs = samples[0];
+	}
+
+	if (config.benchmarkResultsPath != nullptr)
+	{
+		std::ofstream out(config.benchmarkResultsPath);
+		if (!out)
+		{
+			std::cerr << "Can't open " << config.benchmarkResultsPath << std::endl;
+			return -1;
+		}
+		WriteJson(out, results);
+	}
+	else
+	{
+		WriteJson(std::cout, results);
+	}
+
+	// summary (and comparison with baseline) goes to stderr, so that standard output is a valid JSON
+	int regressionsCount = 0;
+	std::fprintf(stderr, "%10s %30s %12s %12s %12s\n", "fixture", "benchmark", "median ms", "baseline ms", "change");
+	for (auto& it : results)
+	{
+		std::fprintf(stderr, "%10s %30s %12.4f", it.fixture.c_str(), it.name.c_str(), it.medianInMs);
+		auto base = baseline.find(it.fixture + "/" + it.name);
+		if (base == baseline.end() || base->second <= 0.0)
+		{
+			std::fprintf(stderr, "\n");
+			continue;
+		}
+		double changePercent = (it.medianInMs / base->second - 1.0) * 100.0;
+		bool isRegression = changePercent > config.regressionThresholdPercent;
+		regressionsCount += isRegression ? 1 : 0;
+		std::fprintf(stderr, " %12.4f %+11.1f%%%s\n", base->second, changePercent, isRegression ? " REGRESSION" : "");
+	}
+	if (!baseline.empty())
+	{
+		std::fprintf(stderr, "%d regression(s) above %d%% threshold\n", regressionsCount, config.regressionThresholdPercent);
+	}
+	return regressionsCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "PlayField.h"
+
+// Micro benchmarks are available through --microBenchmarks cmd parameter: PlayField is populated
+// with fixed (seeded) sets of aliens, wall blocks, lasers and exploding aliens of a few sizes
+// and PlayField::Update() and its phases are timed separately. Results are written as JSON
+// (--benchmarkResults <file>, standard output by default) and they may be compared against
+// results stored before (--benchmarkBaseline <file>), in which case measurements slower than
+// baseline by more than --regressionThreshold percent (10 by default) are reported
+// and non-zero value is returned.
+int RunMicroBenchmarks(GameConfig& config);
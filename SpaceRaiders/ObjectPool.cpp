@@ -0,0 +1,189 @@
+#include "stdafx.h"
+#include <new>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include "ObjectPool.h"
+
+// pools are identified by their index in array of caches of each thread
+static std::atomic<int> gPoolsCount(0);
+
+// caches of one thread for all pools it has used, they are given back to pools when thread exits
+class PoolThreadCaches
+{
+public:
+	std::vector<ObjectPool::ThreadCache*> caches;
+	~PoolThreadCaches()
+	{
+		for (auto it : caches)
+		{
+			if (it != nullptr)
+			{
+				it->pool->ReleaseThreadCache(it);
+			}
+		}
+	}
+};
+static thread_local PoolThreadCaches tPoolThreadCaches;
+
+ObjectPool::ObjectPool(const char *name, size_t slotSize, int slotsPerChunk) :
+	m_name(name), m_id(gPoolsCount++), m_slotsPerChunk(slotsPerChunk)
+{
+	// every slot has to be able to hold free list link and has to be aligned for any object
+	const size_t alignment = alignof(std::max_align_t);
+	slotSize = std::max(slotSize, sizeof(FreeSlot));
+	m_slotSize = (slotSize + alignment - 1) / alignment * alignment;
+}
+
+ObjectPool::~ObjectPool()
+{
+	for (auto it : m_threadCaches)
+	{
+		delete it;
+	}
+	for (auto it : m_chunks)
+	{
+		::operator delete(it);
+	}
+}
+
+void ObjectPool::AllocateChunk()
+{
+	char *chunk = (char*)::operator new(m_slotSize * m_slotsPerChunk);
+	m_chunks.push_back(chunk);
+	m_heapAllocationsCount++;
+	// slots are linked in address order, so objects allocated one after another are adjacent
+	for (int i = m_slotsPerChunk - 1; i >= 0; i--)
+	{
+		FreeSlot *slot = (FreeSlot*)(chunk + i * m_slotSize);
+		slot->next = m_freeList;
+		m_freeList = slot;
+	}
+}
+
+ObjectPool::ThreadCache& ObjectPool::GetThreadCache()
+{
+	auto& caches = tPoolThreadCaches.caches;
+	if ((int)caches.size() <= m_id)
+	{
+		caches.resize(m_id + 1, nullptr);
+	}
+	if (caches[m_id] == nullptr)
+	{
+		ThreadCache *cache = new ThreadCache();
+		cache->pool = this;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_threadCaches.push_back(cache);
+		caches[m_id] = cache;
+	}
+	return *caches[m_id];
+}
+
+void ObjectPool::Refill(ThreadCache& cache)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (int i = 0; i < CacheBatchSize; i++)
+	{
+		if (m_freeList == nullptr)
+		{
+			AllocateChunk();
+		}
+		FreeSlot *slot = m_freeList;
+		m_freeList = slot->next;
+		slot->next = cache.freeList;
+		cache.freeList = slot;
+		cache.freeCount++;
+	}
+}
+
+void ObjectPool::Drain(ThreadCache& cache, int count)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (int i = 0; i < count && cache.freeList != nullptr; i++)
+	{
+		FreeSlot *slot = cache.freeList;
+		cache.freeList = slot->next;
+		cache.freeCount--;
+		slot->next = m_freeList;
+		m_freeList = slot;
+	}
+}
+
+void ObjectPool::ReleaseThreadCache(ThreadCache *cache)
+{
+	Drain(*cache, cache->freeCount);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_liveObjectsCount += cache->liveObjectsCount;
+	m_allocationsCount += cache->allocationsCount;
+	m_threadCaches.erase(std::find(m_threadCaches.begin(), m_threadCaches.end(), cache));
+	delete cache;
+}
+
+void* ObjectPool::Allocate(size_t size)
+{
+	assert(size <= m_slotSize);
+	ThreadCache& cache = GetThreadCache();
+	if (cache.freeList == nullptr)
+	{
+		Refill(cache);
+	}
+	FreeSlot *slot = cache.freeList;
+	cache.freeList = slot->next;
+	cache.freeCount--;
+	// counters are written only by this thread, so they don't need atomic increments
+	cache.liveObjectsCount.store(cache.liveObjectsCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	cache.allocationsCount.store(cache.allocationsCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	return slot;
+}
+
+void ObjectPool::Free(void *ptr)
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+	ThreadCache& cache = GetThreadCache();
+	FreeSlot *slot = (FreeSlot*)ptr;
+	slot->next = cache.freeList;
+	cache.freeList = slot;
+	cache.freeCount++;
+	cache.liveObjectsCount.store(cache.liveObjectsCount.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+	if (cache.freeCount >= 2 * CacheBatchSize)
+	{
+		Drain(cache, CacheBatchSize);
+	}
+}
+
+int ObjectPool::GetLiveObjectsCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	int count = m_liveObjectsCount;
+	for (auto it : m_threadCaches)
+	{
+		count += it->liveObjectsCount;
+	}
+	return count;
+}
+
+long long ObjectPool::GetAllocationsCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	long long count = m_allocationsCount;
+	for (auto it : m_threadCaches)
+	{
+		count += it->allocationsCount;
+	}
+	return count;
+}
+
+int ObjectPool::GetHeapAllocationsCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_heapAllocationsCount;
+}
+
+int ObjectPool::GetCapacity()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (int)m_chunks.size() * m_slotsPerChunk;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+// Free-list allocator for short-lived game objects of one class hierarchy (see operator new
+// overloads in Laser, Explosion and EAExplosionCell). Memory is taken from the heap in chunks
+// of slotsPerChunk slots and it is never given back until pool is destroyed, so once pool
+// has grown to the peak number of objects, allocations don't touch the heap anymore.
+// Objects are released by regular delete (i.e. in PlayField::ApplyObjectsCollectionChanges()
+// for objects with IsAutoDelete() set).
+// Allocate(...) may be called from many threads (update tasks, worlds simulated in parallel),
+// so each thread takes free slots from the pool (guarded by mutex) in batches of CacheBatchSize
+// and gives them back the same way, most of allocations don't touch shared state at all.
+class ObjectPool
+{
+public:
+	static const int CacheBatchSize = 32;
+	typedef struct FreeSlot
+	{
+		FreeSlot *next;
+	} FreeSlot;
+	// free slots and counters of one thread (counters are written only by owning thread)
+	typedef struct
+	{
+		ObjectPool *pool;
+		FreeSlot *freeList;
+		int freeCount;
+		std::atomic<long long> allocationsCount;
+		// may go below zero if objects are released by other thread than the one that allocated them
+		std::atomic<int> liveObjectsCount;
+	} ThreadCache;
+private:
+	const char *m_name;
+	int m_id;
+	size_t m_slotSize;
+	int m_slotsPerChunk;
+	std::vector<char*> m_chunks;
+	FreeSlot *m_freeList = nullptr;
+	std::mutex m_mutex;
+	std::vector<ThreadCache*> m_threadCaches;
+	// counters of threads which have already exited
+	int m_liveObjectsCount = 0;
+	long long m_allocationsCount = 0;
+	int m_heapAllocationsCount = 0;
+	void AllocateChunk();
+	ThreadCache& GetThreadCache();
+	void Refill(ThreadCache& cache);
+	void Drain(ThreadCache& cache, int count);
+public:
+	// slotSize has to be at least the size of the biggest class allocated from pool
+	ObjectPool(const char *name, size_t slotSize, int slotsPerChunk);
+	~ObjectPool();
+	void* Allocate(size_t size);
+	void Free(void *ptr);
+	const char* GetName() { return m_name; }
+	// number of objects allocated from pool and not released yet
+	int GetLiveObjectsCount();
+	// total number of Allocate(...) calls
+	long long GetAllocationsCount();
+	// number of Allocate(...) calls which had to take new chunk from the heap
+	int GetHeapAllocationsCount();
+	int GetCapacity();
+	// returns cached slots and counters of exiting thread to the pool
+	void ReleaseThreadCache(ThreadCache *cache);
+};
@@ -2,27 +2,63 @@
 #include "stdafx.h"
 #include <chrono>
 #include <thread>
+#include <cstring>
+#include <cstdio>
 #include <algorithm>
 #include "PlayField.h"
 #include "ExplodingAlien.h"
+#include "CollisionResponse.h"
+#include "PlayFieldSnapshot.h"
 
+typedef void(*GroupUpdateFunc)(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands);
 
-PlayField::PlayField(Vector2D iBounds, GameConfig& config) : 
-	m_bounds(iBounds), m_playerObject(nullptr), m_score(0),
+// update loop for each object type (nullptr for objects which don't need to be updated)
+static const GroupUpdateFunc gGroupUpdateFuncs[RI_End] =
+{
+	GameObject::UpdateEachObject,	// RI_Player
+	Alien::UpdateGroup,				// RI_Alien
+	Laser::UpdateGroup,				// RI_PlayerLaser
+	Laser::UpdateGroup,				// RI_AlienLaser
+	GameObject::UpdateTimedGroup,	// RI_Explosion
+	nullptr,						// RI_WallBlock
+	PowerUp::UpdateGroup,			// RI_PowerUp
+	GameObject::UpdateTimedGroup	// RI_ExplosionCell
+};
+
+PlayField::PlayField(Vector2D iBounds, GameConfig& config, Vector2D viewSize) : 
+	m_bounds(iBounds), m_fieldSize(iBounds), m_viewSize(viewSize.x > 0 && viewSize.y > 0 ? viewSize : iBounds), m_score(0),
+	m_random((UINT64)(unsigned int)config.seed),
 	m_gameOver(false), m_infoString(Vector2D(4, iBounds.y - 1)),
 	m_nextObjectsWaveTime(m_objectsSpawnWavesTimeDist),
-	m_displayInfo(config.displayGameInfo),
-	m_cotrollerInput(config.testRun ? (Input*)new RndInput() : new KeyboardInput()),
+	m_displayInfo(config.displayGameInfo || config.profileHud),
+	m_displayProfile(config.profileHud),
+	m_ownedInput(config.testRun ? (Input*)new RndInput(m_random) : new KeyboardInput()),
 	m_maxIterations(config.testRun ? config.testIterations : -1),
-	m_sleepTimeBetweenIterationsInMs(config.iterationSleepTimeInMs),
+	m_framePacer(config.iterationSleepTimeInMs, config.maxCatchUpIterations),
 	m_isAliensFriendFireEnabled(config.aliensFriendFire),
 	m_isSpecialFeatureEnabled(config.useSpecialFeature),
 	m_wallBlocksPosProvider((int)iBounds.x, std::max((int)((float)iBounds.y - 6.f), 0)), // size.y - 5 upper rows, (-6 because actual bounds are iBounds.y - 1)
 	m_aliensPosProvider((int)iBounds.x, std::min((int)((float)std::max(iBounds.y, 1.f) - 1.f), 4)), // 4 upper rows
-	m_isHardMode(config.hardMode)
+	m_isHardMode(config.hardMode),
+	// bounds.y is decremented below but alien lasers are still valid at y == m_bounds.y
+	// so collision grid has to cover all iBounds.y rows
+	m_collisionGrid((int)iBounds.x, (int)iBounds.y),
+	m_threadPool(config.workerThreads)
 {
+	m_cotrollerInput = m_ownedInput.get();
 	m_bounds.y -= 1;
-	if (config.displayGameInfo)
+	// info string is in the bottom line of the screen
+	m_infoString.GetPos().y = m_viewSize.y - 1;
+	if (config.maxAliens > 0)
+	{
+		MaxAliens = config.maxAliens;
+	}
+	if (config.maxWallBlocks > 0)
+	{
+		MaxBlockWalls = config.maxWallBlocks;
+	}
+	m_profiler.SetEnabled(config.profileFrames || config.profileHud);
+	if (m_displayInfo)
 	{
 		m_stringObjects.push_back(&m_infoString);
 	}
@@ -36,9 +72,43 @@ PlayField::PlayField(Vector2D iBounds, GameConfig& config) :
 	}
 }
 
+PlayField::~PlayField()
+{
+	// objects are removed from entity store first (store gives them their state back when it is destroyed)
+	for (int type = 0; type < RI_End; type++)
+	{
+		EntityGroup& group = m_entityStore.GetGroup((RaiderObjectTypeId)type);
+		while (group.Size() > 0)
+		{
+			GameObject* obj = group.objects[group.Size() - 1];
+			m_entityStore.Remove(obj->GetHandle());
+			// caught power-ups aren't auto deleted, they are released below
+			if (obj->IsAutoDelete())
+			{
+				delete obj;
+			}
+		}
+	}
+	for (auto obj : m_gameObjectsToAdd)
+	{
+		delete obj;
+	}
+	for (auto it : m_catchedPowerUpes)
+	{
+		delete it.second;
+	}
+	for (auto& recycled : m_recycledObjects)
+	{
+		for (auto obj : recycled)
+		{
+			delete obj;
+		}
+	}
+}
+
 int PlayField::GetCenteredStringXPosition(std::string& str)
 {
-	return ((int)m_bounds.x - (int)str.size()) / 2;
+	return ((int)m_viewSize.x - (int)str.size()) / 2;
 }
 
 void PlayField::AddCenteredString(std::string str, StringObject &dest, int y)
@@ -47,11 +117,18 @@ void PlayField::AddCenteredString(std::string str, StringObject &dest, int y)
 	m_stringObjects.push_back(&dest);
 }
 
+void PlayField::SetInputLatencyStamp(INT64 arrivalTimeNs)
+{
+	m_inputArrivalTimeNs = arrivalTimeNs;
+	m_inputConsumedTimeNs = (INT64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void PlayField::NotifyGameOver()
 {
 	m_gameOver = true;
-	AddCenteredString(" Game Over ", m_gameOverString, 13);
-	AddCenteredString(" Score: " + std::to_string(m_score) + " ", m_scoreString, 15);
+	AddCenteredString(" Game Over ", m_gameOverString, (int)m_viewSize.y / 2 - 1);
+	AddCenteredString(" Score: " + std::to_string(m_score) + " ", m_scoreString, (int)m_viewSize.y / 2 + 1);
 }
 
 // displaying game info string at the bottom line of the game screen
@@ -63,6 +140,16 @@ void PlayField::UpdateGameInfo()
 		m_currIteration++;
 		return;
 	}
+	if (m_displayProfile)
+	{
+		// histograms are summarized only every few iterations (HUD doesn't have to change faster)
+		if (m_currIteration++ % ProfileHudRefreshIterations == 0)
+		{
+			m_infoString.GetStr() = m_profiler.GetHudString();
+			m_infoString.GetPos().x = (float)GetCenteredStringXPosition(m_infoString.GetStr());
+		}
+		return;
+	}
 	m_infoString.GetStr().reserve(100);
 	m_infoString.GetStr().resize(100);
 	std::sprintf((char*)m_infoString.GetStr().c_str(),
@@ -77,20 +164,57 @@ bool PlayField::IsStillRunning()
     return !m_gameOver && (m_maxIterations == -1 || m_currIteration < m_maxIterations);
 }
 
-void PlayField::WaitBetweenIterations()
+int PlayField::WaitBetweenIterations()
 {
-    std::this_thread::sleep_for(std::chrono::milliseconds(
-        m_sleepTimeBetweenIterationsInMs));
+    return m_framePacer.WaitForNextFrame();
 }
 
 void PlayField::SetupGame()
 {
     // Populate aliens
 	SpawnAliens(0/*m_startingAliensCount*/, m_isSpecialFeatureEnabled);
-    // Add player
-    AddPlayerObject(Vector2D(40, 27));
+    // Add player (in the middle of the bottom row)
+    AddPlayerObject(Vector2D((float)((int)m_bounds.x / 2), m_bounds.y - 1));
     // Add wall blocks
-    SpawnWallBlocks(100);
+    SpawnWallBlocks(MaxBlockWalls);
+}
+
+bool PlayField::LoadSnapshot(const char* path)
+{
+	if (!PlayFieldSnapshot::RestoreFile(*this, path))
+	{
+		std::printf("Error can't restore %s (file can't be read or it isn't a snapshot of %dx%d play field)\n",
+			path, (int)m_fieldSize.x, (int)m_fieldSize.y);
+		return false;
+	}
+	if (m_maxIterations >= 0)
+	{
+		m_maxIterations += m_currIteration;
+	}
+	return true;
+}
+
+bool PlayField::Fork(PlayField& branch)
+{
+	if (m_forkStateIteration != m_currIteration)
+	{
+		PlayFieldSnapshot::Save(*this, m_forkState);
+		m_forkStateIteration = m_currIteration;
+	}
+	branch.m_isRecyclingObjects = true;
+	return PlayFieldSnapshot::Restore(branch, m_forkState.data(), m_forkState.size());
+}
+
+bool PlayField::SaveSnapshot(const char* path)
+{
+	std::vector<unsigned char> snapshot;
+	PlayFieldSnapshot::Save(*this, snapshot);
+	if (!PlayFieldSnapshot::WriteFile(path, snapshot))
+	{
+		std::printf("Error can't write snapshot file %s\n", path);
+		return false;
+	}
+	return true;
 }
 
 void PlayField::Update()
@@ -99,26 +223,123 @@ void PlayField::Update()
 	{
 		return;
 	}
-	m_cotrollerInput->Update();
-	// clear collision map first
-	for (int i = 0; i < COLLISION_MAP_SIZE; i++)
+	PROFILE_BEGIN_TICK(m_profiler);
+	// state is captured again for branches forked in this iteration
+	m_forkStateIteration = -1;
+	// all random draws in this iteration are keyed by iteration number
+	m_random.SetTick((UINT32)m_currIteration);
 	{
-		m_collisionMap[i].clear();
+		PROFILE_SCOPE(m_profiler, PP_Input);
+		m_cotrollerInput->Update();
 	}
-	for (auto it : m_gameObjects)
 	{
-		if (!it->IsActive())
+		PROFILE_SCOPE(m_profiler, PP_Update);
+		UpdateObjects();
+	}
+	{
+		// collisions are checked once all objects have been moved
+		PROFILE_SCOPE(m_profiler, PP_Collisions);
+		HandleCollisions();
+	}
+	//HandleSpawningNewObjects();
+	{
+		PROFILE_SCOPE(m_profiler, PP_PowerUps);
+		HandlePowerUpes();
+	}
+	{
+		PROFILE_SCOPE(m_profiler, PP_CollectionChanges);
+		ApplyObjectsCollectionChanges();
+	}
+	{
+		PROFILE_SCOPE(m_profiler, PP_GameInfo);
+		UpdateGameInfo();
+	}
+}
+
+void PlayField::UpdateObjects()
+{
+	// 1. each group of objects is split into contiguous chunks updated in parallel,
+	// each chunk records its side effects into its own commands buffer
+	m_updateTasks.clear();
+	for (int type = 0; type < RI_End; type++)
+	{
+		int objectsCount = m_entityStore.GetGroup((RaiderObjectTypeId)type).Size();
+		if (gGroupUpdateFuncs[type] == nullptr || objectsCount == 0)
 		{
 			continue;
 		}
-		it->Update(*this);
-		// Check collisions with already updated objects
-		HandleCollisions(it);
+		int chunksCount = std::min(m_threadPool.GetThreadsCount() * 4, objectsCount / MinObjectsPerUpdateTask);
+		chunksCount = std::max(chunksCount, 1);
+		for (int chunk = 0; chunk < chunksCount; chunk++)
+		{
+			m_updateTasks.push_back({ (RaiderObjectTypeId)type,
+				(int)((long long)objectsCount * chunk / chunksCount),
+				(int)((long long)objectsCount * (chunk + 1) / chunksCount) });
+		}
+	}
+	int tasksCount = (int)m_updateTasks.size();
+	if ((int)m_updateCommands.size() < tasksCount)
+	{
+		m_updateCommands.resize(tasksCount);
+	}
+	m_threadPool.Run(tasksCount, [this](int task)
+	{
+		WorldCommands& commands = m_updateCommands[task];
+		commands.Clear();
+		UpdateTask& updateTask = m_updateTasks[task];
+		gGroupUpdateFuncs[updateTask.type](m_entityStore.GetGroup(updateTask.type),
+			updateTask.begin, updateTask.end, *this, commands);
+	});
+	// 2. chunks are merged in objects order, so commands are applied exactly
+	// in the same order as if all objects were updated on one thread
+	for (int task = 0; task < tasksCount; task++)
+	{
+		ApplyWorldCommands(m_updateCommands[task]);
+	}
+	HandleScheduledEvents();
+}
+
+void PlayField::HandleScheduledEvents()
+{
+	m_dueEvents.clear();
+	m_scheduler.PopDue((UINT32)m_currIteration, m_dueEvents);
+	m_eventCommands.Clear();
+	// transformation changes alien fire rate, so transform attempts are handled before fire events
+	for (int type = SE_AlienTransform; type <= SE_AlienFire; type++)
+	{
+		for (auto& it : m_dueEvents)
+		{
+			GameObject* obj = m_entityStore.GetObject(it.handle);
+			if (it.type != type || obj == nullptr || !obj->IsActive() || obj->GetType() != RI_Alien)
+			{
+				continue;
+			}
+			static_cast<Alien*>(obj)->OnScheduledEvent(*this, m_eventCommands, (ScheduledEventType)type, it.tick);
+		}
+	}
+	ApplyWorldCommands(m_eventCommands);
+}
+
+void PlayField::ApplyWorldCommands(WorldCommands& commands)
+{
+	for (auto& it : commands.GetCommands())
+	{
+		switch (it.type)
+		{
+		case WC_AddObject: AddObject(it.obj); break;
+		case WC_DespawnLaser: DespawnLaser(it.obj); break;
+		case WC_RemoveObject: m_objectsToRemove.push_back(it.obj->GetHandle()); break;
+		case WC_GameOver: NotifyGameOver(); break;
+		case WC_FireLasers:
+			// lasers limit is checked here (not in Update(...)) since it depends
+			// on lasers spawned and despawned by previously updated objects
+			if (CanNewLasersBeSpawned(it.laserType, it.count))
+			{
+				static_cast<SpaceShip*>(it.obj)->FireLasers(*this);
+			}
+			break;
+		}
 	}
-	//HandleSpawningNewObjects();
-	HandlePowerUpes();
-	ApplyObjectsCollectionChanges();
-	UpdateGameInfo();
 }
 
 bool PlayField::CanNewLasersBeSpawned(RaiderObjectTypeId laserType, int count)
@@ -155,78 +376,128 @@ else if (newObj->GetType() == RI_PlayerLaser)
 void PlayField::SetTriplePlayerLaser()
 {
 	MaxPlayerLasers *= 3;
-	m_playerObject->SetTripleShots(true);
+	if (GetPlayerObject() != nullptr)
+		GetPlayerObject()->SetTripleShots(true);
 }
 
 void PlayField::UnsetTriplePlayerLaser()
 {
 	MaxPlayerLasers /= 3;
-	m_playerObject->SetTripleShots(false);
+	if (GetPlayerObject() != nullptr)
+		GetPlayerObject()->SetTripleShots(false);
 }
 
 void PlayField::AddPlayerObject(Vector2D pos)
 {
-	m_playerObject = new PlayerShip(pos);
-	AddObject(m_playerObject);
+	PlayerShip* playerObject = new PlayerShip(pos);
+	AddObject(playerObject);
+	m_playerHandle = playerObject->GetHandle();
 }
 
 void PlayField::AddObject(GameObject* newObj)
 {
+	m_entityStore.CreateHandle(newObj);
+	newObj->OnAddedToWorld(*this);
 	m_gameObjectsToAdd.push_back(newObj);
+	m_forkStateIteration = -1;
 }
 
 void PlayField::RemoveObject(GameObject* obj)
 {
 	obj->SetToInactive();
+	m_objectsToRemove.push_back(obj->GetHandle());
+	m_forkStateIteration = -1;
 }
 
-// gets collision vector based on hash function applied on objects collision point
-std::vector<std::pair<Vector2D, GameObjPtr>>* PlayField::GetCollisionVector(Vector2D& pos)
+void PlayField::HandleCollisions()
 {
-	if (pos.x < 0 || pos.y < 0)
+	// each object submits segment between its previous and current position,
+	// so objects that crossed each other's paths (or that moved for more than one cell
+	// since last iteration) are still found in the same grid cell
+	m_collisionGrid.Clear();
+	for (int type = 0; type < RI_End; type++)
 	{
-		return nullptr;
+		EntityGroup& group = m_entityStore.GetGroup((RaiderObjectTypeId)type);
+		for (int i = 0; i < group.Size(); i++)
+		{
+			if (!group.isActive[i])
+			{
+				continue;
+			}
+			m_collisionGrid.AddSegment(group.posPrev[i], group.pos[i], EntityStore::MakeEntityId((RaiderObjectTypeId)type, i),
+				group.handle[i], (RaiderObjectTypeId)type, group.collisionMask[i]);
+		}
 	}
-	int index = ((int)pos.y % COLLISION_MAP_Y_CELLS) * COLLISION_MAP_X_CELLS + ((int)pos.x % COLLISION_MAP_X_CELLS);
-	return &m_collisionMap[index];
-}
+	m_collisionGrid.Build();
 
-void PlayField::HandleCollisions(GameObject* obj)
-{
-	if (!obj->IsActive())
+	// 1. gather contacts from all cells
+	m_contacts.clear();
+	for (int c = 0; c < m_collisionGrid.GetCellsCount(); c++)
 	{
-		return;
-	}
-	m_tmpCollisionPoints.clear();
-	// each object can provide more than 1 collision point
-	// to handle situation when 2 objects crosses they paths in point
-	// that is not occupied by any of them after update
-	// so the assumption here is that they will provide
-	// all points they touched since last iteration (inclusively)
-	// and we will check collisions for all of these points
-	obj->GetCollisionPoints(m_tmpCollisionPoints);
-	for (auto vIt : m_tmpCollisionPoints)
-	{
-		// get collision vector based on current collision point
-		auto collisionVector = GetCollisionVector(vIt);
-		if (collisionVector == nullptr)
+		auto& cell = m_collisionGrid.GetCell(c);
+		// skip cells in which no pair of objects is able to collide
+		// before doing any narrowphase checks
+		if (!CollisionGrid::IsCellColliding(cell))
 		{
 			continue;
 		}
-		for (auto it : *collisionVector)
+		int count = cell.count;
+		auto entries = m_collisionGrid.GetCellEntries(cell);
+		// entries are in entity id order, so (as before) object updated later
+		// is checked against objects updated before it
+		for (int j = 1; j < count; j++)
 		{
-			if (it.second->IsActive() && CheckObjectsCollision(*obj, *it.second))
+			RaiderObjectTypeId objType = EntityStore::GetEntityType(entries[j]);
+			EntityGroup& objGroup = m_entityStore.GetGroup(objType);
+			int objIndex = EntityStore::GetEntityIndex(entries[j]);
+			for (int i = 0; i < j; i++)
 			{
-				// this means that obj is inactive after collision (CheckObjectsCollision(...) returned true)
-				break;
+				RaiderObjectTypeId otherType = EntityStore::GetEntityType(entries[i]);
+				// most of pairs (i.e. wall blocks vs aliens) are rejected here
+				// without any narrowphase test or handler call
+				if (!CanObjectsCollide(objType, otherType))
+				{
+					continue;
+				}
+				EntityGroup& otherGroup = m_entityStore.GetGroup(otherType);
+				int otherIndex = EntityStore::GetEntityIndex(entries[i]);
+				Contact contact = { 0.f, Vector2D(), entries[j], entries[i] };
+				if (SweepObjects(objGroup.posPrev[objIndex], objGroup.pos[objIndex],
+					otherGroup.posPrev[otherIndex], otherGroup.pos[otherIndex], contact.toi, contact.point))
+				{
+					m_contacts.push_back(contact);
+				}
 			}
 		}
-		if (!obj->IsActive())
+	}
+
+	// 2. resolve contacts in time of impact order, the same pair of objects may
+	// be reported by more than one cell so duplicates are skipped
+	std::sort(m_contacts.begin(), m_contacts.end(), [](const Contact& c1, const Contact& c2)
+	{
+		if (c1.toi != c2.toi)
+			return c1.toi < c2.toi;
+		if (c1.obj != c2.obj)
+			return c1.obj < c2.obj;
+		return c1.other < c2.other;
+	});
+	for (size_t i = 0; i < m_contacts.size(); i++)
+	{
+		auto& contact = m_contacts[i];
+		if (i > 0 && m_contacts[i - 1].obj == contact.obj && m_contacts[i - 1].other == contact.other)
 		{
-			break;
+			continue;
+		}
+		GameObject* obj = m_entityStore.GetGroup(EntityStore::GetEntityType(contact.obj))
+			.objects[EntityStore::GetEntityIndex(contact.obj)];
+		GameObject* other = m_entityStore.GetGroup(EntityStore::GetEntityType(contact.other))
+			.objects[EntityStore::GetEntityIndex(contact.other)];
+		// object could have been destroyed by contact with earlier time of impact
+		if (!obj->IsActive() || !other->IsActive())
+		{
+			continue;
 		}
-		// add obj collision point to collison map
-		collisionVector->push_back({ vIt, obj });
+		ResolveCollision(*obj, *other, *this, contact.point);
 	}
 }
 
@@ -238,51 +509,57 @@ void PlayField::NotifyWallBlockDestroyed()
 void PlayField::NotifyAlienDestroyed()
 {
 	m_aliensCount--;
+	m_aliensKilledCount++;
 }
 
-// returns true if o1 has beed destroyed, false otherwise
-bool PlayField::CheckObjectsCollision(GameObject& o1, GameObject& o2)
+// Continuous collision test of objects moving along m_posPrev -> m_pos segments
+// during one iteration (both at constant speed, t = 0 is previous iteration, t = 1 is current one).
+// Objects are colliding if distance between their cells gets to CollisionRadius or below.
+// Returns true if objects have collided, toiOut is time when they touched each other
+// and contactOut is o1 position at the moment when they were closest to each other
+// (i.e. 2 opposite lasers crossing their paths are closest in the middle of their paths).
+bool PlayField::SweepObjects(const Vector2D& posPrev1, const Vector2D& pos1, const Vector2D& posPrev2, const Vector2D& pos2,
+	float& toiOut, Vector2D& contactOut)
 {
-	// This algorighm can be little inaccurate in general case but for our game
-	// where motion vectors are short this should work
-
-	// 1. Check if they current objects positions are colliding
-	if (o1.GetPos().IntCmp(o2.GetPos()))
+	// distance is computed between cells that objects occupy (not their exact positions),
+	// this is what player sees on the screen
+	float rx = FLOOR(posPrev2.x) - FLOOR(posPrev1.x);
+	float ry = FLOOR(posPrev2.y) - FLOOR(posPrev1.y);
+	float dx = (FLOOR(pos2.x) - FLOOR(posPrev2.x)) - (FLOOR(pos1.x) - FLOOR(posPrev1.x));
+	float dy = (FLOOR(pos2.y) - FLOOR(posPrev2.y)) - (FLOOR(pos1.y) - FLOOR(posPrev1.y));
+	// |r + t * d|^2 <= R^2  ->  a * t^2 + b * t + c <= 0
+	float a = dx * dx + dy * dy;
+	float b = 2.f * (rx * dx + ry * dy);
+	float c = rx * rx + ry * ry - CollisionRadius * CollisionRadius;
+	if (c <= 0.f)
 	{
-		o1.CheckCollision(o2, *this, o1.GetPos());
-		o2.CheckCollision(o1, *this, o1.GetPos());
-		return !o1.IsActive();
+		toiOut = 0.f;
 	}
-
-	// 2. Check if their mid positions are colliding
-	//    i.e we have 2 opposite lasers that in game iteration x had positions a=(20, 9) and b=(20, 10)
-	//	  and in game iteration x + 1 they have a=(20, 10) and b=(20, 9), so that they
-	//    are not colliding with each other in their current positions but
-	//    they are colliding with each other in the middle of their paths between
-	//    game iteration x and x + 1
-	auto o1PosPrev = o1.GetPosPrev();
-	auto o2PosPrev = o2.GetPosPrev();
-	Vector2D xy1((FLOOR(o1PosPrev.x) + FLOOR(o1.GetPos().x)) / 2,
-		(FLOOR(o1PosPrev.y) + FLOOR(o1.GetPos().y)) / 2);
-	float x2 = (FLOOR(o2PosPrev.x) + FLOOR(o2.GetPos().x)) / 2;
-	float y2 = (FLOOR(o2PosPrev.y) + FLOOR(o2.GetPos().y)) / 2;
-	float xDiff = x2 - xy1.x;
-	float yDiff = y2 - xy1.y;
-	// assume that if distance between movement mid points of comparing
-	// objects is at least 0.8, they have just collided
-	if (xDiff * xDiff + yDiff * yDiff <= 0.64f) // 0.64 == 0.8 * 0.8
+	else
 	{
-		o1.CheckCollision(o2, *this, xy1);
-		o2.CheckCollision(o1, *this, xy1);
+		float discriminant = b * b - 4.f * a * c;
+		if (a == 0.f || discriminant < 0.f)
+		{
+			return false;
+		}
+		toiOut = (-b - sqrt(discriminant)) / (2.f * a);
+		if (toiOut < 0.f || toiOut > 1.f)
+		{
+			return false;
+		}
 	}
-	return !o1.IsActive();
+	float closest = a > 0.f ? std::min(std::max(-b / (2.f * a), toiOut), 1.f) : 1.f;
+	contactOut = Vector2D(posPrev1.x + closest * (pos1.x - posPrev1.x),
+		posPrev1.y + closest * (pos1.y - posPrev1.y));
+	return true;
 }
 
 void PlayField::SpawnWallBlocks(int count)
 {
+	RandomStream random = m_random.GetStream(WorldRandom::WorldEntity, RP_SpawnWallBlocks);
 	m_wallBlocksPosProvider.InitRandomFreePositions();
 	Vector2D pos;
-	for (int i = 0; i < count && m_wallBlocksPosProvider.GetNextRandomPosition(pos) 
+	for (int i = 0; i < count && m_wallBlocksPosProvider.GetNextRandomPosition(pos, random) 
 		&& m_wallBlocksCount < MaxBlockWalls; i++)
 	{
 		AddObject(new WallBlock(pos));
@@ -297,20 +574,21 @@ void PlayField::SpawnAliens(int count, bool allowForExplodingAlien)
 	{
 		return;
 	}
+	RandomStream random = m_random.GetStream(WorldRandom::WorldEntity, RP_SpawnAliens);
 	m_aliensPosProvider.InitRandomFreePositions();
 	Vector2D pos;
-	for (int i = 0; i < count && m_aliensPosProvider.GetNextRandomPosition(pos); i++)
+	for (int i = 0; i < count && m_aliensPosProvider.GetNextRandomPosition(pos, random); i++)
 	{
-		AddObject(new Alien(pos, m_aliensVelocityY, m_isAliensFriendFireEnabled));
+		AddObject(new Alien(pos, m_aliensVelocityY));
 		m_aliensCount++;
 	}
 
 	// if allowForExplodingAlien==true, spawn exploding alien with 50% prob.
-	if (allowForExplodingAlien && getRandInt(0, 1) == 0
-		&& m_aliensPosProvider.GetNextRandomPosition(pos) && m_aliensCount < MaxAliens)
+	if (allowForExplodingAlien && random.GetInt(0, 1) == 0
+		&& m_aliensPosProvider.GetNextRandomPosition(pos, random) && m_aliensCount < MaxAliens)
 	{
 		// Exploding aliens will go down faster to provide more fun
-		AddObject(new ExplodingAlien(pos, m_aliensVelocityY * 3.f, m_isAliensFriendFireEnabled));
+		AddObject(new ExplodingAlien(pos, m_aliensVelocityY * 3.f));
 		m_aliensCount++;
 	}
 }
@@ -320,7 +598,7 @@ void PlayField::HandlePowerUpes()
 	m_powerUpsToDelete.clear();
 	for (auto it : m_catchedPowerUpes)
 	{
-		if (!it.second->Tick())
+		if (!it.second->Tick(*this))
 		{
 			m_powerUpsToDelete.push_back(it.second);
 		}
@@ -332,13 +610,18 @@ void PlayField::HandlePowerUpes()
 	}
 }
 
-void PlayField::AddPowerUp(Vector2D& pos)
+void PlayField::AddPowerUp(Vector2D& pos, RandomStream& random)
 {
-	switch (getRandInt(0, 2))
+	// there is nobody to catch power-ups without player (i.e. in benchmarks)
+	if (GetPlayerObject() == nullptr)
 	{
-	case 0: AddObject(new MovementSpeedPowerUp(*m_playerObject, pos)); break;
-	case 1: AddObject(new FasterShotsPowerUp(*this, pos)); break;
-	case 2: AddObject(new TripleShotsPowerUp(*this, pos)); break;
+		return;
+	}
+	switch (random.GetInt(0, 2))
+	{
+	case 0: AddObject(new MovementSpeedPowerUp(pos)); break;
+	case 1: AddObject(new FasterShotsPowerUp(pos)); break;
+	case 2: AddObject(new TripleShotsPowerUp(pos)); break;
 	}
 }
 
@@ -350,42 +633,52 @@ void PlayField::ActivatePowerUp(PowerUp& powerUp)
 		it->second->Merge(powerUp);
 		return;
 	}
-	powerUp.OnPowerUpCatched();
+	powerUp.OnPowerUpCatched(*this);
 	m_catchedPowerUpes.insert({ powerUp.GetType(), &powerUp });
-	// object will be removed from m_gameObjects collection but not deleted from memory
+	// object will be removed from play field but not deleted from memory
 	powerUp.SetAutoDelete(false);
 }
 
 void PlayField::ApplyObjectsCollectionChanges()
 {
-	// we will swap all inactive objects with locally last object and then shrink vector size,
-	// this should be faster then searching through whole vector every time we want to delete an object
-	size_t sizeUpdated = m_gameObjects.size();
-	for (size_t i = 0; i < sizeUpdated; i++)
+	// remove objects reported in this iteration from entity store
+	// and release them (calling delete ...) if necessary
+	for (auto handle : m_objectsToRemove)
 	{
-		if (!m_gameObjects[i]->IsActive())
+		GameObject* obj = m_entityStore.GetObject(handle);
+		if (obj == nullptr)
 		{
-			iter_swap(m_gameObjects.begin() + i, m_gameObjects.begin() + sizeUpdated - 1);
-			sizeUpdated--;
-			// we have to also check the object just swapped from the end
-			// so we will handle the same index in next iteration
-			i--;
+			// already removed
+			continue;
 		}
-	}
-	if (sizeUpdated != m_gameObjects.size())
-	{
-		// remove inactive objects from m_gameObjects collection
-		// and release them (calling delete ...) if necessary
-		for (size_t i = sizeUpdated; i < m_gameObjects.size(); i++)
+		if (obj->IsActive())
+		{
+			// object has revived itself in OnObjectDestroyed(...)
+			// (i.e. exploding alien which has turned into its explosion)
+			m_entityStore.Regroup(handle);
+			continue;
+		}
+		m_entityStore.Remove(handle);
+		if (obj->IsAutoDelete())
 		{
-			if (m_gameObjects[i]->IsAutoDelete())
+			if (m_isRecyclingObjects)
+			{
+				// branch recreates objects it has lost in its simulation with the next fork
+				m_recycledObjects[obj->GetClass()].push_back(obj);
+			}
+			else
 			{
-				delete m_gameObjects[i];
+				delete obj;
 			}
 		}
-		m_gameObjects.resize(sizeUpdated);
 	}
-	m_gameObjects.insert(m_gameObjects.end(), m_gameObjectsToAdd.begin(), m_gameObjectsToAdd.end());
+	m_objectsToRemove.clear();
+	m_objectsAddedAfterCollisions.clear();
+	for (auto it : m_gameObjectsToAdd)
+	{
+		m_entityStore.Add(it);
+		m_objectsAddedAfterCollisions.push_back(it->GetHandle());
+	}
 	m_gameObjectsToAdd.clear();
 }
 
@@ -394,16 +687,18 @@ void PlayField::FillObjectsPositionMaps()
 {
 	m_wallBlocksPosProvider.Clear();
 	m_aliensPosProvider.Clear();
-	for (auto it : m_gameObjects)
+	RandomPositionProvider* providers[] = { &m_aliensPosProvider, &m_wallBlocksPosProvider };
+	RaiderObjectTypeId types[] = { RI_Alien, RI_WallBlock };
+	for (int p = 0; p < 2; p++)
 	{
-		if (it->GetPos().x < 0 || it->GetPos().y < 0)
+		for (auto& pos : m_entityStore.GetGroup(types[p]).pos)
 		{
-			continue;
+			if (pos.x < 0 || pos.y < 0 || (int)pos.y >= providers[p]->getSizeY())
+			{
+				continue;
+			}
+			providers[p]->SetPosition((int)pos.x, (int)pos.y, true);
 		}
-		if (it->GetType() == RI_Alien && (int)it->GetPos().y < m_aliensPosProvider.getSizeY())
-			m_aliensPosProvider.SetPosition((int)it->GetPos().x, (int)it->GetPos().y, true);
-		else if(it->GetType() == RI_WallBlock && (int)it->GetPos().y < m_wallBlocksPosProvider.getSizeY())
-			m_wallBlocksPosProvider.SetPosition((int)it->GetPos().x, (int)it->GetPos().y, true);
 	}
 }
 
@@ -414,13 +709,14 @@ void PlayField::HandleSpawningNewObjects()
 		return;
 	}
 	m_nextObjectsWaveTime = m_objectsSpawnWavesTimeDist;
+	RandomStream random = m_random.GetStream(WorldRandom::WorldEntity, RP_SpawnWave);
 	FillObjectsPositionMaps();
 	SpawnWallBlocks(3);
-	SpawnAliens(getRandInt((int)m_currMinAliensSpawnedPerWave, (int)m_currMaxAliensSpawnedPerWave),
+	SpawnAliens(random.GetInt((int)m_currMinAliensSpawnedPerWave, (int)m_currMaxAliensSpawnedPerWave),
 		m_isSpecialFeatureEnabled);
 
 	// 50% prob. of min max aliens count increase for next wave
-	float mul = (float)getRandInt(0, 1);
+	float mul = (float)random.GetInt(0, 1);
 	m_currMinAliensSpawnedPerWave = std::min(m_currMinAliensSpawnedPerWave * (1 + (mul * 0.10f)), 
 		MaxAliensSpawnedPerWave/2.f);
 	m_currMaxAliensSpawnedPerWave = std::min(m_currMaxAliensSpawnedPerWave * (1 + (mul * 0.20f)), 
@@ -3,10 +3,19 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <algorithm>
+#include <memory>
 #include "GameObjects.h"
 #include "Input.h"
 #include "PowerUp.h"
 #include "PositionMap.h"
+#include "CollisionGrid.h"
+#include "ThreadPool.h"
+#include "WorldCommands.h"
+#include "EntityStore.h"
+#include "TickScheduler.h"
+#include "FrameProfiler.h"
+#include "FramePacer.h"
 
 typedef struct
 {
@@ -18,27 +27,101 @@ typedef struct
     bool aliensFriendFire;
     int seed;
     int iterationSleepTimeInMs;
+    bool runBenchmarks;
+    int workerThreads;
+    bool runHeadless;
+    // batch mode: number of seeds played (starting from seed), 0 if batch mode is disabled
+    int batchSeedsCount;
+    bool batchAllVariants;
+    const char *batchResultsPath;
+    bool runMicroBenchmarks;
+    const char *benchmarkResultsPath;
+    const char *benchmarkBaselinePath;
+    int regressionThresholdPercent;
+    int fieldSizeX;
+    int fieldSizeY;
+    // entities limits, 0 means default limit
+    int maxAliens;
+    int maxWallBlocks;
+    // frame profiler (report at the end of the game), profileHud shows it also instead of game info
+    bool profileFrames;
+    bool profileHud;
+    // iterations run at once when game is late (0 - FramePacer::DefaultMaxCatchUpSteps)
+    int maxCatchUpIterations;
+    // frames are drawn on separate thread (see RenderThread)
+    bool renderThread;
+    // drawn frames are recorded into this file (see FrameRecorder), nullptr if recording is disabled
+    const char *recordPath;
+    // 0 - FrameRecorder::DefaultKeyframeInterval
+    int recordKeyframeInterval;
+    // playback mode: recording which is drawn instead of playing the game (see Playback.h)
+    const char *playPath;
+    int playFromFrame;
+    // input of the game is recorded into this file (see ReplayRecorder), nullptr if recording is disabled
+    const char *recordInputPath;
+    // ticks between snapshots of recorded game (0 - ReplayRecorder::DefaultSnapshotInterval)
+    int replaySnapshotInterval;
+    // replay mode: game recorded with recordInputPath is played again (see Replay.h)
+    const char *replayPath;
+    // 0 - the first recorded tick
+    int replayFromTick;
+    // game starts from this snapshot instead of a new game, nullptr - new game
+    const char *loadSnapshotPath;
+    // snapshot of the final state is written into this file, nullptr if it isn't saved
+    const char *saveSnapshotPath;
+    // script of key presses played instead of keyboard (see InputThread::StartSynthetic(...)), nullptr - keyboard
+    const char *syntheticInputScript;
+    // player is controlled by LookaheadBot instead of keyboard / random input
+    bool lookaheadBot;
 } GameConfig;
 
 class PlayField
 {
+	// micro benchmarks are timing private update phases separately
+	friend class PlayFieldFixture;
+	// snapshot saves and restores whole state of play field
+	friend class PlayFieldSnapshot;
 private:
-	std::vector<GameObjPtr> m_gameObjects;
+	WorldRandom				m_random;
+	EntityStore				m_entityStore;
 	std::vector<GameObjPtr> m_gameObjectsToAdd;
+	// handles of objects removed in current iteration (objects may be reported more than once)
+	std::vector<ObjectHandle> m_objectsToRemove;
+	// objects added to entity store after collision grid has been built in current iteration
+	std::vector<ObjectHandle> m_objectsAddedAfterCollisions;
+	// entity ids found by ForEachObjectInRect(...) (kept as member to avoid reallocations)
+	std::vector<int> m_rectQueryIds;
 	StringObject			m_scoreString;
 	StringObject			m_gameOverString;
-	static const int COLLISION_MAP_X_CELLS = 20;
-	static const int COLLISION_MAP_Y_CELLS = 20;
-	static const int COLLISION_MAP_SIZE = COLLISION_MAP_X_CELLS * COLLISION_MAP_Y_CELLS;
 	int						m_objectsSpawnWavesTimeDist = 50;
 	int						m_wallBlocksCount = 0;
     int                     m_maxIterations = -1;
-    int                     m_sleepTimeBetweenIterationsInMs = 50;
+    FramePacer              m_framePacer;
 	int						m_startingAliensCount = 20;
-	std::vector<std::pair<Vector2D, GameObjPtr>> m_collisionMap[COLLISION_MAP_SIZE];
+	CollisionGrid			m_collisionGrid;
+	ThreadPool				m_threadPool;
+	typedef struct
+	{
+		RaiderObjectTypeId type;
+		int begin;
+		int end;
+	} UpdateTask;
+	std::vector<UpdateTask> m_updateTasks;
+	// one commands buffer per chunk of objects updated by a single pool task
+	std::vector<WorldCommands> m_updateCommands;
+	TickScheduler			m_scheduler;
+	std::vector<ScheduledEvent> m_dueEvents;
+	WorldCommands			m_eventCommands;
 	std::vector<StringObject*> m_stringObjects;
 	std::vector<GameObjPtr> m_invisibleObjects;
-	std::vector<Vector2D>   m_tmpCollisionPoints; // putting it here just to avoid frequent dynamic mem allocation in case of decaring on stack
+	typedef struct
+	{
+		float toi;
+		Vector2D point;
+		int obj;
+		int other;
+	} Contact;
+	std::vector<Contact>	m_contacts; // putting it here just to avoid frequent dynamic mem allocation in case of decaring on stack
 	std::map<PowerUpType, PowerUp*>		m_catchedPowerUpes;
 	std::vector<PowerUp*>				m_powerUpsToDelete;
 	RandomPositionProvider		m_aliensPosProvider;
@@ -52,47 +135,150 @@ private:
 	bool					m_isAliensFriendFireEnabled;
 	float					m_aliensVelocityY = 0.02f;
 
-	std::vector<std::pair<Vector2D, GameObjPtr>>* GetCollisionVector(Vector2D& pos);
-	PlayerShip *m_playerObject;
+	ObjectHandle m_playerHandle = InvalidObjectHandle;
 	bool m_displayInfo;
+	bool m_displayProfile;
+	FrameProfiler m_profiler;
 	int m_currIteration = 0;
 	int m_aliensCount = 0;
+	int m_aliensKilledCount = 0;
 	bool m_gameOver;
 	bool m_isHardMode;
 	StringObject m_infoString;
+	// input created by play field, released with it even when it has been replaced
+	std::unique_ptr<Input> m_ownedInput;
 	Input * m_cotrollerInput = nullptr;
+	// the last key press which has moved the player: its arrival and iteration which consumed it
+	// (steady clock, ns), not part of the game state
+	INT64 m_inputArrivalTimeNs = 0;
+	INT64 m_inputConsumedTimeNs = 0;
+	// state branches are forked from (see Fork(...)), valid while world is in m_forkStateIteration
+	std::vector<unsigned char> m_forkState;
+	int m_forkStateIteration = -1;
+	// objects released by the last snapshot restore (per class), reused by the next one, so that
+	// branch forked again and again recreates its objects in place instead of allocating them
+	std::vector<GameObject*> m_recycledObjects[GC_End];
+	// set for branches: objects removed by the game are recycled too (instead of being deleted)
+	bool m_isRecyclingObjects = false;
+	// objects created by snapshot restore (kept as member to avoid reallocations)
+	std::vector<GameObject*> m_restoredObjects;
 	Vector2D m_bounds;
+	Vector2D m_fieldSize;
+	// size of part of play field visible on the screen, strings are positioned within it
+	Vector2D m_viewSize;
 	int GetCenteredStringXPosition(std::string& str);
 	void AddCenteredString(std::string str, StringObject &dest, int y);
 	void HandlePowerUpes();
-	bool CheckObjectsCollision(GameObject& o1, GameObject& o2);
 	void HandleSpawningNewObjects();
 	void FillObjectsPositionMaps();
-	void HandleCollisions(GameObject* obj);
+	void UpdateObjects();
+	void ApplyWorldCommands(WorldCommands& commands);
+	void HandleScheduledEvents();
+	void HandleCollisions();
 	void ApplyObjectsCollectionChanges();
 	void UpdateGameInfo();
-	const int MaxBlockWalls = 40;
-	const int MaxAliens = 200;
+	int MaxBlockWalls = 40;
+	int MaxAliens = 200;
+	// below that objects are not split between threads (synchronization would cost more than update itself)
+	const int MinObjectsPerUpdateTask = 256;
+	const int ProfileHudRefreshIterations = 16;
 public:
 	int MaxPlayerLasers = 4;
 	int MaxAlienLasers = 10;
 	int AlienLasers = 0;
 	int PlayerLasers = 0;
+	// objects closer to each other than that are treated as collided
+	static constexpr float CollisionRadius = 0.8f;
 
-	PlayField(Vector2D iBounds, GameConfig& config);
-	const std::vector<GameObjPtr>& GameObjects() { return m_gameObjects; }
+	// viewSize is by default the same as iBounds (whole play field is displayed)
+	PlayField(Vector2D iBounds, GameConfig& config, Vector2D viewSize = Vector2D(0, 0));
+	~PlayField();
+	EntityStore& GetEntityStore() { return m_entityStore; }
+	const WorldRandom& GetRandom() { return m_random; }
+	UINT32 GetIteration() { return (UINT32)m_currIteration; }
+	// obj will get OnScheduledEvent(...) call in given iteration (if it's still in play field by then)
+	void ScheduleEvent(UINT32 tick, GameObject& obj, ScheduledEventType type) { m_scheduler.Schedule(tick, obj.GetHandle(), type); }
+	// nullptr if there is no player or player has been destroyed
+	PlayerShip* GetPlayerObject() { return static_cast<PlayerShip*>(m_entityStore.GetObject(m_playerHandle)); }
 	const std::vector<StringObject*>& StringObjects() { return m_stringObjects; }
 	void AddScore(int value) { m_score += value; }
+	int GetScore() { return m_score; }
+	bool IsGameOver() { return m_gameOver; }
+	int GetAliensKilledCount() { return m_aliensKilledCount; }
 	const Vector2D& GetBounds() { return m_bounds; }
+	// size of play field given to constructor (GetBounds() excludes the last row)
+	const Vector2D& GetFieldSize() { return m_fieldSize; }
+	// phases of Update() are measured by it, Renderer adds its own phases
+	FrameProfiler& GetProfiler() { return m_profiler; }
+	FramePacer& GetFramePacer() { return m_framePacer; }
+	// called by player when it is moved by key press (time of the press is given by input),
+	// frames captured after that carry the stamp, so that renderer can measure input latency
+	void SetInputLatencyStamp(INT64 arrivalTimeNs);
+	INT64 GetInputArrivalTimeNs() { return m_inputArrivalTimeNs; }
+	INT64 GetInputConsumedTimeNs() { return m_inputConsumedTimeNs; }
+	// calls func(group, index) for each entity which is (or in previous iteration was) in given rectangle of cells
+	// (both corners inclusive), objects are reported once, in the entity store order (the same
+	// as order of full pass over entity groups). Objects are looked up in collision grid, so cost
+	// depends on rectangle size and number of objects in it, not on number of all objects.
+	template <typename Func>
+	void ForEachObjectInRect(int x0, int y0, int x1, int y1, Func func)
+	{
+		m_rectQueryIds.clear();
+		// grid is built before objects collection changes are applied, so removed objects are skipped
+		auto addEntity = [&](ObjectHandle handle)
+		{
+			int id = m_entityStore.GetEntityId(handle);
+			if (id >= 0)
+			{
+				m_rectQueryIds.push_back(id);
+			}
+		};
+		m_collisionGrid.ForEachHandleInRect(x0, y0, x1, y1, addEntity);
+		// and objects added after grid has been built are checked one by one
+		for (auto it : m_objectsAddedAfterCollisions)
+		{
+			GameObject* obj = m_entityStore.GetObject(it);
+			if (obj != nullptr && obj->GetPos().x >= x0 && obj->GetPos().y >= y0
+				&& obj->GetPos().x < x1 + 1 && obj->GetPos().y < y1 + 1)
+			{
+				addEntity(it);
+			}
+		}
+		std::sort(m_rectQueryIds.begin(), m_rectQueryIds.end());
+		m_rectQueryIds.erase(std::unique(m_rectQueryIds.begin(), m_rectQueryIds.end()), m_rectQueryIds.end());
+		for (int id : m_rectQueryIds)
+		{
+			EntityGroup& group = m_entityStore.GetGroup(EntityStore::GetEntityType(id));
+			func(group, EntityStore::GetEntityIndex(id));
+		}
+	}
     void SetupGame();
+    // state saved by SaveSnapshot(...) is restored in place of SetupGame() (test run iterations
+    // are counted from the iteration of the snapshot), false (with error printed) if file can't be
+    // read or it isn't a snapshot of play field of this size
+    bool LoadSnapshot(const char* path);
+    // false (with error printed) if file can't be written
+    bool SaveSnapshot(const char* path);
 	void Update();
-    void WaitBetweenIterations();
+    // waits till the deadline of next frame (iterationSleepTimeInMs is the period of iterations),
+    // returns number of iterations to run before the next frame is rendered
+    int WaitBetweenIterations();
     bool IsStillRunning();
+	// copies state of this world into branch (play field of the same size, which is meant to be
+	// created once and forked into many times): branch continues exactly like this world would
+	// given the same input (random streams are forked with the seed and iteration), its input
+	// isn't changed. State is captured once per iteration and it is shared by all branches forked
+	// in it, branch only copies it into arrays and objects it keeps between forks (objects of the
+	// same class are reconstructed in place, only objects above what branch had before are allocated).
+	bool Fork(PlayField& branch);
 	Input& GetControllerInput() { return *m_cotrollerInput; }
+	// replaces input (i.e. with replayed one), caller keeps ownership of the new input
+	void SetControllerInput(Input* input) { m_cotrollerInput = input; }
 	void NotifyGameOver();
 	void SpawnLaser(GameObject* newObj);
 	bool CanNewLasersBeSpawned(RaiderObjectTypeId laserType, int count);
 	bool AreStrongAlienLasersAllowed();
+	bool IsAliensFriendFireEnabled() { return m_isAliensFriendFireEnabled; }
 	void DespawnLaser(GameObject* newObj);
 	void SetTriplePlayerLaser();
 	void UnsetTriplePlayerLaser();
@@ -103,6 +289,8 @@ public:
 	void NotifyAlienDestroyed();
 	void SpawnWallBlocks(int count);
 	void SpawnAliens(int count, bool allowForExplodingAlien);
-	void AddPowerUp(Vector2D& pos);
+	void AddPowerUp(Vector2D& pos, RandomStream& random);
 	void ActivatePowerUp(PowerUp& powerUp);
+	static bool SweepObjects(const Vector2D& posPrev1, const Vector2D& pos1, const Vector2D& posPrev2, const Vector2D& pos2,
+		float& toiOut, Vector2D& contactOut);
 };
\ No newline at end of file
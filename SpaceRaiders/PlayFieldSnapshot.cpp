@@ -0,0 +1,636 @@
+#include "stdafx.h"
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <utility>
+#include "PlayFieldSnapshot.h"
+#include "PlayField.h"
+#include "ExplodingAlien.h"
+#include "MappedFile.h"
+
+static_assert(sizeof(Vector2D) == 2 * sizeof(float), "hot arrays of vectors are copied as floats");
+static_assert(sizeof(((SnapshotExplodingAlien*)nullptr)->positionMap) == sizeof(UINT64) * ExplodingAlien::PositionMapWordsCount,
+	"exploding alien position map has changed, snapshot format (and its version) has to follow");
+
+static inline size_t AlignSize(size_t size)
+{
+	return (size + 7) & ~(size_t)7;
+}
+
+template <typename T>
+static inline T* GetSection(unsigned char* data, const PlayFieldSnapshotHeader& header, PlayFieldSnapshotSection section)
+{
+	return (T*)(data + header.sections[section].offset);
+}
+
+template <typename T>
+static inline const T* GetSection(const unsigned char* data, const PlayFieldSnapshotHeader& header, PlayFieldSnapshotSection section)
+{
+	return (const T*)(data + header.sections[section].offset);
+}
+
+static inline void SaveVector(float* dest, const Vector2D& v)
+{
+	dest[0] = v.x;
+	dest[1] = v.y;
+}
+
+void PlayFieldSnapshot::Save(PlayField& world, std::vector<unsigned char>& out)
+{
+	EntityStore& store = world.m_entityStore;
+	int entitiesCount = 0;
+	int explodingAliensCount = 0;
+	for (int type = 0; type < RI_End; type++)
+	{
+		EntityGroup& group = store.m_groups[type];
+		entitiesCount += group.Size();
+		for (auto obj : group.objects)
+		{
+			explodingAliensCount += obj->GetClass() == GC_ExplodingAlien ? 1 : 0;
+		}
+	}
+	int pendingCount = (int)world.m_gameObjectsToAdd.size();
+	int caughtCount = (int)world.m_catchedPowerUpes.size();
+	int eventsCount = 0;
+	world.m_scheduler.ForEachEvent([&](const ScheduledEvent&) { eventsCount++; });
+
+	// layout of sections
+	PlayFieldSnapshotHeader header;
+	std::memset(&header, 0, sizeof(header));
+	const UINT32 counts[PS_End] = { (UINT32)(entitiesCount + pendingCount + caughtCount), (UINT32)explodingAliensCount,
+		(UINT32)(pendingCount + caughtCount),
+		(UINT32)entitiesCount, (UINT32)entitiesCount, (UINT32)entitiesCount, (UINT32)entitiesCount, (UINT32)entitiesCount,
+		(UINT32)entitiesCount, (UINT32)entitiesCount, (UINT32)entitiesCount, (UINT32)entitiesCount,
+		(UINT32)store.m_slots.m_slots.size(), (UINT32)store.m_slots.GetFreeSlotsCount(), (UINT32)eventsCount,
+		(UINT32)world.m_aliensPosProvider.GetDataWordsCount(), (UINT32)world.m_wallBlocksPosProvider.GetDataWordsCount() };
+	const UINT32 elementSizes[PS_End] = { sizeof(SnapshotObject), sizeof(SnapshotExplodingAlien), sizeof(SnapshotEntityData),
+		sizeof(ObjectHandle), sizeof(Vector2D), sizeof(Vector2D), sizeof(Vector2D), sizeof(int), sizeof(int),
+		sizeof(unsigned char), sizeof(unsigned char), sizeof(UINT32),
+		sizeof(SnapshotSlot), sizeof(UINT32), sizeof(ScheduledEvent), sizeof(UINT64), sizeof(UINT64) };
+	size_t size = AlignSize(sizeof(header));
+	for (int section = 0; section < PS_End; section++)
+	{
+		header.sections[section] = { size, counts[section], elementSizes[section] };
+		size += AlignSize((size_t)counts[section] * elementSizes[section]);
+	}
+	out.assign(size, 0);
+	unsigned char* data = out.data();
+
+	// play field
+	std::memcpy(header.magic, PlayFieldSnapshotMagic, sizeof(header.magic));
+	header.version = PlayFieldSnapshotVersion;
+	header.size = size;
+	header.seed = world.m_random.GetSeed();
+	header.fieldSizeX = (int)world.m_fieldSize.x;
+	header.fieldSizeY = (int)world.m_fieldSize.y;
+	header.iteration = world.m_currIteration;
+	header.score = world.m_score;
+	header.nextObjectsWaveTime = world.m_nextObjectsWaveTime;
+	header.currMinAliensSpawnedPerWave = world.m_currMinAliensSpawnedPerWave;
+	header.currMaxAliensSpawnedPerWave = world.m_currMaxAliensSpawnedPerWave;
+	header.aliensVelocityY = world.m_aliensVelocityY;
+	header.aliensCount = world.m_aliensCount;
+	header.aliensKilledCount = world.m_aliensKilledCount;
+	header.wallBlocksCount = world.m_wallBlocksCount;
+	header.startingAliensCount = world.m_startingAliensCount;
+	header.maxAliens = world.MaxAliens;
+	header.maxBlockWalls = world.MaxBlockWalls;
+	header.maxPlayerLasers = world.MaxPlayerLasers;
+	header.maxAlienLasers = world.MaxAlienLasers;
+	header.alienLasers = world.AlienLasers;
+	header.playerLasers = world.PlayerLasers;
+	header.playerHandle = world.m_playerHandle;
+	header.pendingCount = pendingCount;
+	header.slotsSize = store.m_slots.m_size;
+	header.schedulerSize = world.m_scheduler.GetSize();
+	header.aliensFreePositions = world.m_aliensPosProvider.GetFreeCount();
+	header.wallBlocksFreePositions = world.m_wallBlocksPosProvider.GetFreeCount();
+	header.isGameOver = world.m_gameOver ? 1 : 0;
+	header.isHardMode = world.m_isHardMode ? 1 : 0;
+	header.isSpecialFeatureEnabled = world.m_isSpecialFeatureEnabled ? 1 : 0;
+	header.isAliensFriendFireEnabled = world.m_isAliensFriendFireEnabled ? 1 : 0;
+
+	// objects, their hot fields and slots
+	SnapshotObject* objects = GetSection<SnapshotObject>(data, header, PS_Objects);
+	SnapshotExplodingAlien* explodingAliens = GetSection<SnapshotExplodingAlien>(data, header, PS_ExplodingAliens);
+	SnapshotSlot* slots = GetSection<SnapshotSlot>(data, header, PS_Slots);
+	for (UINT32 i = 0; i < counts[PS_Slots]; i++)
+	{
+		// entity ids are saved only for slots in use (free slots keep stale ones)
+		slots[i] = { store.m_slots.m_slots[i].generation, -1 };
+	}
+	auto saveObject = [&](GameObject* obj, SnapshotObject& record)
+	{
+		record.objectClass = obj->GetClass();
+		record.objType = obj->m_objType;
+		record.strikeForce = obj->m_strikeForce;
+		record.isAutoDelete = obj->m_isAutoDelete ? 1 : 0;
+		switch (record.objectClass)
+		{
+		case GC_PlayerShip:
+		{
+			PlayerShip* player = static_cast<PlayerShip*>(obj);
+			record.player.movementSpeed = player->m_movementSpeed;
+			record.player.fireRateBorder = player->m_fireRateBorder;
+			record.player.useTripleShots = player->m_useTripleShots ? 1 : 0;
+			break;
+		}
+		case GC_Alien:
+		case GC_ExplodingAlien:
+		{
+			Alien* alien = static_cast<Alien*>(obj);
+			record.alien.isTransformationEnabled = alien->m_isTransformationEnabled ? 1 : 0;
+			record.alien.isNextLaserStrong = alien->m_isNextLaserStrong ? 1 : 0;
+			record.alien.state = (UINT8)alien->m_state;
+			record.alien.transformEnergy = alien->m_transformEnergy;
+			record.alien.fireRateBorder = alien->m_fireRateBorder;
+			record.alien.nextFireTick = alien->m_nextFireTick;
+			record.alien.nextTransformTick = alien->m_nextTransformTick;
+			break;
+		}
+		case GC_MovementSpeedPowerUp:
+		case GC_FasterShotsPowerUp:
+		case GC_TripleShotsPowerUp:
+		{
+			PowerUp* powerUp = static_cast<PowerUp*>(obj);
+			record.powerUp.timeLeft = powerUp->m_timeLeft;
+			record.powerUp.powerUpType = (UINT32)powerUp->m_powerUpType;
+			record.powerUp.isCatched = powerUp->m_isCatched ? 1 : 0;
+			break;
+		}
+		}
+	};
+	size_t first = 0;
+	int explodingAlien = 0;
+	for (int type = 0; type < RI_End; type++)
+	{
+		EntityGroup& group = store.m_groups[type];
+		int count = group.Size();
+		header.groupSizes[type] = count;
+		for (int i = 0; i < count; i++)
+		{
+			GameObject* obj = group.objects[i];
+			saveObject(obj, objects[first + i]);
+			slots[group.handle[i] & SlotMap<int>::IndexMask].entityId = EntityStore::MakeEntityId((RaiderObjectTypeId)type, i);
+			if (obj->GetClass() == GC_ExplodingAlien)
+			{
+				ExplodingAlien* alien = static_cast<ExplodingAlien*>(obj);
+				SnapshotExplodingAlien& record = explodingAliens[explodingAlien++];
+				record.objectIndex = (UINT32)(first + i);
+				record.isDead = alien->m_isDead ? 1 : 0;
+				record.currExplosionRing = alien->m_currExplosionRing;
+				record.explosionStartX = alien->m_explosionStartPoint.x;
+				record.explosionStartY = alien->m_explosionStartPoint.y;
+				std::memcpy(record.positionMap, alien->m_positionMap.GetData(), sizeof(record.positionMap));
+			}
+		}
+		if (count > 0)
+		{
+			std::memcpy(GetSection<ObjectHandle>(data, header, PS_Handle) + first, group.handle.data(), count * sizeof(ObjectHandle));
+			std::memcpy(GetSection<float>(data, header, PS_Pos) + 2 * first, group.pos.data(), count * sizeof(Vector2D));
+			std::memcpy(GetSection<float>(data, header, PS_PosPrev) + 2 * first, group.posPrev.data(), count * sizeof(Vector2D));
+			std::memcpy(GetSection<float>(data, header, PS_Velocity) + 2 * first, group.velocity.data(), count * sizeof(Vector2D));
+			std::memcpy(GetSection<int>(data, header, PS_Health) + first, group.health.data(), count * sizeof(int));
+			std::memcpy(GetSection<int>(data, header, PS_TicksLeft) + first, group.ticksLeft.data(), count * sizeof(int));
+			std::memcpy(GetSection<unsigned char>(data, header, PS_Sprite) + first, group.sprite.data(), count);
+			std::memcpy(GetSection<unsigned char>(data, header, PS_IsActive) + first, group.isActive.data(), count);
+			std::memcpy(GetSection<UINT32>(data, header, PS_CollisionMask) + first, group.collisionMask.data(), count * sizeof(UINT32));
+		}
+		first += count;
+	}
+	// hot fields of objects which aren't in entity store are in objects themselves
+	// (pending objects have their handles, caught power-ups are owned by play field only)
+	SnapshotEntityData* detached = GetSection<SnapshotEntityData>(data, header, PS_DetachedData);
+	auto saveDetached = [&](GameObject* obj)
+	{
+		saveObject(obj, objects[first++]);
+		const EntityData& entity = obj->m_data;
+		detached->handle = obj->m_handle;
+		SaveVector(detached->pos, entity.pos);
+		SaveVector(detached->posPrev, entity.posPrev);
+		SaveVector(detached->velocity, entity.velocity);
+		detached->health = entity.health;
+		detached->ticksLeft = entity.ticksLeft;
+		detached->sprite = entity.sprite;
+		detached->isActive = entity.isActive ? 1 : 0;
+		detached++;
+	};
+	for (auto obj : world.m_gameObjectsToAdd)
+	{
+		saveDetached(obj);
+	}
+	for (auto it : world.m_catchedPowerUpes)
+	{
+		saveDetached(it.second);
+	}
+	if (counts[PS_FreeSlots] > 0)
+	{
+		std::memcpy(GetSection<UINT32>(data, header, PS_FreeSlots), store.m_slots.m_freeSlots.data() + store.m_slots.m_freeHead, counts[PS_FreeSlots] * sizeof(UINT32));
+	}
+	ScheduledEvent* events = GetSection<ScheduledEvent>(data, header, PS_Events);
+	world.m_scheduler.ForEachEvent([&](const ScheduledEvent& event) { *events++ = event; });
+	std::memcpy(GetSection<UINT64>(data, header, PS_AliensPositions), world.m_aliensPosProvider.GetData(),
+		counts[PS_AliensPositions] * sizeof(UINT64));
+	std::memcpy(GetSection<UINT64>(data, header, PS_WallBlocksPositions), world.m_wallBlocksPosProvider.GetData(),
+		counts[PS_WallBlocksPositions] * sizeof(UINT64));
+	std::memcpy(data, &header, sizeof(header));
+}
+
+// object of class T constructed in memory of recycled object of the same class if there is one,
+// new one otherwise (memory is released the same way in both cases, by T's operator delete)
+template <typename T, typename... Args>
+static T* RecreateObject(std::vector<GameObject*>& recycled, Args&&... args)
+{
+	if (recycled.empty())
+	{
+		return new T(std::forward<Args>(args)...);
+	}
+	T* obj = static_cast<T*>(recycled.back());
+	recycled.pop_back();
+	obj->~T();
+	return ::new ((void*)obj) T(std::forward<Args>(args)...);
+}
+
+GameObject* PlayFieldSnapshot::CreateObject(const SnapshotObject& record, GameObject& laserParent, PlayField& world)
+{
+	// objects are created with default parameters, fields that could have changed are set from the record
+	Vector2D pos(0, 0);
+	GameObject* obj = nullptr;
+	std::vector<GameObject*>& recycled = world.m_recycledObjects[record.objectClass];
+	switch (record.objectClass)
+	{
+	case GC_PlayerShip:
+	{
+		PlayerShip* player = RecreateObject<PlayerShip>(recycled, pos);
+		player->m_movementSpeed = record.player.movementSpeed;
+		player->m_fireRateBorder = record.player.fireRateBorder;
+		player->m_useTripleShots = record.player.useTripleShots != 0;
+		obj = player;
+		break;
+	}
+	case GC_Alien:
+	case GC_ExplodingAlien:
+	{
+		Alien* alien = record.objectClass == GC_Alien ? RecreateObject<Alien>(recycled, pos, 0.f)
+			: (Alien*)RecreateObject<ExplodingAlien>(recycled, pos, 0.f);
+		alien->m_isTransformationEnabled = record.alien.isTransformationEnabled != 0;
+		alien->m_isNextLaserStrong = record.alien.isNextLaserStrong != 0;
+		alien->m_state = (Alien::AlienState)record.alien.state;
+		alien->m_transformEnergy = record.alien.transformEnergy;
+		alien->m_fireRateBorder = record.alien.fireRateBorder;
+		alien->m_nextFireTick = record.alien.nextFireTick;
+		alien->m_nextTransformTick = record.alien.nextTransformTick;
+		obj = alien;
+		break;
+	}
+	case GC_AlienLaser: obj = RecreateObject<AlienLaser>(recycled, &laserParent); break;
+	case GC_StrongAlienLaser: obj = RecreateObject<StrongAlienLaser>(recycled, &laserParent); break;
+	case GC_PlayerLaser: obj = RecreateObject<PlayerLaser>(recycled, &laserParent); break;
+	case GC_PlayerLaserLR: obj = RecreateObject<PlayerLaserLR>(recycled, &laserParent, true); break;
+	case GC_Explosion: obj = RecreateObject<Explosion>(recycled, pos); break;
+	case GC_WallBlock: obj = RecreateObject<WallBlock>(recycled, pos); break;
+	case GC_EAExplosionCell: obj = RecreateObject<EAExplosionCell>(recycled, pos); break;
+	case GC_MovementSpeedPowerUp:
+	case GC_FasterShotsPowerUp:
+	case GC_TripleShotsPowerUp:
+	{
+		PowerUp* powerUp;
+		if (record.objectClass == GC_MovementSpeedPowerUp)
+			powerUp = RecreateObject<MovementSpeedPowerUp>(recycled, pos);
+		else if (record.objectClass == GC_FasterShotsPowerUp)
+			powerUp = RecreateObject<FasterShotsPowerUp>(recycled, pos);
+		else
+			powerUp = RecreateObject<TripleShotsPowerUp>(recycled, pos);
+		powerUp->m_timeLeft = record.powerUp.timeLeft;
+		powerUp->m_powerUpType = (PowerUpType)record.powerUp.powerUpType;
+		powerUp->m_isCatched = record.powerUp.isCatched != 0;
+		obj = powerUp;
+		break;
+	}
+	default:
+		return nullptr;
+	}
+	obj->m_objType = (RaiderObjectTypeId)record.objType;
+	obj->m_strikeForce = record.strikeForce;
+	obj->m_isAutoDelete = record.isAutoDelete != 0;
+	return obj;
+}
+
+void PlayFieldSnapshot::ClearWorld(PlayField& world)
+{
+	EntityStore& store = world.m_entityStore;
+	for (auto& group : store.m_groups)
+	{
+		for (auto obj : group.objects)
+		{
+			// caught power-ups aren't auto deleted, they are recycled below
+			if (obj->IsAutoDelete())
+			{
+				world.m_recycledObjects[obj->GetClass()].push_back(obj);
+			}
+		}
+		// arrays keep their memory, so that world restored again and again (i.e. branch of
+		// PlayField::Fork(...)) doesn't allocate them each time
+		group.objects.clear();
+		group.handle.clear();
+		group.pos.clear();
+		group.posPrev.clear();
+		group.velocity.clear();
+		group.health.clear();
+		group.ticksLeft.clear();
+		group.sprite.clear();
+		group.isActive.clear();
+		group.collisionMask.clear();
+	}
+	store.m_slots.m_slots.clear();
+	store.m_slots.m_freeSlots.clear();
+	store.m_slots.m_freeHead = 0;
+	store.m_slots.m_size = 0;
+	for (auto it : world.m_catchedPowerUpes)
+	{
+		world.m_recycledObjects[it.second->GetClass()].push_back(it.second);
+	}
+	world.m_catchedPowerUpes.clear();
+	for (auto obj : world.m_gameObjectsToAdd)
+	{
+		world.m_recycledObjects[obj->GetClass()].push_back(obj);
+	}
+	world.m_gameObjectsToAdd.clear();
+	world.m_objectsToRemove.clear();
+	world.m_scheduler.Clear();
+	world.m_stringObjects.clear();
+}
+
+bool PlayFieldSnapshot::Restore(PlayField& world, const unsigned char* data, size_t size)
+{
+	// everything is validated before the world is changed
+	PlayFieldSnapshotHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, PlayFieldSnapshotMagic, sizeof(header.magic)) != 0 || header.version != PlayFieldSnapshotVersion
+		|| header.size > size || header.fieldSizeX != (int)world.m_fieldSize.x || header.fieldSizeY != (int)world.m_fieldSize.y)
+	{
+		return false;
+	}
+	const UINT32 elementSizes[PS_End] = { sizeof(SnapshotObject), sizeof(SnapshotExplodingAlien), sizeof(SnapshotEntityData),
+		sizeof(ObjectHandle), sizeof(Vector2D), sizeof(Vector2D), sizeof(Vector2D), sizeof(int), sizeof(int),
+		sizeof(unsigned char), sizeof(unsigned char), sizeof(UINT32),
+		sizeof(SnapshotSlot), sizeof(UINT32), sizeof(ScheduledEvent), sizeof(UINT64), sizeof(UINT64) };
+	for (int section = 0; section < PS_End; section++)
+	{
+		const SnapshotSectionEntry& entry = header.sections[section];
+		if (entry.elementSize != elementSizes[section] || entry.offset % 8 != 0
+			|| entry.offset + (UINT64)entry.count * entry.elementSize > header.size)
+		{
+			return false;
+		}
+	}
+	UINT32 entitiesCount = 0;
+	for (int type = 0; type < RI_End; type++)
+	{
+		if (header.groupSizes[type] < 0 || header.groupSizes[type] >= (1 << EntityStore::EntityIndexBits))
+		{
+			return false;
+		}
+		entitiesCount += (UINT32)header.groupSizes[type];
+	}
+	const SnapshotSectionEntry* sections = header.sections;
+	UINT32 slotsCount = sections[PS_Slots].count;
+	UINT32 pendingCount = (UINT32)header.pendingCount;
+	if (sections[PS_Objects].count != entitiesCount + sections[PS_DetachedData].count || pendingCount > sections[PS_DetachedData].count
+		|| sections[PS_Handle].count != entitiesCount
+		|| sections[PS_Pos].count != entitiesCount || sections[PS_PosPrev].count != entitiesCount
+		|| sections[PS_Velocity].count != entitiesCount || sections[PS_Health].count != entitiesCount
+		|| sections[PS_TicksLeft].count != entitiesCount || sections[PS_Sprite].count != entitiesCount
+		|| sections[PS_IsActive].count != entitiesCount || sections[PS_CollisionMask].count != entitiesCount
+		|| slotsCount > SlotMap<int>::IndexMask + 1 || sections[PS_FreeSlots].count > slotsCount
+		|| sections[PS_AliensPositions].count != (UINT32)world.m_aliensPosProvider.GetDataWordsCount()
+		|| sections[PS_WallBlocksPositions].count != (UINT32)world.m_wallBlocksPosProvider.GetDataWordsCount())
+	{
+		return false;
+	}
+	const SnapshotObject* objects = GetSection<SnapshotObject>(data, header, PS_Objects);
+	const ObjectHandle* handles = GetSection<ObjectHandle>(data, header, PS_Handle);
+	UINT32 index = 0;
+	for (int type = 0; type < RI_End; type++)
+	{
+		for (int i = 0; i < header.groupSizes[type]; i++, index++)
+		{
+			if (objects[index].objType != (UINT32)type || (handles[index] & SlotMap<int>::IndexMask) >= slotsCount)
+			{
+				return false;
+			}
+		}
+	}
+	for (UINT32 i = 0; i < sections[PS_Objects].count; i++)
+	{
+		if (objects[i].objectClass == GC_Unknown || objects[i].objectClass >= GC_End || objects[i].objType >= RI_End
+			|| (i >= entitiesCount + pendingCount && objects[i].objectClass != GC_MovementSpeedPowerUp
+				&& objects[i].objectClass != GC_FasterShotsPowerUp && objects[i].objectClass != GC_TripleShotsPowerUp))
+		{
+			return false;
+		}
+	}
+	const SnapshotExplodingAlien* explodingAliens = GetSection<SnapshotExplodingAlien>(data, header, PS_ExplodingAliens);
+	for (UINT32 i = 0; i < sections[PS_ExplodingAliens].count; i++)
+	{
+		if (explodingAliens[i].objectIndex >= entitiesCount || objects[explodingAliens[i].objectIndex].objectClass != GC_ExplodingAlien)
+		{
+			return false;
+		}
+	}
+	const SnapshotEntityData* detached = GetSection<SnapshotEntityData>(data, header, PS_DetachedData);
+	for (UINT32 i = 0; i < pendingCount; i++)
+	{
+		if ((detached[i].handle & SlotMap<int>::IndexMask) >= slotsCount)
+		{
+			return false;
+		}
+	}
+	const UINT32* freeSlots = GetSection<UINT32>(data, header, PS_FreeSlots);
+	for (UINT32 i = 0; i < sections[PS_FreeSlots].count; i++)
+	{
+		if (freeSlots[i] >= slotsCount)
+		{
+			return false;
+		}
+	}
+
+	ClearWorld(world);
+	world.m_forkStateIteration = -1;
+	EntityStore& store = world.m_entityStore;
+	// any object can be a parent of created laser (laser position is overwritten anyway)
+	WallBlock laserParent(Vector2D(0, 0));
+	std::vector<GameObject*>& created = world.m_restoredObjects;
+	created.resize(sections[PS_Objects].count);
+	int createdCount[GC_End] = {};
+	for (UINT32 i = 0; i < sections[PS_Objects].count; i++)
+	{
+		created[i] = CreateObject(objects[i], laserParent, world);
+		createdCount[objects[i].objectClass]++;
+	}
+	// the rest is kept for the next restore, but not more than this one has needed
+	// (objects spawned by the game in a branch would pile up otherwise)
+	for (int objectClass = 0; objectClass < GC_End; objectClass++)
+	{
+		std::vector<GameObject*>& recycled = world.m_recycledObjects[objectClass];
+		while ((int)recycled.size() > createdCount[objectClass])
+		{
+			delete recycled.back();
+			recycled.pop_back();
+		}
+	}
+	for (UINT32 i = 0; i < sections[PS_ExplodingAliens].count; i++)
+	{
+		const SnapshotExplodingAlien& record = explodingAliens[i];
+		ExplodingAlien* alien = static_cast<ExplodingAlien*>(created[record.objectIndex]);
+		alien->m_isDead = record.isDead != 0;
+		alien->m_currExplosionRing = record.currExplosionRing;
+		alien->m_explosionStartPoint = Vector2D(record.explosionStartX, record.explosionStartY);
+		std::memcpy(alien->m_positionMap.GetData(), record.positionMap, sizeof(record.positionMap));
+	}
+
+	// handle slots (objects are set below, once it's known which slots are in use)
+	const SnapshotSlot* slots = GetSection<SnapshotSlot>(data, header, PS_Slots);
+	store.m_slots.m_slots.resize(slotsCount);
+	for (UINT32 i = 0; i < slotsCount; i++)
+	{
+		store.m_slots.m_slots[i].generation = slots[i].generation;
+		store.m_slots.m_slots[i].value = { nullptr, -1 };
+	}
+	store.m_slots.m_freeSlots.assign(freeSlots, freeSlots + sections[PS_FreeSlots].count);
+	store.m_slots.m_freeHead = 0;
+	store.m_slots.m_size = header.slotsSize;
+
+	// entity groups are copied array by array
+	size_t first = 0;
+	for (int type = 0; type < RI_End; type++)
+	{
+		EntityGroup& group = store.m_groups[type];
+		size_t count = (size_t)header.groupSizes[type];
+		group.objects.assign(created.begin() + first, created.begin() + first + count);
+		group.handle.assign(handles + first, handles + first + count);
+		group.pos.assign(GetSection<Vector2D>(data, header, PS_Pos) + first, GetSection<Vector2D>(data, header, PS_Pos) + first + count);
+		group.posPrev.assign(GetSection<Vector2D>(data, header, PS_PosPrev) + first, GetSection<Vector2D>(data, header, PS_PosPrev) + first + count);
+		group.velocity.assign(GetSection<Vector2D>(data, header, PS_Velocity) + first, GetSection<Vector2D>(data, header, PS_Velocity) + first + count);
+		group.health.assign(GetSection<int>(data, header, PS_Health) + first, GetSection<int>(data, header, PS_Health) + first + count);
+		group.ticksLeft.assign(GetSection<int>(data, header, PS_TicksLeft) + first, GetSection<int>(data, header, PS_TicksLeft) + first + count);
+		group.sprite.assign(GetSection<unsigned char>(data, header, PS_Sprite) + first, GetSection<unsigned char>(data, header, PS_Sprite) + first + count);
+		group.isActive.assign(GetSection<unsigned char>(data, header, PS_IsActive) + first, GetSection<unsigned char>(data, header, PS_IsActive) + first + count);
+		group.collisionMask.assign(GetSection<UINT32>(data, header, PS_CollisionMask) + first, GetSection<UINT32>(data, header, PS_CollisionMask) + first + count);
+		for (size_t i = 0; i < count; i++)
+		{
+			GameObject* obj = group.objects[i];
+			obj->m_group = &group;
+			obj->m_entityIndex = (int)i;
+			obj->m_handle = group.handle[i];
+			store.m_slots.m_slots[obj->m_handle & SlotMap<int>::IndexMask].value = { obj, EntityStore::MakeEntityId((RaiderObjectTypeId)type, (int)i) };
+		}
+		first += count;
+	}
+	for (UINT32 i = 0; i < sections[PS_DetachedData].count; i++, detached++)
+	{
+		GameObject* obj = created[first + i];
+		EntityData& entity = obj->m_data;
+		entity.pos = Vector2D(detached->pos[0], detached->pos[1]);
+		entity.posPrev = Vector2D(detached->posPrev[0], detached->posPrev[1]);
+		entity.velocity = Vector2D(detached->velocity[0], detached->velocity[1]);
+		entity.health = detached->health;
+		entity.ticksLeft = detached->ticksLeft;
+		entity.sprite = detached->sprite;
+		entity.isActive = detached->isActive != 0;
+		if (i < pendingCount)
+		{
+			// objects added in the iteration of the snapshot are added to entity store by the next one
+			obj->m_handle = detached->handle;
+			store.m_slots.m_slots[obj->m_handle & SlotMap<int>::IndexMask].value = { obj, -1 };
+			world.m_gameObjectsToAdd.push_back(obj);
+		}
+		else
+		{
+			PowerUp* powerUp = static_cast<PowerUp*>(obj);
+			world.m_catchedPowerUpes[powerUp->GetType()] = powerUp;
+		}
+	}
+	const ScheduledEvent* events = GetSection<ScheduledEvent>(data, header, PS_Events);
+	for (UINT32 i = 0; i < sections[PS_Events].count; i++)
+	{
+		world.m_scheduler.Schedule(events[i].tick, events[i].handle, events[i].type);
+	}
+	std::memcpy(world.m_aliensPosProvider.GetData(), GetSection<UINT64>(data, header, PS_AliensPositions),
+		sections[PS_AliensPositions].count * sizeof(UINT64));
+	std::memcpy(world.m_wallBlocksPosProvider.GetData(), GetSection<UINT64>(data, header, PS_WallBlocksPositions),
+		sections[PS_WallBlocksPositions].count * sizeof(UINT64));
+	world.m_aliensPosProvider.SetFreeCount(header.aliensFreePositions);
+	world.m_wallBlocksPosProvider.SetFreeCount(header.wallBlocksFreePositions);
+
+	// play field
+	world.m_random = WorldRandom(header.seed);
+	world.m_currIteration = header.iteration;
+	world.m_score = header.score;
+	world.m_nextObjectsWaveTime = header.nextObjectsWaveTime;
+	world.m_currMinAliensSpawnedPerWave = header.currMinAliensSpawnedPerWave;
+	world.m_currMaxAliensSpawnedPerWave = header.currMaxAliensSpawnedPerWave;
+	world.m_aliensVelocityY = header.aliensVelocityY;
+	world.m_aliensCount = header.aliensCount;
+	world.m_aliensKilledCount = header.aliensKilledCount;
+	world.m_wallBlocksCount = header.wallBlocksCount;
+	world.m_startingAliensCount = header.startingAliensCount;
+	world.MaxAliens = header.maxAliens;
+	world.MaxBlockWalls = header.maxBlockWalls;
+	world.MaxPlayerLasers = header.maxPlayerLasers;
+	world.MaxAlienLasers = header.maxAlienLasers;
+	world.AlienLasers = header.alienLasers;
+	world.PlayerLasers = header.playerLasers;
+	world.m_playerHandle = header.playerHandle;
+	world.m_isHardMode = header.isHardMode != 0;
+	world.m_isSpecialFeatureEnabled = header.isSpecialFeatureEnabled != 0;
+	world.m_isAliensFriendFireEnabled = header.isAliensFriendFireEnabled != 0;
+	world.m_gameOver = false;
+	// strings are shown again (info string is refreshed by the next iteration)
+	if (world.m_displayInfo)
+	{
+		world.m_stringObjects.push_back(&world.m_infoString);
+	}
+	if (header.isGameOver != 0)
+	{
+		world.NotifyGameOver();
+	}
+	// collision grid of the last iteration is gone, rectangle queries find all objects through
+	// the list of objects added after collisions, until the next iteration builds the grid again
+	world.m_collisionGrid.Clear();
+	world.m_collisionGrid.Build();
+	world.m_objectsAddedAfterCollisions.clear();
+	for (auto& group : store.m_groups)
+	{
+		world.m_objectsAddedAfterCollisions.insert(world.m_objectsAddedAfterCollisions.end(), group.handle.begin(), group.handle.end());
+	}
+	return true;
+}
+
+bool PlayFieldSnapshot::WriteFile(const char* path, const std::vector<unsigned char>& snapshot)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write((const char*)snapshot.data(), snapshot.size());
+	file.close();
+	return !file.fail();
+}
+
+bool PlayFieldSnapshot::RestoreFile(PlayField& world, const char* path)
+{
+	MappedFile file;
+	return file.Open(path) && Restore(world, file.GetData(), file.GetSize());
+}
+
+UINT64 PlayFieldSnapshot::Hash(const unsigned char* data, size_t size)
+{
+	UINT64 hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = (hash ^ data[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
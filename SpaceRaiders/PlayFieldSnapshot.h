@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include "IntTypes.h"
+#include "EntityStore.h"
+#include "TickScheduler.h"
+
+class PlayField;
+
+static const char PlayFieldSnapshotMagic[4] = { 'S', 'R', 'P', 'S' };
+static const UINT32 PlayFieldSnapshotVersion = 3;
+
+// Snapshot is a single flat buffer: header (with play field counters and table of sections)
+// followed by sections, each of them being an 8 byte aligned array of fixed size records.
+// Hot fields of entities are stored the same way they are kept in EntityStore (one array per
+// field, all groups one after another), so they are saved and restored with memcpy, only
+// objects (their class and fields of that class) are recreated one by one.
+// Whole buffer is zeroed before it is filled, so equal worlds give equal snapshots (see Hash(...)).
+typedef enum
+{
+	PS_Objects = 0,			// SnapshotObject for each entity (groups in order), then pending objects and caught power-ups
+	PS_ExplodingAliens,		// SnapshotExplodingAlien
+	PS_DetachedData,		// SnapshotEntityData of objects which aren't part of entity store: objects added
+							// in current iteration (snapshot taken before the first one has objects of SetupGame())
+							// and caught power-ups
+	PS_Handle,				// hot fields of entities, see EntityGroup
+	PS_Pos,
+	PS_PosPrev,
+	PS_Velocity,
+	PS_Health,
+	PS_TicksLeft,
+	PS_Sprite,
+	PS_IsActive,
+	PS_CollisionMask,
+	PS_Slots,				// SnapshotSlot for each handle slot
+	PS_FreeSlots,			// UINT32 slot index, in order of reuse (the first one is reused first)
+	PS_Events,				// ScheduledEvent, in order of TickScheduler buckets
+	PS_AliensPositions,		// UINT64 words of aliens RandomPositionProvider bitmap
+	PS_WallBlocksPositions,	// UINT64 words of wall blocks RandomPositionProvider bitmap
+	PS_End
+} PlayFieldSnapshotSection;
+
+typedef struct
+{
+	UINT64 offset;
+	UINT32 count;
+	UINT32 elementSize;
+} SnapshotSectionEntry;
+
+typedef struct
+{
+	char magic[4];
+	UINT32 version;
+	// size of whole snapshot
+	UINT64 size;
+	UINT64 seed;
+	int fieldSizeX;
+	int fieldSizeY;
+	int iteration;
+	int score;
+	int nextObjectsWaveTime;
+	float currMinAliensSpawnedPerWave;
+	float currMaxAliensSpawnedPerWave;
+	float aliensVelocityY;
+	int aliensCount;
+	int aliensKilledCount;
+	int wallBlocksCount;
+	int startingAliensCount;
+	int maxAliens;
+	int maxBlockWalls;
+	int maxPlayerLasers;
+	int maxAlienLasers;
+	int alienLasers;
+	int playerLasers;
+	UINT32 playerHandle;
+	// objects added to play field but not to entity store yet
+	int pendingCount;
+	int slotsSize;
+	int schedulerSize;
+	int aliensFreePositions;
+	int wallBlocksFreePositions;
+	UINT8 isGameOver;
+	UINT8 isHardMode;
+	UINT8 isSpecialFeatureEnabled;
+	UINT8 isAliensFriendFireEnabled;
+	int groupSizes[RI_End];
+	SnapshotSectionEntry sections[PS_End];
+} PlayFieldSnapshotHeader;
+
+typedef struct
+{
+	UINT8 isTransformationEnabled;
+	UINT8 isNextLaserStrong;
+	UINT8 state;
+	UINT8 reserved;
+	float transformEnergy;
+	float fireRateBorder;
+	UINT32 nextFireTick;
+	UINT32 nextTransformTick;
+} SnapshotAlienFields;
+
+typedef struct
+{
+	float movementSpeed;
+	float fireRateBorder;
+	UINT8 useTripleShots;
+} SnapshotPlayerFields;
+
+typedef struct
+{
+	int timeLeft;
+	UINT32 powerUpType;
+	UINT8 isCatched;
+} SnapshotPowerUpFields;
+
+typedef struct
+{
+	// GameObjectClass
+	UINT32 objectClass;
+	// current type (exploding alien turns into RI_ExplosionCell)
+	UINT32 objType;
+	int strikeForce;
+	UINT8 isAutoDelete;
+	UINT8 reserved[3];
+	union
+	{
+		SnapshotAlienFields alien;
+		SnapshotPlayerFields player;
+		SnapshotPowerUpFields powerUp;
+	};
+} SnapshotObject;
+
+typedef struct
+{
+	// index in PS_Objects
+	UINT32 objectIndex;
+	UINT8 isDead;
+	UINT8 reserved[3];
+	int currExplosionRing;
+	float explosionStartX;
+	float explosionStartY;
+	UINT64 positionMap[30];
+} SnapshotExplodingAlien;
+
+typedef struct
+{
+	// InvalidObjectHandle for caught power-ups
+	UINT32 handle;
+	float pos[2];
+	float posPrev[2];
+	float velocity[2];
+	int health;
+	int ticksLeft;
+	UINT8 sprite;
+	UINT8 isActive;
+	UINT8 reserved[2];
+} SnapshotEntityData;
+
+typedef struct
+{
+	UINT32 generation;
+	// -1 for free slots
+	int entityId;
+} SnapshotSlot;
+
+// Saves and restores whole state of play field between iterations (entities with their objects,
+// handles, scheduled events, counters and random seed), so that world restored from a snapshot
+// continues exactly like the world it was taken from (given the same input).
+// Configuration which isn't changed by the game (field size, view, input, threads) isn't part
+// of the snapshot, play field it is restored into has to be created with the same field size.
+class PlayFieldSnapshot
+{
+private:
+	// reuses object of the same class released by ClearWorld(...) if world has one
+	static GameObject* CreateObject(const SnapshotObject& record, GameObject& laserParent, PlayField& world);
+	// objects of the world are kept for CreateObject(...) instead of being deleted
+	static void ClearWorld(PlayField& world);
+public:
+	// snapshot of world replaces content of out (buffer keeps its memory between snapshots)
+	static void Save(PlayField& world, std::vector<unsigned char>& out);
+	// replaces state of world with the snapshot, false (with world unchanged) if data isn't
+	// a valid snapshot of play field of this size
+	static bool Restore(PlayField& world, const unsigned char* data, size_t size);
+	// snapshot is written with a single write, false if file can't be written
+	static bool WriteFile(const char* path, const std::vector<unsigned char>& snapshot);
+	// snapshot is restored straight from memory mapped file, false if file can't be read
+	// or it isn't a valid snapshot of this world
+	static bool RestoreFile(PlayField& world, const char* path);
+	// FNV-1a of snapshot bytes, equal hashes mean (with high probability) equal worlds
+	static UINT64 Hash(const unsigned char* data, size_t size);
+	static UINT64 Hash(const std::vector<unsigned char>& snapshot) { return Hash(snapshot.data(), snapshot.size()); }
+};
@@ -0,0 +1,60 @@
+#include "stdafx.h"
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include "Playback.h"
+#include "FramePlayer.h"
+#include "Renderer.h"
+
+int RunPlayback(GameConfig& config)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	FramePlayer player;
+	if (!player.Open(config.playPath))
+	{
+		return -1;
+	}
+	if (config.playFromFrame < 0 || config.playFromFrame >= player.GetFramesCount())
+	{
+		std::cout << "Recording has " << player.GetFramesCount() << " frames, there is no frame " << config.playFromFrame << std::endl;
+		return -1;
+	}
+	Renderer renderer(Vector2D((float)player.GetWidth(), (float)player.GetHeight()));
+	if (!renderer.AdjustConsoleSize())
+	{
+		return -1;
+	}
+	renderer.SetcursorVisibility(false);
+	// the first frame is reached through index (decoding starts at its keyframe)
+	auto start = Clock::now();
+	bool isValid = player.Seek(config.playFromFrame);
+	double seekTimeInMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	UINT64 seekDecodedFrames = player.GetDecodedFramesCount();
+	int framesCount = 0;
+	int frame = config.playFromFrame;
+	start = Clock::now();
+	while (isValid)
+	{
+		renderer.DrawFrame(player.GetCanvas());
+		framesCount++;
+		if (++frame == player.GetFramesCount())
+		{
+			break;
+		}
+		if (config.iterationSleepTimeInMs > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(config.iterationSleepTimeInMs));
+		}
+		isValid = player.Seek(frame);
+	}
+	double playTimeInMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	renderer.SetcursorVisibility(true);
+	if (!isValid)
+	{
+		std::cout << "Recording is corrupted at frame " << frame << std::endl;
+	}
+	std::printf("Playback: frames %d-%d of %d (iteration %u), seek to the first one %.3f ms (%llu frames decoded), %.1f frames per second\n",
+		config.playFromFrame, config.playFromFrame + framesCount - 1, player.GetFramesCount(), isValid ? player.GetIteration() : 0,
+		seekTimeInMs, (unsigned long long)seekDecodedFrames, playTimeInMs > 0 ? framesCount * 1000.0 / playTimeInMs : 0.0);
+	return isValid ? 0 : -1;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "PlayField.h"
+
+// Playback mode is available through --play cmd parameter: frames recorded with --record are drawn
+// on the console from --playFrom frame (the first one by default) till the end of recording,
+// --iterationSeepTimeInMs apart (0 - as fast as console accepts them).
+int RunPlayback(GameConfig& config);
@@ -1,37 +1,75 @@
 #pragma once
 
-// PositionMap is bitmap that is used for tracking objects presence at certain points
+#include <cstring>
+#include "IntTypes.h"
+
+// PositionMap is bitmap that is used for tracking objects presence at certain points,
+// each line starts at 64-bit word boundary (so huge maps take 1 bit per point)
 class PositionMap
 {
 protected:
-	bool *m_positions = nullptr;
+	UINT64 *m_positions = nullptr;
 	int m_sizeX;
 	int m_sizeY;
 	int m_size;
-	std::vector<int> m_freeIndexes;
+	int m_wordsPerLine;
+	static inline int CountBits(UINT64 value)
+	{
+		value = value - ((value >> 1) & 0x5555555555555555ULL);
+		value = (value & 0x3333333333333333ULL) + ((value >> 2) & 0x3333333333333333ULL);
+		value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+		return (int)((value * 0x0101010101010101ULL) >> 56);
+	}
 public:
-	PositionMap(int sizeX, int sizeY, bool *buffer) : 
-		m_sizeX(sizeX), m_sizeY(sizeY), m_size(sizeX * sizeY), m_positions(buffer)
-	{ 
-		Clear(); 
+	static inline int GetWordsPerLine(int sizeX) { return (sizeX + 63) / 64; }
+	PositionMap(int sizeX, int sizeY, UINT64 *buffer) :
+		m_positions(buffer), m_sizeX(sizeX), m_sizeY(sizeY), m_size(sizeX * sizeY), m_wordsPerLine(GetWordsPerLine(sizeX))
+	{
+		Clear();
 	}
 	int getSizeX() { return m_sizeX; }
 	int getSizeY() { return m_sizeY; }
+	// raw bitmap (i.e. for snapshots)
+	UINT64* GetData() { return m_positions; }
+	int GetDataWordsCount() { return m_wordsPerLine * m_sizeY; }
 	virtual ~PositionMap(){}
-	inline void *GetLine(int line) { return &m_positions[line * m_sizeX]; }
-	inline void SetPositionOnLine(void *line, int x, bool value) { ((bool*)line)[x] = value; }
-	inline bool GetPositionOnLine(void *line, int x) { return ((bool*)line)[x]; }
-	inline void SetPosition(int x, int y, bool value) { m_positions[x + m_sizeX * y] = value; }
-	inline bool GetPosition(int x, int y) { return m_positions[x + m_sizeX * y]; }
-	void Clear() { memset(m_positions, 0, m_sizeX * m_sizeY); }
+	inline void *GetLine(int line) { return &m_positions[line * m_wordsPerLine]; }
+	inline void SetPositionOnLine(void *line, int x, bool value)
+	{
+		UINT64 &word = ((UINT64*)line)[x >> 6];
+		UINT64 bit = 1ULL << (x & 63);
+		word = value ? (word | bit) : (word & ~bit);
+	}
+	inline bool GetPositionOnLine(void *line, int x) { return ((((UINT64*)line)[x >> 6] >> (x & 63)) & 1) != 0; }
+	inline void SetPosition(int x, int y, bool value) { SetPositionOnLine(GetLine(y), x, value); }
+	inline bool GetPosition(int x, int y) { return GetPositionOnLine(GetLine(y), x); }
+	void Clear() { memset(m_positions, 0, sizeof(UINT64) * m_wordsPerLine * m_sizeY); }
+	// number of points that are not set (64 points per step)
+	int CountFreePositions()
+	{
+		int lastWordBits = m_sizeX - (m_wordsPerLine - 1) * 64;
+		UINT64 lastWordMask = lastWordBits == 64 ? ~0ULL : (1ULL << lastWordBits) - 1;
+		int count = 0;
+		for (int y = 0; y < m_sizeY; y++)
+		{
+			UINT64 *line = (UINT64*)GetLine(y);
+			for (int w = 0; w < m_wordsPerLine; w++)
+			{
+				count += CountBits(~line[w] & (w == m_wordsPerLine - 1 ? lastWordMask : ~0ULL));
+			}
+		}
+		return count;
+	}
 };
 
 template
 <int sizeX, int sizeY>
 class PositionMapStatic : public PositionMap
 {
+public:
+	static const int WordsCount = (sizeX + 63) / 64 * sizeY;
 protected:
-	bool m_positionsBuffer[sizeX * sizeY];
+	UINT64 m_positionsBuffer[WordsCount];
 public:
 	PositionMapStatic<sizeX, sizeY>() : PositionMap(sizeX, sizeY, m_positionsBuffer) {}
 };
@@ -39,6 +77,6 @@ public:
 class PositionMapDynamic : public PositionMap
 {
 public:
-	PositionMapDynamic(int sizeX, int sizeY) : PositionMap(sizeX, sizeY, new bool [sizeX * sizeY]) {}
+	PositionMapDynamic(int sizeX, int sizeY) : PositionMap(sizeX, sizeY, new UINT64[GetWordsPerLine(sizeX) * sizeY]) {}
 	virtual ~PositionMapDynamic() { delete[] m_positions; }
 };
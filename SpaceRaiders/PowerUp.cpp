@@ -3,6 +3,7 @@
 #include "GameObjects.h"
 #include "PowerUp.h"
 #include "PlayField.h"
+#include "EntityStore.h"
 
 
 void PowerUp::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Vector2D& collisionPoint)
@@ -11,33 +12,54 @@ void PowerUp::OnObjectDestroyed(GameObject& attacker, PlayField& world, const Ve
 	world.ActivatePowerUp(*this);
 }
 
-void PowerUp::Update(PlayField& world)
+void PowerUp::UpdateGroup(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands)
 {
-	m_posPrev = m_pos;
-	m_pos.y += 0.5f;
-	if ((int)m_pos.y >= (int)world.GetBounds().y)
+	int maxY = (int)world.GetBounds().y;
+	for (int i = begin; i < end; i++)
 	{
-		world.RemoveObject(this);
+		if (!group.isActive[i])
+		{
+			continue;
+		}
+		group.posPrev[i] = group.pos[i];
+		group.pos[i] += group.velocity[i];
+		if ((int)group.pos[i].y >= maxY)
+		{
+			group.isActive[i] = 0;
+			commands.RemoveObject(group.objects[i]);
+		}
 	}
 }
 
-void FasterShotsPowerUp::OnPowerUpCatched()
+void MovementSpeedPowerUp::OnPowerUpCatched(PlayField& world)
 {
-	m_world.MaxPlayerLasers = (int)((float)m_world.MaxPlayerLasers * 1.5f);
+	if (world.GetPlayerObject() != nullptr)
+		world.GetPlayerObject()->SetMovementSpeed(1.5f);
 }
-void FasterShotsPowerUp::OnPowerUpExpired()
+void MovementSpeedPowerUp::OnPowerUpExpired(PlayField& world)
 {
-	m_world.MaxPlayerLasers = (int)((float)m_world.MaxPlayerLasers / 1.5f);
+	// player might have been destroyed before power-up expired
+	if (world.GetPlayerObject() != nullptr)
+		world.GetPlayerObject()->SetMovementSpeed(1.f);
 }
 
-void TripleShotsPowerUp::OnPowerUpCatched()
+void FasterShotsPowerUp::OnPowerUpCatched(PlayField& world)
+{
+	world.MaxPlayerLasers = (int)((float)world.MaxPlayerLasers * 1.5f);
+}
+void FasterShotsPowerUp::OnPowerUpExpired(PlayField& world)
+{
+	world.MaxPlayerLasers = (int)((float)world.MaxPlayerLasers / 1.5f);
+}
+
+void TripleShotsPowerUp::OnPowerUpCatched(PlayField& world)
 {
 	// triple shots have more side effects than just modifying
-	// m_world.MaxPlayerLasers so we have dedicated PlayField methods
+	// world.MaxPlayerLasers so we have dedicated PlayField methods
 	// for handling this
-	m_world.SetTriplePlayerLaser();
+	world.SetTriplePlayerLaser();
 }
-void TripleShotsPowerUp::OnPowerUpExpired()
+void TripleShotsPowerUp::OnPowerUpExpired(PlayField& world)
 {
-	m_world.UnsetTriplePlayerLaser();
+	world.UnsetTriplePlayerLaser();
 }
\ No newline at end of file
@@ -12,6 +12,7 @@ typedef enum
 class PlayField;
 class PowerUp : public GameObject
 {
+	friend class PlayFieldSnapshot;
 protected:
 	int m_timeLeft = -1;
 	PowerUpType m_powerUpType;
@@ -23,21 +24,20 @@ public:
 		m_timeLeft(timeLeft), m_powerUpType(powerUpType),
 		m_isCatched(false)
 	{
-		static UINT32 colTypes = SetupCollidingObjects({ RI_Player});
-		m_collisionTypeBitmap = colTypes;
+		Velocity() = Vector2D(0.f, 0.5f);
 	}
 	
-	bool Tick() 
+	bool Tick(PlayField& world) 
 	{ 
 		// infinite power-ups are marekd with m_timeLeft == -1
 		if (m_isCatched && m_timeLeft != -1 && --m_timeLeft == 0)
 		{
-			OnPowerUpExpired();
+			OnPowerUpExpired(world);
 			return false;
 		}
 		return true;
 	}
-	virtual void Update(PlayField& world);
+	static void UpdateGroup(EntityGroup& group, int begin, int end, PlayField& world, WorldCommands& commands);
 	// if player will catch power-up of the same type 
 	// that he catched previosly and this power-up
 	// is still active, then Merge(...) function will be invoked
@@ -52,53 +52,43 @@ public:
 			m_timeLeft += powerUp.m_timeLeft;
 		}
 	}
-	virtual void OnPowerUpCatched() = 0;
-	virtual void OnPowerUpExpired() {};
+	// power-ups are modifying player and play field through world, so that they don't
+	// hold any references to game objects which might have been removed in the meantime
+	virtual void OnPowerUpCatched(PlayField& world) = 0;
+	virtual void OnPowerUpExpired(PlayField& world) {};
 	PowerUpType GetType() { return m_powerUpType; }
 };
 
 class MovementSpeedPowerUp : public PowerUp
 {
-protected:
-	PlayerShip& m_playerShip;
 public:
-	MovementSpeedPowerUp(PlayerShip& playerShip, Vector2D pos) :
-		PowerUp(pos, 300, BT_MovementSpeed),
-		m_playerShip(playerShip)
+	MovementSpeedPowerUp(Vector2D pos) :
+		PowerUp(pos, 300, BT_MovementSpeed)
 	{}
-	virtual void OnPowerUpCatched()
-	{
-		m_playerShip.SetMovementSpeed(1.5f);
-	}
-	virtual void OnPowerUpExpired()
-	{
-		m_playerShip.SetMovementSpeed(1.f);
-	}
+	virtual GameObjectClass GetClass() { return GC_MovementSpeedPowerUp; }
+	virtual void OnPowerUpCatched(PlayField& world);
+	virtual void OnPowerUpExpired(PlayField& world);
 };
 
 class FasterShotsPowerUp : public PowerUp
 {
-protected:
-	PlayField& m_world;
 public:
-	FasterShotsPowerUp(PlayField& world, Vector2D pos) :
-		PowerUp(pos, -1, BT_FasterShots),
-		m_world(world)
+	FasterShotsPowerUp(Vector2D pos) :
+		PowerUp(pos, -1, BT_FasterShots)
 	{}
-	virtual void OnPowerUpCatched();
-	virtual void OnPowerUpExpired();
+	virtual GameObjectClass GetClass() { return GC_FasterShotsPowerUp; }
+	virtual void OnPowerUpCatched(PlayField& world);
+	virtual void OnPowerUpExpired(PlayField& world);
 };
 
 class TripleShotsPowerUp : public PowerUp
 {
-protected:
-	PlayField & m_world;
 public:
-	TripleShotsPowerUp(PlayField& world, Vector2D pos) :
-		PowerUp(pos, -1, BT_TripleShots),
-		m_world(world)
+	TripleShotsPowerUp(Vector2D pos) :
+		PowerUp(pos, -1, BT_TripleShots)
 	{}
-	virtual void OnPowerUpCatched();
-	virtual void OnPowerUpExpired();
+	virtual GameObjectClass GetClass() { return GC_TripleShotsPowerUp; }
+	virtual void OnPowerUpCatched(PlayField& world);
+	virtual void OnPowerUpExpired(PlayField& world);
 };
 
@@ -5,61 +5,226 @@
 #include "PositionMap.h"
 #include "Vector2D.h"
 
-extern std::default_random_engine rGen;
+#include "IntTypes.h" // for UINT32, UINT64
+
 typedef std::uniform_int_distribution<int> intRand;
 typedef std::uniform_real_distribution<float> floatRand;
 
-inline int getRandInt(int min, int max)
+// Small sequential engine for code that only needs reproducible sequence of draws
+// (i.e. benchmarks populating test worlds), game itself uses WorldRandom
+typedef std::minstd_rand localRandGen;
+
+inline int getRandInt(localRandGen& gen, int min, int max)
 {
 	intRand tmp(min, max);
-	return tmp(rGen);
+	return tmp(gen);
 }
 
-inline float getRandFloat(float min, float max)
+inline float getRandFloat(localRandGen& gen, float min, float max)
 {
 	floatRand tmp(min, max);
-	return tmp(rGen);
+	return tmp(gen);
+}
+
+// what random values are used for, each purpose has its own independent stream
+// (so that adding new draws for one purpose doesn't change values drawn for others)
+typedef enum
+{
+	RP_Input = 0,
+	RP_AlienSpawn,
+	RP_AlienFire,
+	RP_AlienTransform,
+	RP_PowerUpDrop,
+	RP_SpawnAliens,
+	RP_SpawnWallBlocks,
+	RP_SpawnWave,
+	RP_PlayerUpdate
+} RandomPurpose;
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"),
+// output is a pure function of counter and key, so there is no state to share between threads
+inline void philox4x32(const UINT32 counter[4], const UINT32 key[2], UINT32 out[4])
+{
+	UINT32 c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	UINT32 k0 = key[0], k1 = key[1];
+	for (int round = 0; round < 10; round++)
+	{
+		UINT64 p0 = (UINT64)0xD2511F53U * c0;
+		UINT64 p1 = (UINT64)0xCD9E8D57U * c2;
+		c0 = (UINT32)(p1 >> 32) ^ c1 ^ k0;
+		c2 = (UINT32)(p0 >> 32) ^ c3 ^ k1;
+		c1 = (UINT32)p1;
+		c3 = (UINT32)p0;
+		k0 += 0x9E3779B9U;
+		k1 += 0xBB67AE85U;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
 }
 
+// Stream of random values for one (seed, tick, entity, purpose) key, values are generated
+// in blocks of 4 (one philox4x32(...) call per block, block index is the last counter word).
+// Streams are cheap to create and independent of each other, so objects updated in parallel
+// can draw their values without any synchronization and in any order.
+class RandomStream
+{
+private:
+	UINT32 m_key[2];
+	UINT32 m_counter[4];
+	UINT32 m_block[4];
+	int m_blockPos = 4;
+public:
+	RandomStream(UINT64 seed, UINT32 tick, UINT32 entity, RandomPurpose purpose)
+	{
+		m_key[0] = (UINT32)seed;
+		m_key[1] = (UINT32)(seed >> 32);
+		m_counter[0] = tick;
+		m_counter[1] = entity;
+		m_counter[2] = (UINT32)purpose;
+		m_counter[3] = 0;
+	}
+	UINT32 Next()
+	{
+		if (m_blockPos == 4)
+		{
+			philox4x32(m_counter, m_key, m_block);
+			m_counter[3]++;
+			m_blockPos = 0;
+		}
+		return m_block[m_blockPos++];
+	}
+	// [min, max]
+	int GetInt(int min, int max)
+	{
+		return min + (int)(((UINT64)Next() * (UINT64)((INT64)max - min + 1)) >> 32);
+	}
+	// [min, max)
+	float GetFloat(float min, float max)
+	{
+		return min + (float)(Next() >> 8) * (1.f / 16777216.f) * (max - min);
+	}
+};
+
+// Randomization context of one PlayField. All draws are keyed by (seed, tick, entity, purpose),
+// so results don't depend on order in which objects are updated (or on number of threads)
+// and several worlds can run in one process without affecting each other.
+class WorldRandom
+{
+private:
+	UINT64 m_seed;
+	UINT32 m_tick = 0;
+public:
+	// entity key used for draws made by the play field itself (no object has handle 0)
+	static const UINT32 WorldEntity = 0;
+	WorldRandom(UINT64 seed) : m_seed(seed) {}
+	void SetTick(UINT32 tick) { m_tick = tick; }
+	UINT64 GetSeed() const { return m_seed; }
+	RandomStream GetStream(UINT32 entity, RandomPurpose purpose) const
+	{
+		return RandomStream(m_seed, m_tick, entity, purpose);
+	}
+};
+
 class RandomPositionProvider : public PositionMapDynamic
 {
 protected:
-	std::vector<int> m_freeIndexes;
-	inline bool GetPositionFromIndex(int index, int &xOut, int &yOut)
+	// number of positions that can still be returned since last InitRandomFreePositions()
+	int m_freeCount = 0;
+	// free positions of lines as Fenwick tree (1-based, node i covers lines (i - (i & -i), i]),
+	// so that line of n-th free position is found without walking all lines of huge play fields
+	std::vector<int> m_lineFreeCounts;
+	// points of w-th word of a line which are inside of the map
+	inline UINT64 GetWordMask(int w)
 	{
-		if (index < 0 || index >= m_size)
+		int lastWordBits = m_sizeX - (m_wordsPerLine - 1) * 64;
+		return (w < m_wordsPerLine - 1 || lastWordBits == 64) ? ~0ULL : (1ULL << lastWordBits) - 1;
+	}
+	// finds n-th (from 0) free position, n has to be less than free positions count
+	void GetFreePosition(int n, int& xOut, int& yOut)
+	{
+		int line = 0;
+		int step = 1;
+		while (step * 2 <= m_sizeY)
 		{
-			return false;
+			step *= 2;
+		}
+		for (; step > 0; step /= 2)
+		{
+			if (line + step <= m_sizeY && m_lineFreeCounts[line + step] <= n)
+			{
+				line += step;
+				n -= m_lineFreeCounts[line];
+			}
+		}
+		UINT64* words = (UINT64*)GetLine(line);
+		for (int w = 0; ; w++)
+		{
+			UINT64 free = ~words[w] & GetWordMask(w);
+			int count = CountBits(free);
+			if (n >= count)
+			{
+				n -= count;
+				continue;
+			}
+			for (; n > 0; n--)
+			{
+				// drops the lowest free bit
+				free &= free - 1;
+			}
+			int bit = 0;
+			for (; (free & 1) == 0; free >>= 1)
+			{
+				bit++;
+			}
+			xOut = w * 64 + bit;
+			yOut = line;
+			return;
 		}
-		xOut = index % m_sizeX;
-		yOut = index / m_sizeX;
-		return true;
 	}
 public:
 	RandomPositionProvider(int sizeX, int sizeY) : PositionMapDynamic(sizeX, sizeY){}
+	// free positions are counted per line instead of being listed (it matters for huge play fields),
+	// drawn index is mapped to n-th free position and position is set, so it isn't returned again
 	void InitRandomFreePositions()
 	{
-		m_freeIndexes.clear();
-		for (int i = 0; i < m_size; i++)
+		m_lineFreeCounts.assign(m_sizeY + 1, 0);
+		m_freeCount = 0;
+		for (int y = 0; y < m_sizeY; y++)
 		{
-			if (!m_positions[i])
+			UINT64* words = (UINT64*)GetLine(y);
+			int count = 0;
+			for (int w = 0; w < m_wordsPerLine; w++)
+			{
+				count += CountBits(~words[w] & GetWordMask(w));
+			}
+			m_freeCount += count;
+			m_lineFreeCounts[y + 1] += count;
+			int parent = (y + 1) + ((y + 1) & -(y + 1));
+			if (parent <= m_sizeY)
 			{
-				m_freeIndexes.push_back(i);
+				m_lineFreeCounts[parent] += m_lineFreeCounts[y + 1];
 			}
 		}
 	}
+	int GetFreeCount() { return m_freeCount; }
+	void SetFreeCount(int count) { m_freeCount = count; }
 
-	bool GetNextRandomPosition(Vector2D& vecOut)
+	bool GetNextRandomPosition(Vector2D& vecOut, RandomStream& random)
 	{
-		if (m_freeIndexes.size() == 0)
+		if (m_freeCount == 0)
 		{
 			return false;
 		}
-		int index = getRandInt(0, (int)m_freeIndexes.size() - 1);
 		int x = 0, y = 0;
-		GetPositionFromIndex(index, x, y);
-		m_freeIndexes[index] = m_freeIndexes[m_freeIndexes.size() - 1];
-		m_freeIndexes.resize(m_freeIndexes.size() - 1);
+		GetFreePosition(random.GetInt(0, m_freeCount - 1), x, y);
+		SetPosition(x, y, true);
+		for (int i = y + 1; i <= m_sizeY; i += i & -i)
+		{
+			m_lineFreeCounts[i]--;
+		}
+		m_freeCount--;
 		vecOut = Vector2D((float)x, (float)y);
 		return true;
 	}
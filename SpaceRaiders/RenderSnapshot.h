@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "IntTypes.h"
+
+// sprite position is in screen cells
+typedef struct
+{
+	short x;
+	short y;
+	char glyph;
+} SnapshotSprite;
+
+typedef struct
+{
+	short x;
+	short y;
+	std::string text;
+} SnapshotString;
+
+// Copy of everything Renderer needs to draw a frame (visible sprites and strings in screen
+// coordinates), so that frame can be drawn on another thread while the game goes on.
+// Sprites are drawn in their order (later ones overwrite earlier ones), strings over sprites.
+// Buffers are kept between frames (strings aren't removed, only stringsCount is reset),
+// so that filling a snapshot doesn't allocate memory once it has grown to the needed size.
+class WorldSnapshot
+{
+public:
+	UINT32 iteration = 0;
+	// the last key press shown by this frame (see PlayField::SetInputLatencyStamp(...)), 0 if none
+	INT64 inputArrivalTimeNs = 0;
+	INT64 inputConsumedTimeNs = 0;
+	std::vector<SnapshotSprite> sprites;
+	std::vector<SnapshotString> strings;
+	int stringsCount = 0;
+	void Clear()
+	{
+		sprites.clear();
+		stringsCount = 0;
+	}
+	void AddString(short x, short y, const std::string& text)
+	{
+		if (stringsCount == (int)strings.size())
+		{
+			strings.emplace_back();
+		}
+		SnapshotString& str = strings[stringsCount++];
+		str.x = x;
+		str.y = y;
+		str.text = text;
+	}
+};
@@ -0,0 +1,77 @@
+#include "stdafx.h"
+#include "PlayField.h"
+#include "Renderer.h"
+#include "RenderThread.h"
+
+RenderThread::RenderThread(Renderer& renderer, bool isProfilerEnabled) :
+	m_renderer(renderer)
+{
+	m_profiler.SetEnabled(isProfilerEnabled);
+	m_thread = std::thread(&RenderThread::Loop, this);
+}
+
+RenderThread::~RenderThread()
+{
+	Stop();
+}
+
+void RenderThread::Publish(PlayField& world)
+{
+	{
+		PROFILE_SCOPE(world.GetProfiler(), PP_RenderSnapshot);
+		m_renderer.CaptureSnapshot(world, m_snapshots.GetBack());
+	}
+	m_publishedCount++;
+	m_droppedCount += m_snapshots.Publish() ? 1 : 0;
+	// (mutex is locked only so that wake up can't be missed between render thread check and wait)
+	{
+		std::lock_guard<std::mutex> lock(m_wakeUpMutex);
+	}
+	m_wakeUpCondition.notify_one();
+}
+
+void RenderThread::Stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_wakeUpMutex);
+		m_isStopping = true;
+	}
+	m_wakeUpCondition.notify_one();
+	m_thread.join();
+}
+
+void RenderThread::Loop()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_wakeUpMutex);
+			m_wakeUpCondition.wait(lock, [this]() { return m_isStopping || m_snapshots.HasNewData(); });
+			// the last snapshot is drawn before stopping
+			if (m_isStopping && !m_snapshots.HasNewData())
+			{
+				return;
+			}
+		}
+		if (m_snapshots.Acquire())
+		{
+			PROFILE_BEGIN_TICK(m_profiler);
+			m_renderer.Render(m_snapshots.GetFront(), m_profiler);
+			m_renderedCount++;
+		}
+	}
+}
+
+void RenderThread::WriteReport(std::ostream& out)
+{
+	out << "Render thread: " << m_publishedCount << " snapshots published, " << m_renderedCount << " drawn, "
+		<< m_droppedCount << " dropped (replaced by newer ones before drawing)" << std::endl;
+	if (m_profiler.IsEnabled())
+	{
+		m_profiler.WriteReport(out);
+	}
+}
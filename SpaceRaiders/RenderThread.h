@@ -0,0 +1,45 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ostream>
+#include "TripleBuffer.h"
+#include "RenderSnapshot.h"
+#include "FrameProfiler.h"
+
+class Renderer;
+class PlayField;
+
+// Draws frames on its own thread (available through --renderThread cmd parameter), so that
+// slow console output doesn't delay next game iterations: game thread captures snapshot
+// of visible objects after each iteration and publishes it through lock-free triple buffer,
+// render thread draws the most recent snapshot (snapshots published while previous frame
+// was being drawn are dropped). Mutex and condition variable are used only to put render
+// thread to sleep when there is nothing new to draw, snapshots are never guarded by them.
+class RenderThread
+{
+private:
+	Renderer& m_renderer;
+	TripleBuffer<WorldSnapshot> m_snapshots;
+	std::thread m_thread;
+	std::mutex m_wakeUpMutex;
+	std::condition_variable m_wakeUpCondition;
+	bool m_isStopping = false;
+	// render thread has its own profiler (fill, rasterize and draw phases)
+	FrameProfiler m_profiler;
+	// counted by game thread
+	UINT64 m_publishedCount = 0;
+	UINT64 m_droppedCount = 0;
+	// counted by render thread
+	UINT64 m_renderedCount = 0;
+	void Loop();
+public:
+	RenderThread(Renderer& renderer, bool isProfilerEnabled);
+	~RenderThread();
+	// captures snapshot of the world (game thread)
+	void Publish(PlayField& world);
+	// waits till the last published snapshot is drawn and stops the thread
+	void Stop();
+	void WriteReport(std::ostream& out);
+};
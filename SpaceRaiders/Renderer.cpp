@@ -1,145 +1,198 @@
 #include "stdafx.h"
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
 #include "Vector2D.h"
 #include "PlayField.h"
 #include "Renderer.h"
 #include "GameObjects.h"
-#include <new>
+#include "CanvasDiff.h"
+#include "CanvasRasterizer.h"
+#include "FrameRecorder.h"
 
-const HANDLE setCursorPosition(int x, int y)
-{
-	static const HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-	COORD coord = { (SHORT)x, (SHORT)y };
-	SetConsoleCursorPosition(hOut, coord);
-	return hOut;
-}
-
-Renderer::Renderer(const Vector2D& bounds) :
-    m_renderBounds(bounds),
-    m_hout(INVALID_HANDLE_VALUE)
+Renderer::Renderer(const Vector2D& bounds, ConsoleBackend* backend) :
+    m_backend(backend != nullptr ? backend : CreateConsoleBackend()),
+    m_renderBounds(bounds)
 {
 	m_canvasSize = (int)(bounds.x * bounds.y);
 	m_canvas = new unsigned char[m_canvasSize];
+	m_prevCanvas = new unsigned char[m_canvasSize];
+	// the longest frame is full redraw (cursor sequence before each row and whole canvas),
+	// so output buffer never grows during the game
+	m_output.reserve(m_canvasSize + (int)bounds.y * MaxCursorSequenceSize);
 }
 
 
 Renderer::~Renderer()
 {
 	delete[] m_canvas;
+	delete[] m_prevCanvas;
 }
 
 bool Renderer::AdjustConsoleSize()
 {
-	m_hout = GetStdHandle(STD_OUTPUT_HANDLE);
-	// we are setting window height to m_renderBounds.y + 1 to avoid game screen jumping up and down because of 
-	// inserting last character from m_canvas to console window (then cursor moves to new line that is beyond 
-	// rendering area and when we invoke setCursorPosition(0, 0) all game screen jumps one character up)
-	
-	CONSOLE_SCREEN_BUFFER_INFO  info;
-	GetConsoleScreenBufferInfo(m_hout, &info);
+	return m_backend->Init((int)m_renderBounds.x, (int)m_renderBounds.y);
+}
 
-	//our desired buffsize and windowRect size.
-	COORD bufSize = { (SHORT)m_renderBounds.x, (SHORT)m_renderBounds.y + 1 };
-	SMALL_RECT consoleWindowRect = { 0, 0, (SHORT)m_renderBounds.x - 1, (SHORT)m_renderBounds.y };
+void Renderer::SetcursorVisibility(bool isVisible)
+{
+	m_backend->SetCursorVisibility(isVisible);
+}
 
-	// If the Current Buffer is Larger than what we want, Resize the 
-	// Console Window First, then the Buffer 
-	if ((DWORD)info.dwSize.X * info.dwSize.Y > (DWORD)bufSize.X * bufSize.Y)
-	{
-		if (!SetConsoleWindowInfo(m_hout, TRUE, &consoleWindowRect))
-		{
-			std::printf("Error unable to set console window size to %hux%hu\n",
-				consoleWindowRect.Right, consoleWindowRect.Bottom);
-			return false;
-		}
 
-		if (!SetConsoleScreenBufferSize(m_hout, bufSize))
-		{
-			std::printf("Error unable to set console screen buffer size to %hux%hu\n", bufSize.X, bufSize.Y);
-			return false;
-		}
+void Renderer::UpdateCamera(PlayField& world)
+{
+	PlayerShip* player = world.GetPlayerObject();
+	if (player != nullptr)
+	{
+		m_cameraPos.x = FLOOR(player->GetPos().x) - FLOOR(m_renderBounds.x / 2);
+		m_cameraPos.y = FLOOR(player->GetPos().y) - FLOOR(m_renderBounds.y / 2);
 	}
-	// If the Current Buffer is Smaller than what we want, Resize the 
-	// Buffer First, then the Console Window 
-	else if ((DWORD)info.dwSize.X * info.dwSize.Y < (DWORD)bufSize.X * bufSize.Y)
+	// (std::min/max in parentheses because of min/max macros from Windows.h)
+	const Vector2D& fieldSize = world.GetFieldSize();
+	m_cameraPos.x = (std::max)((std::min)(m_cameraPos.x, fieldSize.x - m_renderBounds.x), 0.f);
+	m_cameraPos.y = (std::max)((std::min)(m_cameraPos.y, fieldSize.y - m_renderBounds.y), 0.f);
+}
+
+void Renderer::CaptureSnapshot(PlayField& world, WorldSnapshot& snapshot)
+{
+	UpdateCamera(world);
+	snapshot.Clear();
+	snapshot.iteration = world.GetIteration();
+	snapshot.inputArrivalTimeNs = world.GetInputArrivalTimeNs();
+	snapshot.inputConsumedTimeNs = world.GetInputConsumedTimeNs();
+	// only objects visible on the screen are added to snapshot (play field is culled
+	// through its collision grid), sprites are moved to screen coordinates
+	int cameraX = (int)m_cameraPos.x, cameraY = (int)m_cameraPos.y;
+	world.ForEachObjectInRect(cameraX, cameraY, cameraX + (int)m_renderBounds.x - 1, cameraY + (int)m_renderBounds.y - 1,
+		[&](const EntityGroup& group, int index)
 	{
-		if (!SetConsoleScreenBufferSize(m_hout, bufSize))
+		float x = group.pos[index].x - m_cameraPos.x, y = group.pos[index].y - m_cameraPos.y;
+		if (x >= 0 && y >= 0 && x < m_renderBounds.x && y < m_renderBounds.y)
 		{
-			std::printf("Error unable to set console screen buffer size to %hux%hu\n", bufSize.X, bufSize.Y);
-			return false;
+			snapshot.sprites.push_back({ (short)x, (short)y, (char)group.sprite[index] });
 		}
-		
-		if (!SetConsoleWindowInfo(m_hout, TRUE, &consoleWindowRect))
+	});
+	// strings are already in screen coordinates
+	for (auto it : world.StringObjects())
+	{
+		if (it->GetPos().x >= 0 && it->GetPos().y >= 0 && it->GetPos().x < m_renderBounds.x && it->GetPos().y < m_renderBounds.y)
 		{
-			std::printf("Error unable to set console window size to %hux%hu\n",
-				consoleWindowRect.Right, consoleWindowRect.Bottom);
-			return false;
+			snapshot.AddString((short)it->GetPos().x, (short)it->GetPos().y, it->GetStr());
 		}
 	}
-	else
+}
+
+void Renderer::Render(const WorldSnapshot& snapshot, FrameProfiler& profiler)
+{
 	{
-		// If the Current Buffer *is* the Size we want, Don't do anything! 
+		PROFILE_SCOPE(profiler, PP_RenderFill);
+		FillCanvas(RS_BackgroundTile);
+	}
+	{
+		PROFILE_SCOPE(profiler, PP_RenderRasterize);
+		CanvasRasterizer::Draw(m_canvas, (int)m_renderBounds.x, (int)m_renderBounds.y, snapshot);
+	}
+	if (m_recorder != nullptr)
+	{
+		PROFILE_SCOPE(profiler, PP_RenderRecord);
+		m_recorder->AddFrame(m_canvas, snapshot);
+	}
+	{
+		PROFILE_SCOPE(profiler, PP_RenderDraw);
+		DrawCanvas();
+	}
+	// the first frame with newer key press is the one which shows its effect
+	if (snapshot.inputArrivalTimeNs > m_lastInputArrivalTimeNs)
+	{
+		INT64 flushTimeNs = (INT64)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		m_inputToIterationLatency.Add((UINT64)(snapshot.inputConsumedTimeNs - snapshot.inputArrivalTimeNs));
+		m_iterationToDisplayLatency.Add((UINT64)(flushTimeNs - snapshot.inputConsumedTimeNs));
+		m_inputToDisplayLatency.Add((UINT64)(flushTimeNs - snapshot.inputArrivalTimeNs));
+		m_lastInputArrivalTimeNs = snapshot.inputArrivalTimeNs;
 	}
-
-    return true;
 }
 
-void Renderer::SetcursorVisibility(bool isVisible)
+void Renderer::Update(PlayField& world)
 {
-    CONSOLE_CURSOR_INFO info = { isVisible ? (DWORD)10 : (DWORD)100, isVisible ? TRUE : FALSE };
-    SetConsoleCursorInfo(m_hout, &info);
+	{
+		PROFILE_SCOPE(world.GetProfiler(), PP_RenderSnapshot);
+		CaptureSnapshot(world, m_snapshot);
+	}
+	Render(m_snapshot, world.GetProfiler());
 }
 
+void Renderer::DrawFrame(const unsigned char* canvas)
+{
+	memcpy(m_canvas, canvas, m_canvasSize);
+	DrawCanvas();
+}
 
-void Renderer::Update(PlayField& world)
+void Renderer::FillCanvas(unsigned char m_sprite)
 {
-	FillCanvas(RS_BackgroundTile);
+	memset(CurCanvas(0, 0), m_sprite, m_canvasSize);
+}
 
-	// reserve memory for render items 
-	// (each item have size of max(sizeof(RenderItemSprite), sizeof(RenderItemString)))
-	m_renderList.resize(world.GameObjects().size() + world.StringObjects().size());
-	int i = 0;
-	for (auto it : world.GameObjects())
-	{
-		new(&m_renderList[i++])RenderItemSprite(it->GetPos(), it->GetSprite());
-	}
-	for (auto it : world.StringObjects())
-	{
-		new(&m_renderList[i++])RenderItemString(it->GetPos(), it->GetStr().c_str());
-	}
-	for (auto ri : m_renderList)
+void Renderer::DrawCanvas()
+{
+	// printing characters one by one on the screen can produce ugly effects,
+	// it's much better to print the entire buffer (or all changed cells) at once
+	m_framesCount++;
+	if (m_backend->IsVirtualTerminal())
 	{
-		RenderItemBase *item = (RenderItemBase*)&ri;
-		if (item->m_pos.x < 0 || item->m_pos.y < 0)
+		m_output.clear();
+		bool isDiff = m_isPrevCanvasValid && CanvasDiff::Build(m_canvas, m_prevCanvas, (int)m_renderBounds.x, (int)m_renderBounds.y,
+			m_canvasSize * DiffCostThresholdPercent / 100, m_output);
+		if (!isDiff)
 		{
-			continue;
+			m_fullRedrawsCount++;
+			// each row is positioned, terminal wider than the view would wrap rows written in one run
+			const int width = (int)m_renderBounds.x;
+			for (int y = 0; y < (int)m_renderBounds.y; y++)
+			{
+				CanvasDiff::AppendCursorPosition(0, y, m_output);
+				m_output.insert(m_output.end(), m_canvas + y * width, m_canvas + (y + 1) * width);
+			}
 		}
-		int x = int(item->m_pos.x);
-		int y = int(item->m_pos.y);
-		if (y >= m_renderBounds.y)
+		if (!m_output.empty())
 		{
-			continue;
-		}
-		for(auto renderChars = item->GetSpriteCharsArray(); 
-			*renderChars != 0 && x < m_renderBounds.x; renderChars++, x++)
-		{
-			*CurCanvas(x, y) = *renderChars;
+			m_backend->Write(m_output.data(), m_output.size());
 		}
+		m_outputBytesCount += m_output.size();
+		// canvas is filled from scratch every frame, so buffers can be swapped
+		std::swap(m_canvas, m_prevCanvas);
+		m_isPrevCanvasValid = true;
+		return;
 	}
-
-	DrawCanvas();
+	m_fullRedrawsCount++;
+	m_outputBytesCount += m_canvasSize;
+	m_backend->MoveCursorHome();
+	m_backend->Write((const char*)CurCanvas(0, 0), m_canvasSize);
 }
 
-void Renderer::FillCanvas(unsigned char m_sprite)
+void Renderer::WriteReport(std::ostream& out)
 {
-	memset(CurCanvas(0, 0), m_sprite, m_canvasSize);
+	out << "Console output: " << m_framesCount << " frames, "
+		<< (m_framesCount > 0 ? m_outputBytesCount / m_framesCount : 0) << " bytes per frame, "
+		<< m_fullRedrawsCount << " full redraws" << std::endl;
 }
 
-void Renderer::DrawCanvas()
+void Renderer::WriteLatencyReport(std::ostream& out)
 {
-	// printing characters one by one on the screen can produce ugly effects,
-	// it's much better to print the entire buffer at once
-	auto handle = setCursorPosition(0, 0);
-	WriteConsoleA(handle, (const char*)CurCanvas(0, 0), m_canvasSize, NULL, NULL);
-}
\ No newline at end of file
+	char line[160];
+	std::snprintf(line, sizeof(line), "Input latency (%llu key presses shown):\n", (unsigned long long)m_inputToDisplayLatency.GetCount());
+	out << line;
+	const DurationHistogram* histograms[] = { &m_inputToIterationLatency, &m_iterationToDisplayLatency, &m_inputToDisplayLatency };
+	const char* names[] = { "key -> iteration ms", "iteration -> display ms", "key -> display ms" };
+	for (int i = 0; i < 3; i++)
+	{
+		std::snprintf(line, sizeof(line), "%24s mean %.4f p50 %.4f p90 %.4f p99 %.4f max %.4f\n", names[i],
+			histograms[i]->GetMeanInMs(), histograms[i]->GetPercentileInMs(50), histograms[i]->GetPercentileInMs(90),
+			histograms[i]->GetPercentileInMs(99), histograms[i]->GetMaxInMs());
+		out << line;
+	}
+}
@@ -1,79 +1,80 @@
 #pragma once
 
-#include <Windows.h>
 #include <vector>
+#include <memory>
+#include <ostream>
+#include "RenderSnapshot.h"
+#include "FrameProfiler.h"
+#include "ConsoleBackend.h"
 
-class RenderItemBase
-{
-public:
-	RenderItemBase(const Vector2D& iPos) : m_pos(iPos) {}
-	Vector2D m_pos;
-	virtual const char* GetSpriteCharsArray() = 0;
-};
-
-class RenderItemSprite : public RenderItemBase
-{
-protected:
-	char m_sprite[2];
-public:
-	RenderItemSprite(const Vector2D& iPos, char iSprite) : RenderItemBase(iPos)
-	{
-		m_sprite[0] = iSprite;
-		m_sprite[1] = 0;
-	}
-	virtual const char* GetSpriteCharsArray() { return m_sprite; }
-};
-
-class RenderItemString : public RenderItemBase
-{
-protected:
-	const char *m_str;
-public:
-	RenderItemString(const Vector2D& iPos, const char *str) : RenderItemBase(iPos), m_str(str) {}
-	virtual const char* GetSpriteCharsArray() 
-	{ 
-		return m_str; 
-	}
-};
-
-typedef union _RenderItemUnionBuffer
-{
-	char reserved1[sizeof(RenderItemSprite)];
-	char reserved2[sizeof(RenderItemString)];
-	_RenderItemUnionBuffer(){}
-} RenderItemUnion;
+class FrameRecorder;
 
-typedef std::vector<RenderItemUnion> RenderItemList;
 class PlayField;
 class Renderer
 {
 private:
-	// it's better to place render list vector as class member
-	// because this can avoid constant memory reallocations on adding
-	// new items to vector
-	RenderItemList m_renderList;
-    HANDLE m_hout;
+	// snapshot used by Update(...)
+	WorldSnapshot m_snapshot;
+	std::unique_ptr<ConsoleBackend> m_backend;
+	FrameRecorder* m_recorder = nullptr;
 public:
-	Renderer(const Vector2D& bounds);
+	// renderer takes ownership of backend, console of the platform is used if it is nullptr
+	Renderer(const Vector2D& bounds, ConsoleBackend* backend = nullptr);
 	~Renderer();
 
 	// Draws all game objects after clearing filling the Canvas with _ symbol
 	void Update(PlayField& world);
+	// Update(...) is split into these two steps, so that frame may be drawn on another thread:
+	// snapshot of visible objects is taken on the game thread (it also moves the camera)
+	void CaptureSnapshot(PlayField& world, WorldSnapshot& snapshot);
+	// and it is drawn on the console (fill, rasterize and draw phases are measured by profiler)
+	void Render(const WorldSnapshot& snapshot, FrameProfiler& profiler);
     bool AdjustConsoleSize();
     void SetcursorVisibility(bool isVisible);
+    // console output statistics (bytes per frame, full redraws)
+    void WriteReport(std::ostream& out);
+    // histograms of time from key press to the first displayed frame which shows its effect,
+    // split at iteration which consumed the press (displayed means written to the console)
+    void WriteLatencyReport(std::ostream& out);
+    UINT64 GetOutputBytesCount() { return m_outputBytesCount; }
+    // each rendered frame is also added to recorder (nullptr stops recording)
+    void SetRecorder(FrameRecorder* recorder) { m_recorder = recorder; }
+    // draws canvas of width * height cells given to constructor (i.e. recorded frame)
+    void DrawFrame(const unsigned char* canvas);
 
 private:
 	Vector2D m_renderBounds;
+	// top left corner of visible part of play field (play field may be bigger than the screen)
+	Vector2D m_cameraPos;
+	// camera follows player ship (and stays where it was when there is no player)
+	void UpdateCamera(PlayField& world);
 	// there is no point in using double buffering here since
 	// console screen is not autonomously updated when we are writing to
 	// our private buffer like it is done i.e. in GPU frame buffers
 	unsigned char* m_canvas = nullptr;
 	int m_canvasSize = 0;
+	// frame which is on the screen, only changed cells are written when console
+	// understands VT sequences (otherwise whole canvas is written every frame)
+	unsigned char* m_prevCanvas = nullptr;
+	bool m_isPrevCanvasValid = false;
+	bool m_isVirtualTerminalEnabled = false;
+	std::vector<char> m_output;
+	UINT64 m_framesCount = 0;
+	UINT64 m_outputBytesCount = 0;
+	UINT64 m_fullRedrawsCount = 0;
+	INT64 m_lastInputArrivalTimeNs = 0;
+	DurationHistogram m_inputToIterationLatency;
+	DurationHistogram m_iterationToDisplayLatency;
+	DurationHistogram m_inputToDisplayLatency;
+	// diff output longer than that (percent of whole canvas) is replaced by full redraw
+	static const int DiffCostThresholdPercent = 60;
+	// ESC [ row ; column H with up to 5 digit coordinates
+	static const int MaxCursorSequenceSize = 16;
 	unsigned char* CurCanvas(int x, int y) { return &m_canvas[x + (int)m_renderBounds.x * y];  }
 
 	// Fills whole m_canvas array with m_sprite
 	void FillCanvas(unsigned char m_sprite);
-	// Prints m_canvas char array on console
+	// Prints m_canvas char array on console (only cells changed since previous frame if possible)
 	void DrawCanvas();
 };
 
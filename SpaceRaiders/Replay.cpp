@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <iostream>
+#include "Replay.h"
+#include "ReplayPlayer.h"
+#include "PlayFieldSnapshot.h"
+#include "Renderer.h"
+
+int RunReplay(GameConfig& config)
+{
+	typedef std::chrono::high_resolution_clock Clock;
+	ReplayPlayer player;
+	if (!player.Open(config.replayPath))
+	{
+		return -1;
+	}
+	const ReplayHeader& header = player.GetHeader();
+	UINT32 fromTick = config.replayFromTick > 0 ? (UINT32)config.replayFromTick : player.GetBeginTick();
+	if (fromTick < player.GetBeginTick() || fromTick > player.GetEndTick())
+	{
+		std::cout << "Replay has ticks " << player.GetBeginTick() << "-" << player.GetEndTick() << ", there is no tick " << fromTick << std::endl;
+		return -1;
+	}
+	// play field is configured like the recorded one, everything else comes from snapshots
+	config.seed = header.seed;
+	config.testRun = true;
+	config.testIterations = (int)player.GetEndTick();
+	Vector2D size((float)header.fieldSizeX, (float)header.fieldSizeY);
+	Vector2D viewSize((float)header.viewSizeX, (float)header.viewSizeY);
+	std::unique_ptr<Renderer> renderer;
+	if (!config.runHeadless)
+	{
+		renderer.reset(new Renderer(viewSize));
+		if (!renderer->AdjustConsoleSize())
+		{
+			return -1;
+		}
+		renderer->SetcursorVisibility(false);
+	}
+	PlayField world(size, config, viewSize);
+	ReplayInput input(player, world);
+	world.SetControllerInput(&input);
+
+	auto start = Clock::now();
+	bool isValid = player.Seek(world, fromTick);
+	double seekTimeInMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	UINT64 seekPlayedTicks = player.GetPlayedTicksCount();
+	start = Clock::now();
+	int iterationsToRun = 1;
+	while (isValid && world.IsStillRunning())
+	{
+		for (int i = 0; i < iterationsToRun && world.IsStillRunning(); i++)
+		{
+			world.Update();
+		}
+		if (renderer)
+		{
+			renderer->Update(world);
+			iterationsToRun = world.WaitBetweenIterations();
+		}
+	}
+	double playTimeInMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	if (renderer)
+	{
+		// the last frame stays on the screen
+		renderer->Update(world);
+		renderer->SetcursorVisibility(true);
+	}
+	if (!isValid)
+	{
+		std::cout << "Replay can't reach tick " << fromTick << " (snapshot is corrupted)" << std::endl;
+		return -1;
+	}
+	UINT32 playedTicks = world.GetIteration() - fromTick;
+	std::printf("Replay: ticks %u-%u of %u-%u, seek %.3f ms (%u snapshots restored, %llu ticks played), %.1f ticks per second, score %d\n",
+		fromTick, world.GetIteration(), player.GetBeginTick(), player.GetEndTick(), seekTimeInMs,
+		player.GetRestoredSnapshotsCount(), (unsigned long long)seekPlayedTicks,
+		playTimeInMs > 0 ? playedTicks * 1000.0 / playTimeInMs : 0.0, world.GetScore());
+	UINT64 recordedHash;
+	if (!player.GetSnapshotHash(world.GetIteration(), recordedHash))
+	{
+		std::printf("        recording has no snapshot of tick %u to compare with\n", world.GetIteration());
+		return 0;
+	}
+	std::vector<unsigned char> snapshot;
+	PlayFieldSnapshot::Save(world, snapshot);
+	UINT64 hash = PlayFieldSnapshot::Hash(snapshot);
+	std::printf("        state hash %016llx %s\n", (unsigned long long)hash,
+		hash == recordedHash ? "matches recording" : "DIFFERS FROM RECORDING");
+	return hash == recordedHash ? 0 : -1;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "PlayField.h"
+
+// Replay mode is available through --replay cmd parameter: game recorded with --recordInput is
+// played again with recorded input from --replayFrom tick (the first one by default), reached by
+// restoring the nearest snapshot and playing ticks after it. Game is drawn like the original one
+// (paced by --iterationSeepTimeInMs), with --headless it is played as fast as possible instead.
+// At the end, state of the world is compared with the final snapshot of the recording.
+int RunReplay(GameConfig& config);
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "IntTypes.h"
+
+// Replay file (written by ReplayRecorder, read by ReplayPlayer) is a header followed by chunks:
+//	ReplayHeader
+//	ReplayChunkHeader, payload (padded to 8 bytes)
+//	...
+// Input chunk holds runs of ticks with the same buttons, snapshot chunk holds PlayFieldSnapshot
+// taken before its tick was played. File starts with a snapshot and has one every
+// snapshotInterval ticks, so seeking to a tick restores the nearest snapshot before it and plays
+// at most snapshotInterval ticks with recorded input. Input of one snapshot interval may be split
+// into several consecutive chunks (recorder writes it more often than snapshots). Chunks are
+// self-contained, so file of a game which hasn't finished (or has crashed) can be replayed up to
+// its last complete chunk.
+static const char ReplayMagic[4] = { 'S', 'R', 'R', 'P' };
+static const UINT32 ReplayVersion = 1;
+
+typedef struct
+{
+	char magic[4];
+	UINT32 version;
+	// configuration of the play field (snapshot holds everything that changes during the game)
+	int seed;
+	int fieldSizeX;
+	int fieldSizeY;
+	int viewSizeX;
+	int viewSizeY;
+	UINT32 snapshotInterval;
+} ReplayHeader;
+
+typedef enum
+{
+	RCT_Input = 1,
+	RCT_Snapshot
+} ReplayChunkType;
+
+typedef struct
+{
+	UINT32 type;
+	// tick of the first input run, tick before which snapshot has been taken
+	UINT32 tick;
+	// payload size (without padding)
+	UINT64 size;
+} ReplayChunkHeader;
+
+// buttons pressed in a tick
+typedef enum
+{
+	RB_Left = 1,
+	RB_Right = 2,
+	RB_Fire = 4
+} ReplayButton;
+
+// input run: buttons in the lower ReplayButtonBits bits, number of ticks in the rest
+typedef UINT32 ReplayInputRun;
+static const int ReplayButtonBits = 3;
+static const UINT32 ReplayButtonsMask = (1U << ReplayButtonBits) - 1;
+static const UINT32 ReplayMaxRunTicks = 0xffffffffU >> ReplayButtonBits;
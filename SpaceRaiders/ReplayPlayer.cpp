@@ -0,0 +1,135 @@
+#include "stdafx.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "ReplayPlayer.h"
+#include "PlayField.h"
+#include "PlayFieldSnapshot.h"
+
+bool ReplayPlayer::Open(const char* path)
+{
+	if (!m_file.Open(path) || m_file.GetSize() < sizeof(ReplayHeader))
+	{
+		std::printf("Error can't read replay file %s\n", path);
+		return false;
+	}
+	std::memcpy(&m_header, m_file.GetData(), sizeof(m_header));
+	if (std::memcmp(m_header.magic, ReplayMagic, sizeof(ReplayMagic)) != 0 || m_header.version != ReplayVersion)
+	{
+		std::printf("Error %s isn't a replay of this game version\n", path);
+		return false;
+	}
+	m_runs.clear();
+	m_snapshots.clear();
+	m_endTick = 0;
+	UINT64 offset = sizeof(ReplayHeader);
+	ReplayChunkHeader chunk;
+	while (offset + sizeof(chunk) <= m_file.GetSize())
+	{
+		std::memcpy(&chunk, m_file.GetData() + offset, sizeof(chunk));
+		UINT64 payload = offset + sizeof(chunk);
+		// the last chunk may have been written partially
+		if (chunk.size > m_file.GetSize() - payload || (chunk.type != RCT_Input && chunk.type != RCT_Snapshot))
+		{
+			break;
+		}
+		if (chunk.type == RCT_Snapshot)
+		{
+			m_snapshots.push_back({ chunk.tick, payload, chunk.size });
+			m_endTick = std::max(m_endTick, chunk.tick);
+		}
+		else
+		{
+			UINT32 tick = chunk.tick;
+			for (UINT64 i = 0; i + sizeof(ReplayInputRun) <= chunk.size; i += sizeof(ReplayInputRun))
+			{
+				ReplayInputRun run;
+				std::memcpy(&run, m_file.GetData() + payload + i, sizeof(run));
+				m_runs.push_back({ tick, run & ReplayButtonsMask });
+				tick += run >> ReplayButtonBits;
+			}
+			m_endTick = std::max(m_endTick, tick);
+		}
+		offset = payload + ((chunk.size + 7) & ~7ULL);
+	}
+	if (m_snapshots.empty())
+	{
+		std::printf("Error %s has no snapshot to start from\n", path);
+		return false;
+	}
+	m_isWorldRestored = false;
+	return true;
+}
+
+UINT32 ReplayPlayer::GetButtons(UINT32 tick, size_t& cursor)
+{
+	if (m_runs.empty() || tick < m_runs.front().tick || tick >= m_endTick)
+	{
+		return 0;
+	}
+	// cursor is moved to the next run (consecutive ticks), other ticks are searched for
+	if (cursor >= m_runs.size() || m_runs[cursor].tick > tick)
+	{
+		cursor = 0;
+	}
+	if (cursor + 1 < m_runs.size() && m_runs[cursor + 1].tick <= tick)
+	{
+		cursor++;
+		if (cursor + 1 < m_runs.size() && m_runs[cursor + 1].tick <= tick)
+		{
+			auto it = std::upper_bound(m_runs.begin() + cursor, m_runs.end(), tick,
+				[](UINT32 value, const InputRun& run) { return value < run.tick; });
+			cursor = (size_t)(it - m_runs.begin()) - 1;
+		}
+	}
+	return m_runs[cursor].buttons;
+}
+
+int ReplayPlayer::FindSnapshot(UINT32 tick)
+{
+	auto it = std::upper_bound(m_snapshots.begin(), m_snapshots.end(), tick,
+		[](UINT32 value, const SnapshotEntry& entry) { return value < entry.tick; });
+	return (int)(it - m_snapshots.begin()) - 1;
+}
+
+bool ReplayPlayer::Seek(PlayField& world, UINT32 tick)
+{
+	int snapshot = FindSnapshot(tick);
+	if (snapshot < 0 || tick > m_endTick)
+	{
+		return false;
+	}
+	// ticks are played from current state if it is between the snapshot and requested tick
+	const SnapshotEntry& entry = m_snapshots[snapshot];
+	if (!m_isWorldRestored || world.GetIteration() < entry.tick || world.GetIteration() > tick)
+	{
+		if (!PlayFieldSnapshot::Restore(world, m_file.GetData() + entry.offset, (size_t)entry.size))
+		{
+			return false;
+		}
+		m_isWorldRestored = true;
+		m_restoredSnapshotsCount++;
+	}
+	while (world.GetIteration() < tick && !world.IsGameOver())
+	{
+		world.Update();
+		m_playedTicksCount++;
+	}
+	return world.GetIteration() == tick;
+}
+
+bool ReplayPlayer::GetSnapshotHash(UINT32 tick, UINT64& hashOut)
+{
+	int snapshot = FindSnapshot(tick);
+	if (snapshot < 0 || m_snapshots[snapshot].tick != tick)
+	{
+		return false;
+	}
+	hashOut = PlayFieldSnapshot::Hash(m_file.GetData() + m_snapshots[snapshot].offset, (size_t)m_snapshots[snapshot].size);
+	return true;
+}
+
+void ReplayInput::Update()
+{
+	m_buttons = m_player.GetButtons(m_world.GetIteration(), m_cursor);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include "MappedFile.h"
+#include "ReplayFile.h"
+#include "Input.h"
+
+class PlayField;
+
+// Reads replay file written by ReplayRecorder from memory mapped file. Chunks are walked once
+// when file is opened: input runs are expanded into ticks they start at (so buttons of any tick
+// are found by binary search) and snapshots are indexed by their tick. Snapshots are restored
+// straight from the mapping.
+class ReplayPlayer
+{
+private:
+	typedef struct
+	{
+		UINT32 tick;
+		UINT32 buttons;
+	} InputRun;
+	typedef struct
+	{
+		UINT32 tick;
+		UINT64 offset;
+		UINT64 size;
+	} SnapshotEntry;
+	MappedFile m_file;
+	ReplayHeader m_header;
+	// runs in ticks order, each one lasts till the next one (the last one till m_endTick)
+	std::vector<InputRun> m_runs;
+	std::vector<SnapshotEntry> m_snapshots;
+	UINT32 m_endTick = 0;
+	bool m_isWorldRestored = false;
+	UINT32 m_restoredSnapshotsCount = 0;
+	UINT64 m_playedTicksCount = 0;
+	// the last snapshot taken before tick (or at it), -1 if there is none
+	int FindSnapshot(UINT32 tick);
+public:
+	// false (with error printed) if file isn't a replay or doesn't start with a snapshot
+	bool Open(const char* path);
+	const ReplayHeader& GetHeader() { return m_header; }
+	// first tick of the replay (its first snapshot) and the tick after the last recorded one
+	UINT32 GetBeginTick() { return m_snapshots.front().tick; }
+	UINT32 GetEndTick() { return m_endTick; }
+	// ReplayButton flags, cursor is a hint (index of run of previous tick) which makes
+	// consecutive ticks O(1), ticks outside the recording have no buttons
+	UINT32 GetButtons(UINT32 tick, size_t& cursor);
+	// brings world to the state before given tick: restores the nearest snapshot and plays ticks
+	// after it (or just plays ticks if world is already between that snapshot and tick), world has
+	// to use ReplayInput of this player, false if tick is outside the replay or snapshot is invalid
+	bool Seek(PlayField& world, UINT32 tick);
+	// hash of snapshot taken before given tick, false if there is no snapshot of this tick
+	bool GetSnapshotHash(UINT32 tick, UINT64& hashOut);
+	UINT32 GetRestoredSnapshotsCount() { return m_restoredSnapshotsCount; }
+	UINT64 GetPlayedTicksCount() { return m_playedTicksCount; }
+};
+
+// Input replayed from ReplayPlayer, buttons are taken for the tick play field is at
+class ReplayInput : public Input
+{
+private:
+	ReplayPlayer& m_player;
+	PlayField& m_world;
+	size_t m_cursor = 0;
+	UINT32 m_buttons = 0;
+public:
+	ReplayInput(ReplayPlayer& player, PlayField& world) : m_player(player), m_world(world) {}
+	virtual bool Left() { return (m_buttons & RB_Left) != 0; }
+	virtual bool Right() { return (m_buttons & RB_Right) != 0; }
+	virtual bool Fire() { return (m_buttons & RB_Fire) != 0; }
+	virtual void Update();
+};
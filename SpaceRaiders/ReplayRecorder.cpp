@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include "ReplayRecorder.h"
+#include "PlayField.h"
+#include "PlayFieldSnapshot.h"
+
+ReplayRecorder::~ReplayRecorder()
+{
+	Close();
+}
+
+bool ReplayRecorder::Open(const char* path, int seed, int viewSizeX, int viewSizeY, int snapshotInterval)
+{
+	m_file.open(path, std::ios::binary | std::ios::trunc);
+	if (!m_file)
+	{
+		std::printf("Error can't create replay file %s\n", path);
+		return false;
+	}
+	std::memcpy(m_header.magic, ReplayMagic, sizeof(m_header.magic));
+	m_header.version = ReplayVersion;
+	m_header.seed = seed;
+	m_header.fieldSizeX = (int)m_world.GetFieldSize().x;
+	m_header.fieldSizeY = (int)m_world.GetFieldSize().y;
+	m_header.viewSizeX = viewSizeX;
+	m_header.viewSizeY = viewSizeY;
+	m_header.snapshotInterval = snapshotInterval > 0 ? (UINT32)snapshotInterval : DefaultSnapshotInterval;
+	m_file.write((const char*)&m_header, sizeof(m_header));
+	m_fileSize = sizeof(m_header);
+	m_input = &m_world.GetControllerInput();
+	m_world.SetControllerInput(this);
+	return true;
+}
+
+void ReplayRecorder::WriteChunk(ReplayChunkType type, UINT32 tick, const void* data, size_t size)
+{
+	static const char padding[8] = {};
+	ReplayChunkHeader header = { (UINT32)type, tick, size };
+	size_t paddingSize = (8 - size % 8) % 8;
+	m_file.write((const char*)&header, sizeof(header));
+	m_file.write((const char*)data, size);
+	m_file.write(padding, paddingSize);
+	m_fileSize += sizeof(header) + size + paddingSize;
+	// chunk reaches the file right away, so it survives crash of the game
+	m_file.flush();
+	if (!m_file)
+	{
+		m_isWriteFailed = true;
+	}
+}
+
+void ReplayRecorder::FlushInput()
+{
+	if (m_runs.empty())
+	{
+		return;
+	}
+	WriteChunk(RCT_Input, m_runsTick, m_runs.data(), m_runs.size() * sizeof(ReplayInputRun));
+	m_runs.clear();
+}
+
+void ReplayRecorder::WriteSnapshot()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	PlayFieldSnapshot::Save(m_world, m_snapshot);
+	m_lastSnapshotTick = m_world.GetIteration();
+	m_hasSnapshot = true;
+	WriteChunk(RCT_Snapshot, m_lastSnapshotTick, m_snapshot.data(), m_snapshot.size());
+	m_snapshotsCount++;
+	m_snapshotsSize += m_snapshot.size();
+	m_snapshotsTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void ReplayRecorder::Update()
+{
+	// input of the world is updated at the beginning of its tick, so the world is between ticks here
+	UINT32 tick = m_world.GetIteration();
+	if (!m_hasSnapshot || tick % m_header.snapshotInterval == 0)
+	{
+		// input chunk ends where snapshot begins, so replay can start reading input at any snapshot
+		FlushInput();
+		WriteSnapshot();
+	}
+	m_input->Update();
+	UINT32 buttons = (m_input->Left() ? RB_Left : 0) | (m_input->Right() ? RB_Right : 0) | (m_input->Fire() ? RB_Fire : 0);
+	if (m_runs.empty())
+	{
+		m_runsTick = tick;
+	}
+	if (!m_runs.empty() && (m_runs.back() & ReplayButtonsMask) == buttons && (m_runs.back() >> ReplayButtonBits) < ReplayMaxRunTicks)
+	{
+		m_runs.back() += 1U << ReplayButtonBits;
+	}
+	else
+	{
+		m_runs.push_back(buttons | (1U << ReplayButtonBits));
+		m_runsCount++;
+	}
+	m_ticksCount++;
+	if (tick + 1 - m_runsTick >= InputFlushTicks)
+	{
+		FlushInput();
+	}
+}
+
+void ReplayRecorder::Close()
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+	FlushInput();
+	// final state lets replay check that it has reached the same state
+	if (!m_hasSnapshot || m_lastSnapshotTick != m_world.GetIteration())
+	{
+		WriteSnapshot();
+	}
+	m_finalStateHash = PlayFieldSnapshot::Hash(m_snapshot);
+	m_file.close();
+	m_world.SetControllerInput(m_input);
+	m_input = nullptr;
+}
+
+void ReplayRecorder::WriteReport(std::ostream& out)
+{
+	char line[256];
+	std::snprintf(line, sizeof(line), "Input recording: %u ticks in %llu runs, %u snapshots (%.1f KB and %.3f ms each), %llu bytes%s\n",
+		m_ticksCount, (unsigned long long)m_runsCount, m_snapshotsCount,
+		m_snapshotsCount > 0 ? m_snapshotsSize / 1024.0 / m_snapshotsCount : 0.0,
+		m_snapshotsCount > 0 ? m_snapshotsTimeNs / 1e6 / m_snapshotsCount : 0.0,
+		(unsigned long long)m_fileSize, m_isWriteFailed ? ", WRITE FAILED" : "");
+	out << line;
+	std::snprintf(line, sizeof(line), "                 final state hash %016llx\n", (unsigned long long)m_finalStateHash);
+	out << line;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <fstream>
+#include <ostream>
+#include <vector>
+#include "Input.h"
+#include "ReplayFile.h"
+
+class PlayField;
+
+// Records input of the game into replay file (available through --recordInput cmd parameter,
+// format is described in ReplayFile.h). Recorder takes place of play field input and passes
+// buttons of the original input through, so it records exactly what the game has seen.
+// Game is deterministic given its seed and input, so buttons (packed into runs of equal ticks)
+// and snapshots of the world every snapshot interval are enough to replay it tick by tick.
+// Snapshots are taken on the game thread, before the tick they belong to is played.
+class ReplayRecorder : public Input
+{
+private:
+	PlayField& m_world;
+	Input* m_input = nullptr;
+	std::ofstream m_file;
+	ReplayHeader m_header;
+	// runs not written yet, starting at m_runsTick
+	std::vector<ReplayInputRun> m_runs;
+	UINT32 m_runsTick = 0;
+	bool m_hasSnapshot = false;
+	UINT32 m_lastSnapshotTick = 0;
+	std::vector<unsigned char> m_snapshot;
+	UINT64 m_fileSize = 0;
+	bool m_isWriteFailed = false;
+	UINT32 m_ticksCount = 0;
+	UINT64 m_runsCount = 0;
+	UINT32 m_snapshotsCount = 0;
+	UINT64 m_snapshotsSize = 0;
+	UINT64 m_snapshotsTimeNs = 0;
+	UINT64 m_finalStateHash = 0;
+	void WriteChunk(ReplayChunkType type, UINT32 tick, const void* data, size_t size);
+	void FlushInput();
+	void WriteSnapshot();
+public:
+	static const int DefaultSnapshotInterval = 1000;
+	// input is written at least this often (not only with snapshots), so crashed game loses less of it
+	static const int InputFlushTicks = 64;
+	ReplayRecorder(PlayField& world) : m_world(world) {}
+	~ReplayRecorder();
+	// creates the file and puts recorder in place of world input, false (with error printed)
+	// if file can't be created (snapshotInterval 0 - DefaultSnapshotInterval)
+	bool Open(const char* path, int seed, int viewSizeX, int viewSizeY, int snapshotInterval = DefaultSnapshotInterval);
+	bool IsOpen() { return m_input != nullptr; }
+	virtual bool Left() { return m_input->Left(); }
+	virtual bool Right() { return m_input->Right(); }
+	virtual bool Fire() { return m_input->Fire(); }
+	virtual void Update();
+	virtual INT64 GetPressTimeNs(InputKey key) { return m_input->GetPressTimeNs(key); }
+	// writes remaining input and snapshot of the final state, gives world its input back
+	void Close();
+	// ticks, runs and snapshots recorded, hash of the final state (replay has to reach the same one)
+	void WriteReport(std::ostream& out);
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include "IntTypes.h" // for UINT32
+
+class PlayFieldSnapshot;
+
+// 32-bit generational handle, slot index in lower bits and slot generation in upper bits
+typedef UINT32 ObjectHandle;
+static const ObjectHandle InvalidObjectHandle = 0;
+
+// Slot map of generational handles with O(1) Insert(...), Remove(...) and Get(...).
+// Each removal bumps generation of the slot, so handle removed once doesn't resolve anymore
+// (Get(...) returns nullptr), even after its slot has been reused by another value
+// (as long as the slot isn't reused more than GenerationMask times). Free slots are reused in
+// FIFO order (the one freed first is taken first), so that generations of all free slots wrap
+// evenly instead of the most recently freed slot wrapping fastest.
+// More than IndexMask + 1 values can't be kept, Insert(...) aborts the program then (handles
+// would point to wrong values otherwise).
+// Values are expected to be small (i.e. location of an object in dense arrays),
+// owner of dense arrays updates them with Get(...) when it relocates its elements.
+template <typename T>
+class SlotMap
+{
+	// slots (with generations) and free slots order are part of the snapshot
+	friend class PlayFieldSnapshot;
+public:
+	static const int IndexBits = 20;
+	static const UINT32 IndexMask = (1U << IndexBits) - 1;
+	static const UINT32 GenerationMask = (1U << (32 - IndexBits)) - 1;
+private:
+	typedef struct
+	{
+		UINT32 generation;
+		T value;
+	} Slot;
+	std::vector<Slot> m_slots;
+	// free slots queue is m_freeSlots from m_freeHead on (the front is dropped once it's half of it)
+	std::vector<UINT32> m_freeSlots;
+	size_t m_freeHead = 0;
+	int m_size = 0;
+public:
+	ObjectHandle Insert(const T& value)
+	{
+		UINT32 index;
+		if (m_freeHead < m_freeSlots.size())
+		{
+			index = m_freeSlots[m_freeHead++];
+			if (m_freeHead * 2 >= m_freeSlots.size())
+			{
+				m_freeSlots.erase(m_freeSlots.begin(), m_freeSlots.begin() + m_freeHead);
+				m_freeHead = 0;
+			}
+		}
+		else
+		{
+			index = (UINT32)m_slots.size();
+			if (index > IndexMask)
+			{
+				std::printf("Error too many objects (more than %u)\n", IndexMask + 1);
+				std::fflush(stdout);
+				std::abort();
+			}
+			// generation 0 is never used, so InvalidObjectHandle never resolves
+			m_slots.push_back({ 1, value });
+		}
+		m_slots[index].value = value;
+		m_size++;
+		return (m_slots[index].generation << IndexBits) | index;
+	}
+	T* Get(ObjectHandle handle)
+	{
+		UINT32 index = handle & IndexMask;
+		if (index >= m_slots.size() || m_slots[index].generation != handle >> IndexBits)
+		{
+			return nullptr;
+		}
+		return &m_slots[index].value;
+	}
+	bool Remove(ObjectHandle handle)
+	{
+		if (Get(handle) == nullptr)
+		{
+			return false;
+		}
+		UINT32 index = handle & IndexMask;
+		UINT32 generation = (m_slots[index].generation + 1) & GenerationMask;
+		m_slots[index].generation = generation == 0 ? 1 : generation;
+		m_freeSlots.push_back(index);
+		m_size--;
+		return true;
+	}
+	int GetSize() { return m_size; }
+	int GetFreeSlotsCount() { return (int)(m_freeSlots.size() - m_freeHead); }
+};
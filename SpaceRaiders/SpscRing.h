@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Lock-free single producer / single consumer ring of preallocated slots. Unlike TripleBuffer
+// nothing is dropped: producer fills slots in place (BeginPush() / EndPush()) and gets nullptr
+// when all of them are waiting for consumer, consumer takes them in order (Front() / Pop()).
+// Slots are reused, so their buffers (i.e. vectors) keep their memory between uses.
+// Capacity is rounded up to power of two.
+template <typename T>
+class SpscRing
+{
+private:
+	std::vector<T> m_slots;
+	size_t m_mask;
+	// written by consumer
+	std::atomic<size_t> m_head;
+	// written by producer
+	std::atomic<size_t> m_tail;
+public:
+	SpscRing(size_t capacity) : m_head(0), m_tail(0)
+	{
+		size_t size = 1;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+		m_slots.resize(size);
+		m_mask = size - 1;
+	}
+	size_t GetCapacity() const { return m_slots.size(); }
+	// slots can be prepared (i.e. buffers reserved) before producer and consumer start
+	T& GetSlot(size_t i) { return m_slots[i]; }
+
+	// producer side: slot to fill, nullptr if ring is full
+	T* BeginPush()
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+		{
+			return nullptr;
+		}
+		return &m_slots[tail & m_mask];
+	}
+	// makes slot returned by BeginPush() visible to consumer
+	void EndPush()
+	{
+		m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// consumer side: the oldest pushed slot, nullptr if ring is empty
+	T* Front()
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+		return &m_slots[head & m_mask];
+	}
+	// gives slot returned by Front() back to producer
+	void Pop()
+	{
+		m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+	bool IsEmpty() const { return GetCount() == 0; }
+	// slots pushed and not popped yet
+	size_t GetCount() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+};
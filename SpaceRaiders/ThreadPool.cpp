@@ -0,0 +1,89 @@
+#include "stdafx.h"
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threadsCount) : m_nextTask(0)
+{
+	if (threadsCount <= 0)
+	{
+		threadsCount = std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+	// calling thread is the first worker
+	for (int i = 1; i < threadsCount; i++)
+	{
+		m_threads.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_startCondition.notify_all();
+	for (auto& it : m_threads)
+	{
+		it.join();
+	}
+}
+
+void ThreadPool::RunTasks()
+{
+	for (int i = m_nextTask++; i < m_tasksCount; i = m_nextTask++)
+	{
+		(*m_task)(i);
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	unsigned int generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_startCondition.wait(lock, [&]() { return m_isStopping || m_generation != generation; });
+			if (m_isStopping)
+			{
+				return;
+			}
+			generation = m_generation;
+		}
+		RunTasks();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_busyThreads == 0)
+			{
+				m_doneCondition.notify_one();
+			}
+		}
+	}
+}
+
+void ThreadPool::Run(int tasksCount, const ThreadPoolTask& task)
+{
+	if (m_threads.empty() || tasksCount <= 1)
+	{
+		for (int i = 0; i < tasksCount; i++)
+		{
+			task(i);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_tasksCount = tasksCount;
+		m_nextTask = 0;
+		m_busyThreads = (int)m_threads.size();
+		m_generation++;
+	}
+	m_startCondition.notify_all();
+	RunTasks();
+	// all workers have to report back (even the ones that didn't get any task)
+	// since they may still be referencing task
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [&]() { return m_busyThreads == 0; });
+	m_task = nullptr;
+}
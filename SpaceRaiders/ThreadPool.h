@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+typedef std::function<void(int)> ThreadPoolTask;
+
+// Fixed set of worker threads which are sleeping between Run(...) calls.
+// Calling thread is also used as a worker, so pool with threadsCount == 1
+// doesn't create any thread and simply runs all tasks in order.
+class ThreadPool
+{
+private:
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_startCondition;
+	std::condition_variable m_doneCondition;
+	const ThreadPoolTask *m_task = nullptr;
+	int m_tasksCount = 0;
+	std::atomic<int> m_nextTask;
+	int m_busyThreads = 0;
+	unsigned int m_generation = 0;
+	bool m_isStopping = false;
+	void WorkerLoop();
+	void RunTasks();
+public:
+	// threadsCount <= 0 means one thread per CPU core
+	ThreadPool(int threadsCount);
+	~ThreadPool();
+	int GetThreadsCount() { return (int)m_threads.size() + 1; }
+	// invokes task(i) for each i in [0, tasksCount) and returns when all of them are done,
+	// tasks may be executed in any order and on any thread
+	void Run(int tasksCount, const ThreadPoolTask& task);
+};
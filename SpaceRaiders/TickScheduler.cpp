@@ -0,0 +1,37 @@
+#include "stdafx.h"
+#include "TickScheduler.h"
+
+void TickScheduler::Schedule(UINT32 tick, ObjectHandle handle, int type)
+{
+	m_buckets[tick % WheelSize].push_back({ tick, handle, type });
+	m_size++;
+}
+
+void TickScheduler::PopDue(UINT32 tick, std::vector<ScheduledEvent>& out)
+{
+	auto& bucket = m_buckets[tick % WheelSize];
+	// events for later rounds are kept in their order
+	size_t kept = 0;
+	for (size_t i = 0; i < bucket.size(); i++)
+	{
+		if (bucket[i].tick == tick)
+		{
+			out.push_back(bucket[i]);
+			m_size--;
+		}
+		else
+		{
+			bucket[kept++] = bucket[i];
+		}
+	}
+	bucket.resize(kept);
+}
+
+void TickScheduler::Clear()
+{
+	for (auto& bucket : m_buckets)
+	{
+		bucket.clear();
+	}
+	m_size = 0;
+}
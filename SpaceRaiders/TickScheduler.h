@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "SlotMap.h"
+
+typedef struct
+{
+	UINT32 tick;
+	ObjectHandle handle;
+	int type;
+} ScheduledEvent;
+
+// Queue of events which objects have scheduled for given iteration (tick), so that objects
+// doing something only once in a while don't have to be checked every iteration.
+// It is a timing wheel: events are kept in buckets by tick modulo WheelSize, so both
+// Schedule(...) and PopDue(...) are O(1) per event (event scheduled more than WheelSize
+// ticks ahead just stays in its bucket for more rounds).
+// Events due at the same tick are returned in the order in which they were scheduled.
+class TickScheduler
+{
+private:
+	static const int WheelSize = 1024;
+	std::vector<std::vector<ScheduledEvent>> m_buckets;
+	int m_size = 0;
+public:
+	TickScheduler() : m_buckets(WheelSize) {}
+	void Schedule(UINT32 tick, ObjectHandle handle, int type);
+	// appends all events scheduled for tick to out, PopDue(...) has to be called for each tick
+	void PopDue(UINT32 tick, std::vector<ScheduledEvent>& out);
+	int GetSize() { return m_size; }
+	void Clear();
+	// calls func(event) for each scheduled event, events of each bucket in their order
+	// (scheduling them again in this order restores the same buckets)
+	template <typename Func>
+	void ForEachEvent(Func func)
+	{
+		for (auto& bucket : m_buckets)
+		{
+			for (auto& it : bucket)
+			{
+				func(it);
+			}
+		}
+	}
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single producer / single consumer triple buffer: producer fills its back buffer
+// and publishes it (swapping it with the shared middle one), consumer takes the latest published
+// buffer (swapping its front buffer with the middle one). Neither side ever waits for the other
+// and consumer always gets the most recent data - buffers published in the meantime are dropped.
+template <typename T>
+class TripleBuffer
+{
+private:
+	static const int IndexMask = 3;
+	// set in m_middle when middle buffer has been published and not acquired yet
+	static const int NewDataBit = 4;
+	T m_buffers[3];
+	std::atomic<int> m_middle;
+	// owned by producer
+	int m_back = 0;
+	// owned by consumer
+	int m_front = 1;
+public:
+	TripleBuffer() : m_middle(2) {}
+	// producer side
+	T& GetBack() { return m_buffers[m_back]; }
+	// returns true if previously published buffer has been dropped (consumer hasn't taken it)
+	bool Publish()
+	{
+		int prev = m_middle.exchange(m_back | NewDataBit, std::memory_order_acq_rel);
+		m_back = prev & IndexMask;
+		return (prev & NewDataBit) != 0;
+	}
+	// consumer side
+	bool HasNewData() const { return (m_middle.load(std::memory_order_acquire) & NewDataBit) != 0; }
+	// makes the latest published buffer the front one, returns false if nothing new has been published
+	bool Acquire()
+	{
+		if (!HasNewData())
+		{
+			return false;
+		}
+		int prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+		m_front = prev & IndexMask;
+		return true;
+	}
+	const T& GetFront() const { return m_buffers[m_front]; }
+};
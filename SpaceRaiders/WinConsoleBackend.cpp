@@ -0,0 +1,93 @@
+#include "stdafx.h"
+
+// Windows console backend (other platforms use AnsiTerminalBackend)
+#ifdef _WIN32
+#include <cstdio>
+#include "WinConsoleBackend.h"
+
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
+ConsoleBackend* CreateConsoleBackend()
+{
+	return new WinConsoleBackend();
+}
+
+bool WinConsoleBackend::Init(int width, int height)
+{
+	m_hout = GetStdHandle(STD_OUTPUT_HANDLE);
+	// cursor positioning sequences are needed for writing only changed cells (Windows 10 and newer)
+	DWORD mode = 0;
+	m_isVirtualTerminalEnabled = GetConsoleMode(m_hout, &mode) && SetConsoleMode(m_hout, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+	// we are setting window height to height + 1 to avoid game screen jumping up and down because of 
+	// inserting last character from m_canvas to console window (then cursor moves to new line that is beyond 
+	// rendering area and when we invoke MoveCursorHome() all game screen jumps one character up)
+	
+	CONSOLE_SCREEN_BUFFER_INFO  info;
+	GetConsoleScreenBufferInfo(m_hout, &info);
+
+	//our desired buffsize and windowRect size.
+	COORD bufSize = { (SHORT)width, (SHORT)height + 1 };
+	SMALL_RECT consoleWindowRect = { 0, 0, (SHORT)width - 1, (SHORT)height };
+
+	// If the Current Buffer is Larger than what we want, Resize the 
+	// Console Window First, then the Buffer 
+	if ((DWORD)info.dwSize.X * info.dwSize.Y > (DWORD)bufSize.X * bufSize.Y)
+	{
+		if (!SetConsoleWindowInfo(m_hout, TRUE, &consoleWindowRect))
+		{
+			std::printf("Error unable to set console window size to %hux%hu\n",
+				consoleWindowRect.Right, consoleWindowRect.Bottom);
+			return false;
+		}
+
+		if (!SetConsoleScreenBufferSize(m_hout, bufSize))
+		{
+			std::printf("Error unable to set console screen buffer size to %hux%hu\n", bufSize.X, bufSize.Y);
+			return false;
+		}
+	}
+	// If the Current Buffer is Smaller than what we want, Resize the 
+	// Buffer First, then the Console Window 
+	else if ((DWORD)info.dwSize.X * info.dwSize.Y < (DWORD)bufSize.X * bufSize.Y)
+	{
+		if (!SetConsoleScreenBufferSize(m_hout, bufSize))
+		{
+			std::printf("Error unable to set console screen buffer size to %hux%hu\n", bufSize.X, bufSize.Y);
+			return false;
+		}
+		
+		if (!SetConsoleWindowInfo(m_hout, TRUE, &consoleWindowRect))
+		{
+			std::printf("Error unable to set console window size to %hux%hu\n",
+				consoleWindowRect.Right, consoleWindowRect.Bottom);
+			return false;
+		}
+	}
+	else
+	{
+		// If the Current Buffer *is* the Size we want, Don't do anything! 
+	}
+
+    return true;
+}
+
+void WinConsoleBackend::SetCursorVisibility(bool isVisible)
+{
+    CONSOLE_CURSOR_INFO info = { isVisible ? (DWORD)10 : (DWORD)100, isVisible ? TRUE : FALSE };
+    SetConsoleCursorInfo(m_hout, &info);
+}
+
+void WinConsoleBackend::MoveCursorHome()
+{
+	COORD coord = { 0, 0 };
+	SetConsoleCursorPosition(m_hout, coord);
+}
+
+void WinConsoleBackend::Write(const char* data, size_t size)
+{
+	WriteConsoleA(m_hout, data, (DWORD)size, NULL, NULL);
+}
+
+#endif
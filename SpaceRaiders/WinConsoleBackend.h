@@ -0,0 +1,18 @@
+#pragma once
+
+#include <Windows.h>
+#include "ConsoleBackend.h"
+
+// Windows console, VT sequences are enabled if console supports them (Windows 10 and newer)
+class WinConsoleBackend : public ConsoleBackend
+{
+private:
+	HANDLE m_hout = INVALID_HANDLE_VALUE;
+	bool m_isVirtualTerminalEnabled = false;
+public:
+	virtual bool Init(int width, int height);
+	virtual bool IsVirtualTerminal() { return m_isVirtualTerminalEnabled; }
+	virtual void MoveCursorHome();
+	virtual void Write(const char* data, size_t size);
+	virtual void SetCursorVisibility(bool isVisible);
+};
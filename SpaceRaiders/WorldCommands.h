@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "GameObjects.h"
+
+typedef enum
+{
+	WC_AddObject = 0,
+	WC_FireLasers,
+	WC_DespawnLaser,
+	WC_RemoveObject,
+	WC_GameOver
+} WorldCommandType;
+
+typedef struct
+{
+	WorldCommandType type;
+	GameObject *obj;
+	RaiderObjectTypeId laserType;
+	int count;
+} WorldCommand;
+
+// Game objects are updated in parallel, so during Update(...) they are not allowed
+// to change PlayField state (objects collection, lasers counters, game over flag).
+// Instead, they are recording such changes as commands which are applied by PlayField
+// after all objects have been updated, in the same order in which objects were updated
+// (so that result doesn't depend on number of threads).
+class WorldCommands
+{
+private:
+	std::vector<WorldCommand> m_commands;
+public:
+	void Clear() { m_commands.clear(); }
+	const std::vector<WorldCommand>& GetCommands() { return m_commands; }
+	void AddObject(GameObject* newObj) { m_commands.push_back({ WC_AddObject, newObj, RI_End, 0 }); }
+	// shooter FireLasers(...) is invoked only if there is still room for count lasers of laserType
+	void FireLasers(SpaceShip* shooter, RaiderObjectTypeId laserType, int count)
+	{
+		m_commands.push_back({ WC_FireLasers, shooter, laserType, count });
+	}
+	void DespawnLaser(GameObject* laser) { m_commands.push_back({ WC_DespawnLaser, laser, RI_End, 0 }); }
+	// object has to be set to inactive by the caller (see PlayField::RemoveObject(...))
+	void RemoveObject(GameObject* obj) { m_commands.push_back({ WC_RemoveObject, obj, RI_End, 0 }); }
+	void NotifyGameOver() { m_commands.push_back({ WC_GameOver, nullptr, RI_End, 0 }); }
+};